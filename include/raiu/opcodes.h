@@ -241,7 +241,86 @@
 #define OP_SYSCALL (u8) 0xd7
 #define OP_RET     (u8) 0xd8
 
-#define OP_MAX_OPCODE (OP_RET)
+// superinstructions, emitted only by the linker
+#define OP_LOAD_GLOB_WORD  (u8) 0xd9
+#define OP_LOAD_GLOB_DWORD (u8) 0xda
+#define OP_PUSH_WORD_WORD  (u8) 0xdb
+#define OP_ADD_I32_LOC_IMM (u8) 0xdc
+#define OP_ADD_I32_LOC_LOC (u8) 0xdd
+#define OP_JMP_WORD_EQ     (u8) 0xde
+#define OP_JMP_WORD_NE     (u8) 0xdf
+#define OP_JMP_I32_GT      (u8) 0xe0
+#define OP_JMP_I32_LT      (u8) 0xe1
+#define OP_JMP_I32_GE      (u8) 0xe2
+#define OP_JMP_I32_LE      (u8) 0xe3
+
+// quickened calls, emitted only by the linker after the validation
+#define OP_CALL_FUNC (u8) 0xe4
+#define OP_CALL_LEAF (u8) 0xe5
+#define OP_RET_LEAF  (u8) 0xe6
+
+// math and memory functions, the linker also rewrites the system calls with the same effect into them
+#define OP_SQRT_F32 (u8) 0xe7
+#define OP_SQRT_F64 (u8) 0xe8
+#define OP_EXP_F32  (u8) 0xe9
+#define OP_EXP_F64  (u8) 0xea
+#define OP_LOG_F32  (u8) 0xeb
+#define OP_LOG_F64  (u8) 0xec
+#define OP_MEMMOV   (u8) 0xed
+#define OP_MEMCPY   (u8) 0xee
+
+// calls that reuse the frame of the caller, they are always followed by a RET and the linker rewrites CALL RET into them
+#define OP_TAILCALL    (u8) 0xef
+#define OP_INDTAILCALL (u8) 0xf0
+
+// generators, GEN_NEW pops the arguments of a function and pushes a reference to a new generator of it, the program 
+// frees it with FREE. RESUME runs the generator until it yields or returns and pushes the values of the function followed
+// by a word that is 1 if it has yielded them, YIELD suspends the generator with the values on top of its stack
+#define OP_GEN_NEW (u8) 0xf1
+#define OP_RESUME  (u8) 0xf2
+#define OP_YIELD   (u8) 0xf3
+// the return of a generator, it is in the generator and never in a body
+#define OP_GEN_RETURN (u8) 0xf4
+
+// the ref of a thread-local global, the pool holds its offset in the copy of the running thread, emitted only by the 
+// linker in place of the PUSH_GLOB_REF of the thread-local globals
+#define OP_PUSH_TLS_REF   (u8) 0xf5
+#define OP_PUSH_TLS_REF_W (u8) 0xf6
+
+#define OP_MAX_OPCODE (OP_PUSH_TLS_REF_W)
+
+// prefix of the extended page, the byte after it is the opcode of a less frequent instruction and its parameters follow
+#define OP_EXTENDED (u8) 0xff
+
+// extended page, bit counts of the integers, the results are words
+#define OP_EXT_POPCNT_I32 (u8) 0x00
+#define OP_EXT_POPCNT_I64 (u8) 0x01
+#define OP_EXT_CLZ_I32    (u8) 0x02
+#define OP_EXT_CLZ_I64    (u8) 0x03
+#define OP_EXT_CTZ_I32    (u8) 0x04
+#define OP_EXT_CTZ_I64    (u8) 0x05
+
+// extended page, sequentially consistent atomics on the word or dword a ref points to, the read-modify-write ones push
+// the value before the change and a compare and swap pushes it too, it has swapped if it is the expected one
+#define OP_EXT_ATOMIC_LOAD_WORD   (u8) 0x06
+#define OP_EXT_ATOMIC_LOAD_DWORD  (u8) 0x07
+#define OP_EXT_ATOMIC_STORE_WORD  (u8) 0x08
+#define OP_EXT_ATOMIC_STORE_DWORD (u8) 0x09
+#define OP_EXT_CAS_WORD           (u8) 0x0A
+#define OP_EXT_CAS_DWORD          (u8) 0x0B
+#define OP_EXT_FETCH_ADD_WORD     (u8) 0x0C
+#define OP_EXT_FETCH_ADD_DWORD    (u8) 0x0D
+#define OP_EXT_FETCH_SUB_WORD     (u8) 0x0E
+#define OP_EXT_FETCH_SUB_DWORD    (u8) 0x0F
+#define OP_EXT_FETCH_AND_WORD     (u8) 0x10
+#define OP_EXT_FETCH_AND_DWORD    (u8) 0x11
+#define OP_EXT_FETCH_OR_WORD      (u8) 0x12
+#define OP_EXT_FETCH_OR_DWORD     (u8) 0x13
+#define OP_EXT_FETCH_XOR_WORD     (u8) 0x14
+#define OP_EXT_FETCH_XOR_DWORD    (u8) 0x15
+#define OP_EXT_FENCE              (u8) 0x16
+
+#define OP_EXT_MAX_OPCODE (OP_EXT_FENCE)
 
 #define OP_SYS_EXIT   (u8) 0x00
 #define OP_SYS_PRINT  (u8) 0x01
@@ -261,7 +340,15 @@
 #define OP_SYS_LOG32  (u8) 0x0E
 #define OP_SYS_LOG64  (u8) 0x0F
 
-#define OP_SYS_MAX_OPCODE (OP_SYS_LOG64)
+// green threads, run only by the stack interpreter under the scheduler
+#define OP_SYS_SPAWN  (u8) 0x10
+#define OP_SYS_JOIN   (u8) 0x11
+#define OP_SYS_YIELD  (u8) 0x12
+
+// parallel loop, run by the stack interpreter on a pool of OS threads
+#define OP_SYS_PARFOR (u8) 0x13
+
+#define OP_SYS_MAX_OPCODE (OP_SYS_PARFOR)
 
 
 
@@ -0,0 +1,547 @@
+#include <stdio.h>
+#include <dirent.h>
+#include <raiu/raiu.h>
+#include <sys/stat.h>
+
+#define POOL_SIZE(pool) (u16)(sizeof(pool) / sizeof(*(pool)))
+
+/*
+    Writes a module with no globals, every body starts with its AWC, LWC, SWC and RWC and bodySizes holds the sizes of
+    the bodies with these 8 bytes
+*/
+static i32 iWriteModule(const char *path, const Word *words, u16 wordCount, const DWord *dwords, u16 dwordCount,
+                        const ch8 *const *strings, u16 stringCount, const ch8 *const *functions, u16 functionCount,
+                        const Byte *const *bodies, const u32 *bodySizes)
+{
+    FILE *file = fopen(path, "wb");
+    if(!file)
+    {
+        perror("Error creating file");
+        return -1;
+    }
+
+    fwrite(&wordCount, 2, 1, file);
+    fwrite(words, wordCount, 4, file);
+
+    fwrite(&dwordCount, 2, 1, file);
+    fwrite(dwords, dwordCount, 8, file);
+
+    fwrite(&stringCount, 2, 1, file);
+    for (u16 i = 0; i < stringCount; i++)
+        fwrite(strings[i], strlen(strings[i]) + 1, 1, file);
+
+    const u16 globalCount = 0;
+    fwrite(&globalCount, 2, 1, file);
+
+    fwrite(&functionCount, 2, 1, file);
+    for (u16 i = 0; i < functionCount; i++)
+        fwrite(functions[i], strlen(functions[i]) + 1, 1, file);
+
+    for (u16 i = 0; i < functionCount; i++)
+    {
+        const u32 bodySize = bodySizes[i] - 8;
+        fwrite(&bodySize, 4, 1, file);
+        fwrite(bodies[i], bodySize + 8, 1, file);
+    }
+
+    fclose(file);
+    return 0;
+}
+
+static i32 iCreateBenchProject(const char *root)
+{
+
+    /*
+        Root -> Main
+        Main computes Fib(32) recursively and then runs an arithmetic loop, the time of the two engines can be
+        compared with "rvm BenchProject" and "rvm --register BenchProject"
+    */
+
+    String rootPath, mainPath;
+    String_Create(&rootPath, root);
+    String_Create(&mainPath, root); String_ConcatStr(&mainPath, "/Main");
+
+    mkdir(String_CStr(&rootPath), 0700);
+
+    // Main
+    i32 error;
+    {
+        const Word WORD_POOL[] = { IntToWord(32), IntToWord(50000000) };
+        const DWord DWORD_POOL[] = { };
+        const ch8 *STRING_POOL[] = { "\n" };
+        const ch8 *FUNCTION_POOL[] = { "Main", "Fib" };
+        const Byte MAIN_BODY[] =
+        {
+            { 0 }, { 0 },
+            { 2 }, { 0 },
+            { 4 }, { 0 },
+            { 0 }, { 0 },
+            { OP_PUSH_CONST_WORD }, { 0 },
+            { OP_CALL }, { 1 }, { 0 },
+            { OP_I32_TO_I64 },
+            { OP_SYSCALL }, { OP_SYS_PRINTI },
+            { OP_PUSH_CONST_STR }, { 0 },
+            { OP_SYSCALL }, { OP_SYS_PRINT },
+            { OP_PUSH_0_WORD },
+            { OP_POP_WORD_0 },
+            { OP_PUSH_0_WORD },
+            { OP_POP_WORD_1 },
+            // loop :
+            { OP_PUSH_WORD_0 },
+            { OP_PUSH_CONST_WORD }, { 1 },
+            { OP_CMP_I32_LT },
+            { OP_CMP_NOT },
+            { OP_JMP_IF }, { 14 }, { 0 }, // to end
+            { OP_PUSH_WORD_1 },
+            { OP_PUSH_WORD_0 },
+            { OP_PUSH_WORD_0 },
+            { OP_MUL_I32 },
+            { OP_XOR_WORD },
+            { OP_PUSH_WORD_0 },
+            { OP_ADD_I32 },
+            { OP_POP_WORD_1 },
+            { OP_INC_I32 }, { 0 }, { 1 },
+            { OP_JMP }, { (u8)-22 }, { (u8)(-22 >> 8) }, // to loop
+            // end :
+            { OP_PUSH_WORD_1 },
+            { OP_I32_TO_I64 },
+            { OP_SYSCALL }, { OP_SYS_PRINTI },
+            { OP_PUSH_CONST_STR }, { 0 },
+            { OP_SYSCALL }, { OP_SYS_PRINT },
+            { OP_PUSH_0_WORD },
+            { OP_SYSCALL }, { OP_SYS_EXIT }
+        };
+        const Byte FIB_BODY[] =
+        {
+            { 1 }, { 0 },
+            { 1 }, { 0 },
+            { 3 }, { 0 },
+            { 1 }, { 0 },
+            { OP_PUSH_WORD_0 },
+            { OP_PUSH_I32_2 },
+            { OP_CMP_I32_LT },
+            { OP_JMP_IF }, { 14 }, { 0 }, // to base
+            { OP_PUSH_WORD_0 },
+            { OP_PUSH_I32_1 },
+            { OP_SUB_I32 },
+            { OP_CALL }, { 1 }, { 0 },
+            { OP_PUSH_WORD_0 },
+            { OP_PUSH_I32_2 },
+            { OP_SUB_I32 },
+            { OP_CALL }, { 1 }, { 0 },
+            { OP_ADD_I32 },
+            { OP_RET },
+            // base :
+            { OP_PUSH_WORD_0 },
+            { OP_RET }
+        };
+        const Byte *BODIES[]   = { MAIN_BODY, FIB_BODY };
+        const u32 BODY_SIZES[] = { sizeof(MAIN_BODY), sizeof(FIB_BODY) };
+        error = iWriteModule(String_CStr(&mainPath), WORD_POOL, POOL_SIZE(WORD_POOL), DWORD_POOL, POOL_SIZE(DWORD_POOL),
+                             STRING_POOL, POOL_SIZE(STRING_POOL), FUNCTION_POOL, POOL_SIZE(FUNCTION_POOL), BODIES, BODY_SIZES);
+    }
+
+    String_Destroy(&rootPath);
+    String_Destroy(&mainPath);
+    return error;
+}
+static i32 iCreateSumProject(const char *root)
+{
+
+    /*
+        Root -> Main
+        Main computes Sum(130000) = 130000 + Sum(129999) 300 times, the recursion is not a tail call so every level 
+        pushes a frame, the time of a frame layout can be measured with "rvm SumProject" and the maximum depth with a
+        smaller --stack-max
+    */
+
+    String rootPath, mainPath;
+    String_Create(&rootPath, root);
+    String_Create(&mainPath, root); String_ConcatStr(&mainPath, "/Main");
+
+    mkdir(String_CStr(&rootPath), 0700);
+
+    // Main
+    i32 error;
+    {
+        const Word WORD_POOL[] = { IntToWord(130000), IntToWord(300) };
+        const DWord DWORD_POOL[] = { };
+        const ch8 *STRING_POOL[] = { "\n" };
+        const ch8 *FUNCTION_POOL[] = { "Main", "Sum" };
+        const Byte MAIN_BODY[] =
+        {
+            { 0 }, { 0 },
+            { 2 }, { 0 },
+            { 4 }, { 0 },
+            { 0 }, { 0 },
+            { OP_PUSH_0_WORD },
+            { OP_POP_WORD_0 },
+            // loop :
+            { OP_PUSH_WORD_0 },
+            { OP_PUSH_CONST_WORD }, { 1 },
+            { OP_CMP_I32_LT },
+            { OP_CMP_NOT },
+            { OP_JMP_IF }, { 12 }, { 0 }, // to end
+            { OP_PUSH_CONST_WORD }, { 0 },
+            { OP_CALL }, { 1 }, { 0 },
+            { OP_POP_WORD_1 },
+            { OP_INC_I32 }, { 0 }, { 1 },
+            { OP_JMP }, { (u8)-20 }, { (u8)(-20 >> 8) }, // to loop
+            // end :
+            { OP_PUSH_WORD_1 },
+            { OP_I32_TO_I64 },
+            { OP_SYSCALL }, { OP_SYS_PRINTI },
+            { OP_PUSH_CONST_STR }, { 0 },
+            { OP_SYSCALL }, { OP_SYS_PRINT },
+            { OP_PUSH_0_WORD },
+            { OP_SYSCALL }, { OP_SYS_EXIT }
+        };
+        const Byte SUM_BODY[] =
+        {
+            { 1 }, { 0 },
+            { 1 }, { 0 },
+            { 3 }, { 0 },
+            { 1 }, { 0 },
+            { OP_PUSH_WORD_0 },
+            { OP_PUSH_0_WORD },
+            { OP_CMP_WORD_EQ },
+            { OP_JMP_IF }, { 9 }, { 0 }, // to base
+            { OP_PUSH_WORD_0 },
+            { OP_PUSH_WORD_0 },
+            { OP_PUSH_I32_1 },
+            { OP_SUB_I32 },
+            { OP_CALL }, { 1 }, { 0 },
+            { OP_ADD_I32 },
+            { OP_RET },
+            // base :
+            { OP_PUSH_0_WORD },
+            { OP_RET }
+        };
+        const Byte *BODIES[]   = { MAIN_BODY, SUM_BODY };
+        const u32 BODY_SIZES[] = { sizeof(MAIN_BODY), sizeof(SUM_BODY) };
+        error = iWriteModule(String_CStr(&mainPath), WORD_POOL, POOL_SIZE(WORD_POOL), DWORD_POOL, POOL_SIZE(DWORD_POOL),
+                             STRING_POOL, POOL_SIZE(STRING_POOL), FUNCTION_POOL, POOL_SIZE(FUNCTION_POOL), BODIES, BODY_SIZES);
+    }
+
+    String_Destroy(&rootPath);
+    String_Destroy(&mainPath);
+    return error;
+}
+static i32 iCreateMixProject(const char *root)
+{
+
+    /*
+        Root -> Main
+        Main calls Mix(1000) 100000 times, Mix keeps an i64 accumulator in the locals 1 and 2, the time of the aligned
+        frames can be compared with "rvm MixProject" and "rvm --aligned MixProject". The padding of --aligned aligns
+        only the frame base, so the accumulator at the odd local 1 stays misaligned in both
+    */
+
+    String rootPath, mainPath;
+    String_Create(&rootPath, root);
+    String_Create(&mainPath, root); String_ConcatStr(&mainPath, "/Main");
+
+    mkdir(String_CStr(&rootPath), 0700);
+
+    // Main
+    i32 error;
+    {
+        const Word WORD_POOL[] = { IntToWord(1000), IntToWord(100000) };
+        const DWord DWORD_POOL[] = { };
+        const ch8 *STRING_POOL[] = { };
+        const ch8 *FUNCTION_POOL[] = { "Main", "Mix" };
+        const Byte MAIN_BODY[] =
+        {
+            { 0 }, { 0 },
+            { 2 }, { 0 },
+            { 4 }, { 0 },
+            { 0 }, { 0 },
+            { OP_PUSH_0_WORD },
+            { OP_POP_WORD_0 },
+            { OP_PUSH_0_WORD },
+            { OP_POP_WORD_1 },
+            // loop :
+            { OP_PUSH_WORD_0 },
+            { OP_PUSH_CONST_WORD }, { 1 },
+            { OP_CMP_I32_LT },
+            { OP_CMP_NOT },
+            { OP_JMP_IF }, { 15 }, { 0 }, // to end
+            { OP_PUSH_CONST_WORD }, { 0 },
+            { OP_CALL }, { 1 }, { 0 },
+            { OP_I64_TO_I32 },
+            { OP_PUSH_WORD_1 },
+            { OP_XOR_WORD },
+            { OP_POP_WORD_1 },
+            { OP_INC_I32 }, { 0 }, { 1 },
+            { OP_JMP }, { (u8)-23 }, { (u8)(-23 >> 8) }, // to loop
+            // end :
+            { OP_PUSH_WORD_1 },
+            { OP_I32_TO_I64 },
+            { OP_SYSCALL }, { OP_SYS_PRINTI },
+            { OP_PUSH_0_WORD },
+            { OP_SYSCALL }, { OP_SYS_EXIT }
+        };
+        const Byte MIX_BODY[] =
+        {
+            { 1 }, { 0 },
+            { 3 }, { 0 },
+            { 6 }, { 0 },
+            { 2 }, { 0 },
+            { OP_PUSH_0_DWORD },
+            { OP_POP_DWORD_1 },
+            // loop :
+            { OP_PUSH_WORD_0 },
+            { OP_PUSH_0_WORD },
+            { OP_CMP_WORD_EQ },
+            { OP_JMP_IF }, { 16 }, { 0 }, // to end
+            { OP_PUSH_DWORD_1 },
+            { OP_PUSH_WORD_0 },
+            { OP_I32_TO_I64 },
+            { OP_PUSH_DWORD_1 },
+            { OP_MUL_I64 },
+            { OP_ADD_I64 },
+            { OP_PUSH_WORD_0 },
+            { OP_I32_TO_I64 },
+            { OP_XOR_DWORD },
+            { OP_POP_DWORD_1 },
+            { OP_DEC_I32 }, { 0 }, { 1 },
+            { OP_JMP }, { (u8)-22 }, { (u8)(-22 >> 8) }, // to loop
+            // end :
+            { OP_PUSH_DWORD_1 },
+            { OP_RET }
+        };
+        const Byte *BODIES[]   = { MAIN_BODY, MIX_BODY };
+        const u32 BODY_SIZES[] = { sizeof(MAIN_BODY), sizeof(MIX_BODY) };
+        error = iWriteModule(String_CStr(&mainPath), WORD_POOL, POOL_SIZE(WORD_POOL), DWORD_POOL, POOL_SIZE(DWORD_POOL),
+                             STRING_POOL, POOL_SIZE(STRING_POOL), FUNCTION_POOL, POOL_SIZE(FUNCTION_POOL), BODIES, BODY_SIZES);
+    }
+
+    String_Destroy(&rootPath);
+    String_Destroy(&mainPath);
+    return error;
+}
+static i32 iCreateFibProject(const char *root)
+{
+
+    /*
+        Root -> Main
+        Main prints Fib(30) computed recursively and then calls the leaf Sq(i) = i * i + 1 for i up to 10000000, the
+        calls and returns of the engines can be compared with "rvm --threaded FibProject" in the computed goto and the
+        tail calling builds of the threaded handlers
+    */
+
+    String rootPath, mainPath;
+    String_Create(&rootPath, root);
+    String_Create(&mainPath, root); String_ConcatStr(&mainPath, "/Main");
+
+    mkdir(String_CStr(&rootPath), 0700);
+
+    // Main
+    i32 error;
+    {
+        const Word WORD_POOL[] = { IntToWord(30), IntToWord(10000000) };
+        const DWord DWORD_POOL[] = { };
+        const ch8 *STRING_POOL[] = { };
+        const ch8 *FUNCTION_POOL[] = { "Main", "Fib", "Sq" };
+        const Byte MAIN_BODY[] =
+        {
+            { 0 }, { 0 },
+            { 2 }, { 0 },
+            { 4 }, { 0 },
+            { 0 }, { 0 },
+            { OP_PUSH_CONST_WORD }, { 0 },
+            { OP_CALL }, { 1 }, { 0 },
+            { OP_I32_TO_I64 },
+            { OP_SYSCALL }, { OP_SYS_PRINTI },
+            { OP_PUSH_0_WORD },
+            { OP_POP_WORD_0 },
+            // loop :
+            { OP_PUSH_WORD_0 },
+            { OP_PUSH_CONST_WORD }, { 1 },
+            { OP_CMP_I32_LT },
+            { OP_CMP_NOT },
+            { OP_JMP_IF }, { 11 }, { 0 }, // to end
+            { OP_PUSH_WORD_0 },
+            { OP_CALL }, { 2 }, { 0 },
+            { OP_POP_WORD_1 },
+            { OP_INC_I32 }, { 0 }, { 1 },
+            { OP_JMP }, { (u8)-19 }, { (u8)(-19 >> 8) }, // to loop
+            // end :
+            { OP_PUSH_WORD_1 },
+            { OP_I32_TO_I64 },
+            { OP_SYSCALL }, { OP_SYS_PRINTI },
+            { OP_PUSH_0_WORD },
+            { OP_SYSCALL }, { OP_SYS_EXIT }
+        };
+        const Byte FIB_BODY[] =
+        {
+            { 1 }, { 0 },
+            { 1 }, { 0 },
+            { 3 }, { 0 },
+            { 1 }, { 0 },
+            { OP_PUSH_WORD_0 },
+            { OP_PUSH_I32_2 },
+            { OP_CMP_I32_LT },
+            { OP_JMP_IF }, { 14 }, { 0 }, // to base
+            { OP_PUSH_WORD_0 },
+            { OP_PUSH_I32_1 },
+            { OP_SUB_I32 },
+            { OP_CALL }, { 1 }, { 0 },
+            { OP_PUSH_WORD_0 },
+            { OP_PUSH_I32_2 },
+            { OP_SUB_I32 },
+            { OP_CALL }, { 1 }, { 0 },
+            { OP_ADD_I32 },
+            { OP_RET },
+            // base :
+            { OP_PUSH_WORD_0 },
+            { OP_RET }
+        };
+        const Byte SQ_BODY[] =
+        {
+            { 1 }, { 0 },
+            { 1 }, { 0 },
+            { 3 }, { 0 },
+            { 1 }, { 0 },
+            { OP_PUSH_WORD_0 },
+            { OP_PUSH_WORD_0 },
+            { OP_MUL_I32 },
+            { OP_PUSH_I32_1 },
+            { OP_ADD_I32 },
+            { OP_RET }
+        };
+        const Byte *BODIES[]   = { MAIN_BODY, FIB_BODY, SQ_BODY };
+        const u32 BODY_SIZES[] = { sizeof(MAIN_BODY), sizeof(FIB_BODY), sizeof(SQ_BODY) };
+        error = iWriteModule(String_CStr(&mainPath), WORD_POOL, POOL_SIZE(WORD_POOL), DWORD_POOL, POOL_SIZE(DWORD_POOL),
+                             STRING_POOL, POOL_SIZE(STRING_POOL), FUNCTION_POOL, POOL_SIZE(FUNCTION_POOL), BODIES, BODY_SIZES);
+    }
+
+    String_Destroy(&rootPath);
+    String_Destroy(&mainPath);
+    return error;
+}
+static i32 iCreateMathProject(const char *root)
+{
+
+    /*
+        Root -> Main
+        Main sums the square roots, logarithms and exponentials of the indices up to 5000000 in f64 and f32 and prints
+        Norm(3, 4), the math opcodes of the engines can be compared with "rvm --threaded MathProject" in the computed
+        goto and the tail calling builds of the threaded handlers
+    */
+
+    String rootPath, mainPath;
+    String_Create(&rootPath, root);
+    String_Create(&mainPath, root); String_ConcatStr(&mainPath, "/Main");
+
+    mkdir(String_CStr(&rootPath), 0700);
+
+    // Main
+    i32 error;
+    {
+        const Word WORD_POOL[] = { IntToWord(5000000) };
+        const DWord DWORD_POOL[] = { FloatToDWord(3.0), FloatToDWord(4.0) };
+        const ch8 *STRING_POOL[] = { "\n" };
+        const ch8 *FUNCTION_POOL[] = { "Main", "Norm" };
+        const Byte MAIN_BODY[] =
+        {
+            { 0 }, { 0 },
+            { 4 }, { 0 },
+            { 8 }, { 0 },
+            { 0 }, { 0 },
+            { OP_PUSH_0_WORD },
+            { OP_POP_WORD_0 },
+            { OP_PUSH_0_DWORD },
+            { OP_POP_DWORD_1 },
+            { OP_PUSH_0_WORD },
+            { OP_POP_WORD_3 },
+            // loop :
+            { OP_PUSH_WORD_0 },
+            { OP_PUSH_CONST_WORD }, { 0 },
+            { OP_CMP_I32_LT },
+            { OP_CMP_NOT },
+            { OP_JMP_IF }, { 42 }, { 0 }, // to end
+            { OP_PUSH_DWORD_1 },
+            { OP_PUSH_WORD_0 },
+            { OP_I32_TO_F64 },
+            { OP_SYSCALL }, { OP_SYS_SQRT64 },
+            { OP_ADD_F64 },
+            { OP_PUSH_WORD_0 },
+            { OP_PUSH_I32_1 },
+            { OP_ADD_I32 },
+            { OP_I32_TO_F64 },
+            { OP_SYSCALL }, { OP_SYS_LOG64 },
+            { OP_ADD_F64 },
+            { OP_PUSH_F64_1 },
+            { OP_SYSCALL }, { OP_SYS_EXP64 },
+            { OP_ADD_F64 },
+            { OP_POP_DWORD_1 },
+            { OP_PUSH_WORD_3 },
+            { OP_PUSH_WORD_0 },
+            { OP_I32_TO_F32 },
+            { OP_SYSCALL }, { OP_SYS_SQRT32 },
+            { OP_ADD_F32 },
+            { OP_PUSH_WORD_0 },
+            { OP_PUSH_I32_1 },
+            { OP_ADD_I32 },
+            { OP_I32_TO_F32 },
+            { OP_SYSCALL }, { OP_SYS_LOG32 },
+            { OP_ADD_F32 },
+            { OP_PUSH_F32_1 },
+            { OP_SYSCALL }, { OP_SYS_EXP32 },
+            { OP_ADD_F32 },
+            { OP_POP_WORD_3 },
+            { OP_INC_I32 }, { 0 }, { 1 },
+            { OP_JMP }, { (u8)-50 }, { (u8)(-50 >> 8) }, // to loop
+            // end :
+            { OP_PUSH_DWORD_1 },
+            { OP_SYSCALL }, { OP_SYS_PRINTF },
+            { OP_PUSH_CONST_STR }, { 0 },
+            { OP_SYSCALL }, { OP_SYS_PRINT },
+            { OP_PUSH_WORD_3 },
+            { OP_F32_TO_F64 },
+            { OP_SYSCALL }, { OP_SYS_PRINTF },
+            { OP_PUSH_CONST_STR }, { 0 },
+            { OP_SYSCALL }, { OP_SYS_PRINT },
+            { OP_PUSH_CONST_DWORD }, { 0 },
+            { OP_PUSH_CONST_DWORD }, { 1 },
+            { OP_CALL }, { 1 }, { 0 },
+            { OP_SYSCALL }, { OP_SYS_PRINTF },
+            { OP_PUSH_CONST_STR }, { 0 },
+            { OP_SYSCALL }, { OP_SYS_PRINT },
+            { OP_PUSH_0_WORD },
+            { OP_SYSCALL }, { OP_SYS_EXIT }
+        };
+        const Byte NORM_BODY[] =
+        {
+            { 4 }, { 0 },
+            { 4 }, { 0 },
+            { 6 }, { 0 },
+            { 2 }, { 0 },
+            { OP_PUSH_DWORD_0 },
+            { OP_PUSH_DWORD_0 },
+            { OP_MUL_F64 },
+            { OP_PUSH_DWORD_2 },
+            { OP_PUSH_DWORD_2 },
+            { OP_MUL_F64 },
+            { OP_ADD_F64 },
+            { OP_SYSCALL }, { OP_SYS_SQRT64 },
+            { OP_RET }
+        };
+        const Byte *BODIES[]   = { MAIN_BODY, NORM_BODY };
+        const u32 BODY_SIZES[] = { sizeof(MAIN_BODY), sizeof(NORM_BODY) };
+        error = iWriteModule(String_CStr(&mainPath), WORD_POOL, POOL_SIZE(WORD_POOL), DWORD_POOL, POOL_SIZE(DWORD_POOL),
+                             STRING_POOL, POOL_SIZE(STRING_POOL), FUNCTION_POOL, POOL_SIZE(FUNCTION_POOL), BODIES, BODY_SIZES);
+    }
+
+    String_Destroy(&rootPath);
+    String_Destroy(&mainPath);
+    return error;
+}
+int main()
+{
+    if(iCreateBenchProject("BenchProject") || iCreateSumProject("SumProject") || iCreateMixProject("MixProject") ||
+       iCreateFibProject("FibProject"))
+        return -1;
+    return iCreateMathProject("MathProject");
+}
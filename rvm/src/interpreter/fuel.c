@@ -0,0 +1,6 @@
+/*
+    The fueled variant of the stack interpreter, it is the same code of interpreter.c compiled with the fuel checks.
+    Keeping it in its own function leaves Execute without them, so a program that runs with no fuel budget pays nothing.
+*/
+#define EXECUTE_FUEL
+#include "interpreter.c"
@@ -8,40 +8,9 @@
 #include "raiu/raiu.h"
 #include "metadata.h"
 #include "rvm.h"
+#include "interpreter.h"
 
 
-#define PC_OFFSET 0
-#define FP_OFFSET 2
-#define FH_OFFSET 4
-#define LOCALS_OFFSET 6
-
-static inline u8 iNextU8(Byte **pc)  
-{ 
-    u8 v = (*pc)->UInt; 
-    *pc += 1; 
-    return v; 
-}
-static inline u8 iNextU16(Byte **pc) 
-{ 
-    u16 v = ((*pc + 0)->UInt << 0)| 
-            ((*pc + 1)->UInt << 8); 
-    *pc += 2; 
-    return v; 
-}
-static inline i8 iNextI8(Byte **pc)  
-{ 
-    i8 v = (*pc)->UInt; 
-    *pc += 1; 
-    return v; 
-}
-static inline i8 iNextI16(Byte **pc) 
-{ 
-    i16 v = ((*pc + 0)->UInt << 0)| 
-            ((*pc + 1)->UInt << 8); 
-    *pc += 2; 
-    return v; 
-}
-
 #pragma region Push
 
 #define LOCAL_PUSH_BYTE(sp, fp, l, b) do { \
@@ -178,6 +147,206 @@ static inline i8 iNextI16(Byte **pc)
     loc.type = loc.type operator v; \
     *(DWord*)(fp + LOCALS_OFFSET + l) = loc; \
 } while(0)
+// replaces the integer on top of the stack with a count of its bits, the expression reads the value as v
+#define BIT_COUNT_WORD(sp, count) do \
+{ \
+    u32 v = (sp - 1)->UInt; \
+    (sp - 1)->UInt = (u32)(count); \
+} while(0)
+#define BIT_COUNT_DWORD(sp, count) do \
+{ \
+    u64 v = ((DWord*)(sp - 2))->UInt; \
+    (sp - 2)->UInt = (u32)(count); \
+    sp -= 1; \
+} while(0)
+#pragma endregion
+#pragma region Atomics
+// the atomics take the ref under their operands like the loads and stores, the builtins compile to the locked 
+// instructions of the target, a fetch and, or or xor whose old value is used compiles to a compare and swap loop
+#define ATOMIC_LOAD(sp, type, words) do \
+{ \
+    type *ref = ((DWord*)(sp - 2))->Ptr; \
+    *(type*)(sp - 2) = __atomic_load_n(ref, __ATOMIC_SEQ_CST); \
+    sp += (words) - 2; \
+} while(0)
+#define ATOMIC_STORE(sp, type, words) do \
+{ \
+    type *ref = ((DWord*)(sp - 2 - (words)))->Ptr; \
+    __atomic_store_n(ref, *(type*)(sp - (words)), __ATOMIC_SEQ_CST); \
+    sp -= 2 + (words); \
+} while(0)
+#define ATOMIC_CAS(sp, type, words) do \
+{ \
+    type *ref = ((DWord*)(sp - 2 - 2 * (words)))->Ptr; \
+    type expected = *(type*)(sp - 2 * (words)); \
+    __atomic_compare_exchange_n(ref, &expected, *(type*)(sp - (words)), false, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST); \
+    *(type*)(sp - 2 - 2 * (words)) = expected; \
+    sp -= 2 + (words); \
+} while(0)
+#define ATOMIC_FETCH(sp, type, words, builtin) do \
+{ \
+    type *ref = ((DWord*)(sp - 2 - (words)))->Ptr; \
+    *(type*)(sp - 2 - (words)) = builtin(ref, *(type*)(sp - (words)), __ATOMIC_SEQ_CST); \
+    sp -= 2; \
+} while(0)
+#pragma endregion
+#pragma region Fuel
+/*
+    The fueled variant of Execute (see fuel.c) burns one unit of fuel on every call and taken backward branch, so a
+    program always reaches a check in a bounded time. The checks are placed after the stack pointer has been updated
+    and with no cached words, then the registers are the whole state and the program can be suspended.
+*/
+#ifdef EXECUTE_FUEL
+#define CONSUME_FUEL() do \
+{ \
+    if(--fuel == 0) \
+        goto SUSPEND; \
+} while(0)
+#else
+#define CONSUME_FUEL() do { } while(0)
+#endif
+// a green thread that yields or waits for another one is suspended like one that has burnt its fuel, only the fueled
+// variant can suspend and the scheduler runs the programs that spawn threads only with it, the other variants run the
+// chunks of the parallel loops, where a yield does nothing and a join of a thread that has not ended fails
+#ifdef EXECUTE_FUEL
+#define YIELD_THREAD() goto SUSPEND
+#define WAIT_THREAD(thread) do \
+{ \
+    context->Joining = (thread); \
+    pc -= 2; \
+    goto SUSPEND; \
+} while(0)
+#else
+#define YIELD_THREAD() CONTINUE
+#define WAIT_THREAD(thread) do \
+{ \
+    printf("Join of a running thread in function %s, only a green thread can wait for another one\n", fh->Signature); \
+    return -1; \
+} while(0)
+#endif
+#define FUEL_BACK_EDGE(o) do \
+{ \
+    if((o) < 0) \
+        CONSUME_FUEL(); \
+} while(0)
+#pragma endregion
+#pragma region Fused
+#define COMPARE_JUMP_WORD(sp, pc, type, operator) do \
+{ \
+    Word a, b; \
+    i16 o = iNextI16(&pc); \
+    a = *(sp - 2); \
+    b = *(sp - 1); \
+    sp -= 2; \
+    if(a.type operator b.type) \
+    { \
+        pc += o; \
+        FUEL_BACK_EDGE(o); \
+    } \
+} while(0)
+#pragma endregion
+#pragma region Top of stack cache
+/*
+    The top of the stack can be kept in the tos register, the dispatch table in use tells what it holds:
+    InstructionPointers -> nothing, the whole stack is in memory
+    CachedWordPointers  -> the word at sp - 1
+    CachedDWordPointers -> the dword at sp - 2
+    sp always counts the cached words, only their memory copy is stale.
+*/
+#define TOS_PUSH_WORD(sp, tos, w) do { \
+    (tos).UInt = (w).UInt; \
+    sp += 1; \
+} while(0)
+#define TOS_PUSH_DWORD(sp, tos, d) do { \
+    (tos) = (d); \
+    sp += 2; \
+} while(0)
+#define TOS_SPILL_WORD(sp, tos)  (*(sp - 1) = (tos).Word[0])
+#define TOS_SPILL_DWORD(sp, tos) (*(DWord*)(sp - 2) = (tos))
+#define TOS_BINARY_OPERATION_WORD(sp, tos, type, operator) do \
+{ \
+    Word a, res; \
+    a = *(sp - 2); \
+    res.type = a.type operator (tos).Word[0].type; \
+    (tos).UInt = res.UInt; \
+    sp -= 1; \
+} while (0)
+#define TOS_BINARY_OPERATION_DWORD(sp, tos, type, operator) do \
+{ \
+    DWord a, res; \
+    a = *(DWord*)(sp - 4); \
+    res.type = a.type operator (tos).type; \
+    (tos) = res; \
+    sp -= 2; \
+} while (0)
+#define TOS_UNARY_OPERATION_WORD(tos, type, operator) do \
+{ \
+    Word res; \
+    res.type = operator (tos).Word[0].type; \
+    (tos).UInt = res.UInt; \
+} while (0)
+#define TOS_UNARY_OPERATION_DWORD(tos, type, operator) do \
+{ \
+    DWord res; \
+    res.type = operator (tos).type; \
+    (tos) = res; \
+} while (0)
+#define TOS_MATH_WORD(tos, function) do \
+{ \
+    Word res = { .Float = function((tos).Word[0].Float) }; \
+    (tos).UInt = res.UInt; \
+} while (0)
+#define TOS_MATH_DWORD(tos, function) do \
+{ \
+    DWord res = { .Float = function((tos).Float) }; \
+    (tos) = res; \
+} while (0)
+#define TOS_CAST_WORD_WORD(tos, typeA, typeB, cast) do \
+{ \
+    Word to; \
+    to.typeB = (cast) (tos).Word[0].typeA; \
+    (tos).UInt = to.UInt; \
+} while(0)
+#define TOS_CAST_WORD_DWORD(sp, tos, typeA, typeB, cast) do \
+{ \
+    DWord to; \
+    to.typeB = (cast) (tos).Word[0].typeA; \
+    (tos) = to; \
+    sp += 1; \
+} while(0)
+#define TOS_CAST_DWORD_DWORD(tos, typeA, typeB, cast) do \
+{ \
+    DWord to; \
+    to.typeB = (cast) (tos).typeA; \
+    (tos) = to; \
+} while(0)
+#define TOS_CAST_DWORD_WORD(sp, tos, typeA, typeB, cast) do \
+{ \
+    Word to; \
+    to.typeB = (cast) (tos).typeA; \
+    (tos).UInt = to.UInt; \
+    sp -= 1; \
+} while(0)
+#define TOS_COMPARE_JUMP_WORD(sp, tos, pc, type, operator) do \
+{ \
+    Word a; \
+    i16 o = iNextI16(&pc); \
+    a = *(sp - 2); \
+    sp -= 2; \
+    if(a.type operator (tos).Word[0].type) \
+    { \
+        pc += o; \
+        FUEL_BACK_EDGE(o); \
+    } \
+} while(0)
+// a push in a cached state spills the cached value and continues in the empty state handler
+#define TOS_SPILL_HANDLERS(name) \
+HANDLE_W_##name: \
+    TOS_SPILL_WORD(sp, tos); \
+    goto HANDLE_##name; \
+HANDLE_D_##name: \
+    TOS_SPILL_DWORD(sp, tos); \
+    goto HANDLE_##name
 #pragma endregion
 #pragma region Load & Store
 #define LOAD_BYTE(sp, offset, b) do { \
@@ -233,6 +402,7 @@ static inline i8 iNextI16(Byte **pc)
     ref = *(DWord*)(sp - 4); \
     val = *(DWord*)(sp - 2); \
     *(DWord*)(ref.WordPtr + offset) = val; \
+    sp -= 4; \
 } while(0)
 #define LOAD_BUFF_VAL_WORD(sp, typePtr) do { \
     Word i; \
@@ -276,36 +446,259 @@ static inline i8 iNextI16(Byte **pc)
     sp -= 5; \
 } while(0)
 #pragma endregion
-// Continue prefetches the instruction and jumps to the start of the loop
+// Continue fetches the next instruction and dispatches it with the table of the empty top of stack cache state,
+// every handler keeps its own indirect jump so that the branch predictor can tell them apart
+/*
+    The tiered variant of Execute (see tiered.c) counts the calls and the taken backward branches of every function and
+    promotes it when a counter reaches its threshold, Execute runs the programs that do not tier up and counts nothing.
+*/
+#ifdef EXECUTE_TIERING
+#define COUNT_CALL(header) do \
+{ \
+    if(++(header)->Calls == callThreshold) \
+        TierUp(context, header, TIER_REASON_CALLS, NULL); \
+} while(0)
+#define COUNT_BACK_EDGE(o) do \
+{ \
+    if((o) < 0 && ++fh->BackEdges == loopThreshold) \
+        pc = (Byte*)TierUp(context, fh, TIER_REASON_LOOPS, pc); \
+} while(0)
+#else
+#define COUNT_CALL(header) do { } while(0)
+#define COUNT_BACK_EDGE(o) do { } while(0)
+#endif
+// pushes the frame of a call and moves to the callee, the pools of the callee are set by the call handler
+#define PUSH_CALL_FRAME(header, awc, lwc, swc) do \
+{ \
+    COUNT_CALL(header); \
+    /* the arguments on top of the stack are the first locals */ \
+    Word *newFP = sp - (awc); \
+    Word *frameHeader = FRAME_HEADER(newFP, lwc); \
+    STACK_PROBE(frameHeader + FRAME_HEADER_SIZE + swc, header); \
+    PUSH_FRAME_HEADER(frameHeader, newFP, pc, fp, fh, fbase); \
+\
+    fp = newFP; \
+    sp = frameHeader + FRAME_HEADER_SIZE; \
+    pc = (Byte*)(header)->Code; \
+    fh = header; \
+    CONSUME_FUEL(); \
+} while(0)
+// pops the frame of the running function, the caller stack ends after the rwc results at the frame pointer
+#define POP_CALL_FRAME(rwc) do \
+{ \
+    Word *frameHeader = FRAME_HEADER(fp, fh->LWC); \
+    sp = fp + (rwc); \
+    pc = FRAME_PC(frameHeader); \
+    fh = FRAME_FH(frameHeader, fbase); \
+    fp = FRAME_FP(frameHeader, fp); \
+} while(0)
+// a leaf makes no calls, so the link to its caller is kept in the leaf registers instead of the frame header, the slots of
+// the header are still reserved and written only when the program is suspended in the leaf
+#define PUSH_LEAF_FRAME(header) do \
+{ \
+    COUNT_CALL(header); \
+    Word *newFP = sp - (header)->AWC; \
+    Word *frameHeader = FRAME_HEADER(newFP, (header)->LWC); \
+    STACK_PROBE(frameHeader + FRAME_HEADER_SIZE + (header)->SWC, header); \
+    leafPC = pc; \
+    leafFP = fp; \
+    leafFH = fh; \
+\
+    fp = newFP; \
+    sp = frameHeader + FRAME_HEADER_SIZE; \
+    pc = (Byte*)(header)->Code; \
+    fh = header; \
+    CONSUME_FUEL(); \
+} while(0)
+#define POP_LEAF_FRAME(rwc) do \
+{ \
+    sp = fp + (rwc); \
+    pc = leafPC; \
+    fp = leafFP; \
+    fh = leafFH; \
+} while(0)
+// replaces the frame of the running function with the one of a tail call, the arguments on top of the stack become the
+// first locals and the header is moved after the locals of the callee, so the callee returns to the caller of the function
+#define REUSE_CALL_FRAME(header, awc, lwc, swc) do \
+{ \
+    COUNT_CALL(header); \
+    Word link[FRAME_HEADER_SIZE]; \
+    memcpy(link, FRAME_HEADER(fp, fh->LWC), sizeof(link)); \
+    memmove(fp, sp - (awc), (awc) * SIZEOF_WORD); \
+    Word *frameHeader = FRAME_HEADER(fp, lwc); \
+    STACK_PROBE(frameHeader + FRAME_HEADER_SIZE + swc, header); \
+    memcpy(frameHeader, link, sizeof(link)); \
+\
+    sp = frameHeader + FRAME_HEADER_SIZE; \
+    pc = (Byte*)(header)->Code; \
+    fh = header; \
+    CONSUME_FUEL(); \
+} while(0)
+// finds the entry of the inline cache of the indirect call site at pc for the target header
+#define INLINE_CACHE_FIND(entry, header) do \
+{ \
+    InlineCache *cache = InlineCacheOf(context, pc); \
+    entry = NULL; \
+    if(cache->Site == (const u8*)pc) \
+    { \
+        for (u8 i = 0; i < cache->Count; i++) \
+        { \
+            if(cache->Entries[i].Target == (header)) \
+            { \
+                entry = cache->Entries + i; \
+                break; \
+            } \
+        } \
+    } \
+    if(entry) \
+        cache->Hits++; \
+    else \
+        entry = iInlineCacheLookup(context, pc, fh, header); \
+} while(0)
+// counts a taken backward branch, the running activation continues in the new tier if the function gets promoted
+#define BACK_EDGE(o) do \
+{ \
+    COUNT_BACK_EDGE(o); \
+    FUEL_BACK_EDGE(o); \
+} while(0)
 #define CONTINUE do \
 { \
     op = pc->UInt; \
-    goto LOOP; \
+    pc += 1; \
+    goto *InstructionPointers[op]; \
 } while (0)
+// Continue in the given top of stack cache state
+#define CONTINUE_EMPTY CONTINUE
+#define CONTINUE_WORD do \
+{ \
+    op = pc->UInt; \
+    pc += 1; \
+    goto *CachedWordPointers[op]; \
+} while (0)
+#define CONTINUE_DWORD do \
+{ \
+    op = pc->UInt; \
+    pc += 1; \
+    goto *CachedDWordPointers[op]; \
+} while (0)
+
+/**
+ * Handles the indirect calls whose target is not in the cache the call site hashes to. 
+ * The cache of the site is found by linear probing, then the polymorphic entries are searched and on a miss the target 
+ * is resolved and takes an entry.
+ */
+static __attribute__((noinline)) const InlineCacheEntry *iInlineCacheLookup(const ProgramContext *context, const Byte *site, FunctionHeader *caller, FunctionHeader *target)
+{
+    // the table is never full, it has at least four caches per call site of the linked and the promoted bodies
+    u32 mask = (1U << context->InlineCachesBits) - 1;
+    InlineCache *cache = InlineCacheOf(context, site);
+    while (cache->Site != NULL && cache->Site != (const u8*)site)
+        cache = context->InlineCaches + ((cache - context->InlineCaches + 1) & mask);
 
+    if(cache->Site == (const u8*)site)
+    {
+        for (u8 i = 0; i < cache->Count; i++)
+        {
+            if(cache->Entries[i].Target == target)
+            {
+                cache->Hits++;
+                return cache->Entries + i;
+            }
+        }
+    }
+    else
+    {
+        cache->Site   = (const u8*)site;
+        cache->Caller = caller;
+        cache->Next   = 1;
+    }
+
+    // once full the polymorphic entries are replaced in round robin, the monomorphic one is kept
+    cache->Misses++;
+    InlineCacheEntry *entry;
+    if(cache->Count < INLINE_CACHE_WAYS)
+        entry = cache->Entries + cache->Count++;
+    else
+    {
+        entry = cache->Entries + cache->Next;
+        cache->Next = cache->Next + 1 < INLINE_CACHE_WAYS ? cache->Next + 1 : 1;
+    }
+    entry->Target = target;
+    entry->MT     = target->MT;
+    entry->AWC    = target->AWC;
+    entry->LWC    = target->LWC;
+    entry->SWC    = target->SWC;
+    return entry;
+}
+
+#if defined(EXECUTE_FUEL)
+i32 ExecuteFueled(ProgramContext *context)
+#elif defined(EXECUTE_TIERING)
+i32 ExecuteTiered(ProgramContext *context)
+#else
 i32 Execute(ProgramContext *context)
+#endif
 {
     Byte            *pc;    // Program Counter
     Word            *sp;    // Stack Pointer
     Word            *fp;    // Frame Pointer
     FunctionHeader  *fh;    // Function Header
+    const ModuleTable *mt;  // Module Table of the loaded pools
     Word            *wpool; // Word Pool 
     DWord           *dpool; // DWord Pool
     ch8            **spool; // String Pool
     void           **gpool; // Global Pool
     Function       **fpool; // Function Pool
+    Byte            *tls;   // Thread-Local globals of the running thread
+    DWord            tos;   // Top Of Stack cache
     u8               op;    // Opcode
+    Byte            *leafPC = NULL; // Program Counter of the caller of the running leaf
+    Word            *leafFP = NULL; // Frame Pointer of the caller of the running leaf
+    FunctionHeader  *leafFH = NULL; // Function Header of the caller of the running leaf
+
+#ifdef EXECUTE_TIERING
+    u32 callThreshold = context->Options.TierCalls;
+    u32 loopThreshold = context->Options.TierLoops;
+#endif
+    // base of the quickened calls
+    const Byte *fbase = context->FunctionsBuffer;
+    tls = context->ThreadLocals;
     
-    pc    = (Byte*)context->EntryPoint->Body;
-    sp    = context->StackBottom + context->EntryPoint->Header.LWC;
+    pc    = (Byte*)context->EntryPoint->Header.Code;
+    sp    = FRAME_HEADER(context->StackBottom, context->EntryPoint->Header.LWC) + FRAME_HEADER_SIZE;
     fp    = context->StackBottom;
     fh    = &context->EntryPoint->Header;
-    wpool = context->EntryPoint->Header.MT->WordPool;
-    dpool = context->EntryPoint->Header.MT->DWordPool;
-    spool = context->EntryPoint->Header.MT->StringPool;
-    gpool = context->EntryPoint->Header.MT->GlobalPool;
-    fpool = context->EntryPoint->Header.MT->FunctionPool;
+#ifdef EXECUTE_FUEL
+    u32 fuel = context->Options.Fuel;
+#endif
+    // a suspended program resumes from its registers, a function called by the host starts from the frame it has pushed
+    if(context->Suspended.PC)
+    {
+        pc = context->Suspended.PC;
+        sp = context->Suspended.SP;
+        fp = context->Suspended.FP;
+        fh = context->Suspended.FH;
+        context->Suspended.PC = NULL;
+#ifdef EXECUTE_FUEL
+        context->Slices++;
+#endif
+        // a program suspended in a leaf has saved the link to the caller in the frame header
+        if(fh->Leaf)
+        {
+            Word *frameHeader = FRAME_HEADER(fp, fh->LWC);
+            leafPC = FRAME_PC(frameHeader);
+            leafFH = FRAME_FH(frameHeader, fbase);
+            leafFP = FRAME_FP(frameHeader, fp);
+        }
+    }
+    mt    = fh->MT;
+    wpool = mt->WordPool;
+    dpool = mt->DWordPool;
+    spool = mt->StringPool;
+    gpool = mt->GlobalPool;
+    fpool = mt->FunctionPool;
     op    = pc->UInt;
+    tos   = (DWord) { .UInt = 0 };
     
 #pragma region InstructionTable
     __attribute__((aligned(128)))
@@ -550,6 +943,37 @@ i32 Execute(ProgramContext *context)
         &&HANDLE_INDCALL,
         &&HANDLE_SYSCALL,
         &&HANDLE_RET,
+
+        &&HANDLE_LOAD_GLOB_WORD,
+        &&HANDLE_LOAD_GLOB_DWORD,
+        &&HANDLE_PUSH_WORD_WORD,
+        &&HANDLE_ADD_I32_LOC_IMM,
+        &&HANDLE_ADD_I32_LOC_LOC,
+        &&HANDLE_JMP_WORD_EQ,
+        &&HANDLE_JMP_WORD_NE,
+        &&HANDLE_JMP_I32_GT,
+        &&HANDLE_JMP_I32_LT,
+        &&HANDLE_JMP_I32_GE,
+        &&HANDLE_JMP_I32_LE,
+        &&HANDLE_CALL_FUNC,
+        &&HANDLE_CALL_LEAF,
+        &&HANDLE_RET_LEAF,
+        &&HANDLE_SQRT_F32,
+        &&HANDLE_SQRT_F64,
+        &&HANDLE_EXP_F32,
+        &&HANDLE_EXP_F64,
+        &&HANDLE_LOG_F32,
+        &&HANDLE_LOG_F64,
+        &&HANDLE_MEMMOV,
+        &&HANDLE_MEMCPY,
+        &&HANDLE_TAILCALL,
+        &&HANDLE_INDTAILCALL,
+        &&HANDLE_GEN_NEW,
+        &&HANDLE_RESUME,
+        &&HANDLE_YIELD,
+        &&HANDLE_GEN_RETURN,
+        &&HANDLE_PUSH_TLS_REF,
+        &&HANDLE_PUSH_TLS_REF_W,
         &&HANDLE_NOT_IMPLEMENTED,
         &&HANDLE_NOT_IMPLEMENTED,
         &&HANDLE_NOT_IMPLEMENTED,
@@ -558,43 +982,223 @@ i32 Execute(ProgramContext *context)
         &&HANDLE_NOT_IMPLEMENTED,
         &&HANDLE_NOT_IMPLEMENTED,
         &&HANDLE_NOT_IMPLEMENTED,
-        &&HANDLE_NOT_IMPLEMENTED,
-        &&HANDLE_NOT_IMPLEMENTED,
-        &&HANDLE_NOT_IMPLEMENTED,
-        &&HANDLE_NOT_IMPLEMENTED,
-        &&HANDLE_NOT_IMPLEMENTED,
-        &&HANDLE_NOT_IMPLEMENTED,
-        &&HANDLE_NOT_IMPLEMENTED,
-        &&HANDLE_NOT_IMPLEMENTED,
-        &&HANDLE_NOT_IMPLEMENTED,
-        &&HANDLE_NOT_IMPLEMENTED,
-        &&HANDLE_NOT_IMPLEMENTED,
-        &&HANDLE_NOT_IMPLEMENTED,
-        &&HANDLE_NOT_IMPLEMENTED,
-        &&HANDLE_NOT_IMPLEMENTED,
-        &&HANDLE_NOT_IMPLEMENTED,
-        &&HANDLE_NOT_IMPLEMENTED,
-        &&HANDLE_NOT_IMPLEMENTED,
-        &&HANDLE_NOT_IMPLEMENTED,
-        &&HANDLE_NOT_IMPLEMENTED,
-        &&HANDLE_NOT_IMPLEMENTED,
-        &&HANDLE_NOT_IMPLEMENTED,
-        &&HANDLE_NOT_IMPLEMENTED,
-        &&HANDLE_NOT_IMPLEMENTED,
-        &&HANDLE_NOT_IMPLEMENTED,
-        &&HANDLE_NOT_IMPLEMENTED,
-        &&HANDLE_NOT_IMPLEMENTED,
-        &&HANDLE_NOT_IMPLEMENTED,
-        &&HANDLE_NOT_IMPLEMENTED,
-        &&HANDLE_NOT_IMPLEMENTED,
-        &&HANDLE_NOT_IMPLEMENTED,
-        &&HANDLE_NOT_IMPLEMENTED,
+        &&HANDLE_EXTENDED,
 };
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Woverride-init"
+    __attribute__((aligned(128)))
+    static const void* const CachedWordPointers[256] = 
+    {
+        [0 ... 255] = &&HANDLE_SPILL_WORD,
+        [OP_PUSH_WORD] = &&HANDLE_W_PUSH_WORD,
+        [OP_PUSH_WORD_0 ... OP_PUSH_WORD_3] = &&HANDLE_W_PUSH_WORD_L,
+        [OP_PUSH_DWORD] = &&HANDLE_W_PUSH_DWORD,
+        [OP_PUSH_DWORD_0 ... OP_PUSH_DWORD_3] = &&HANDLE_W_PUSH_DWORD_L,
+        [OP_PUSH_REF] = &&HANDLE_W_PUSH_REF,
+        [OP_PUSH_0_WORD ... OP_PUSH_I32_2] = &&HANDLE_W_PUSH_I32_V,
+        [OP_PUSH_0_DWORD ... OP_PUSH_I64_2] = &&HANDLE_W_PUSH_I64_V,
+        [OP_PUSH_F32_1] = &&HANDLE_W_PUSH_F32_1,
+        [OP_PUSH_F32_2] = &&HANDLE_W_PUSH_F32_2,
+        [OP_PUSH_F64_1] = &&HANDLE_W_PUSH_F64_1,
+        [OP_PUSH_F64_2] = &&HANDLE_W_PUSH_F64_2,
+        [OP_PUSH_I32] = &&HANDLE_W_PUSH_I32,
+        [OP_PUSH_I64] = &&HANDLE_W_PUSH_I64,
+        [OP_PUSH_CONST_WORD] = &&HANDLE_W_PUSH_CONST_WORD,
+        [OP_PUSH_CONST_WORD_W] = &&HANDLE_W_PUSH_CONST_WORD_W,
+        [OP_PUSH_CONST_DWORD] = &&HANDLE_W_PUSH_CONST_DWORD,
+        [OP_PUSH_CONST_DWORD_W] = &&HANDLE_W_PUSH_CONST_DWORD_W,
+        [OP_PUSH_CONST_STR] = &&HANDLE_W_PUSH_CONST_STR,
+        [OP_PUSH_CONST_STR_W] = &&HANDLE_W_PUSH_CONST_STR_W,
+        [OP_PUSH_GLOB_REF] = &&HANDLE_W_PUSH_GLOB_REF,
+        [OP_PUSH_GLOB_REF_W] = &&HANDLE_W_PUSH_GLOB_REF_W,
+        [OP_PUSH_TLS_REF] = &&HANDLE_W_PUSH_TLS_REF,
+        [OP_PUSH_TLS_REF_W] = &&HANDLE_W_PUSH_TLS_REF_W,
+        [OP_PUSH_FUNC] = &&HANDLE_W_PUSH_FUNC,
+        [OP_LOAD_GLOB_WORD] = &&HANDLE_W_LOAD_GLOB_WORD,
+        [OP_LOAD_GLOB_DWORD] = &&HANDLE_W_LOAD_GLOB_DWORD,
+        [OP_PUSH_WORD_WORD] = &&HANDLE_W_PUSH_WORD_WORD,
+
+        [OP_POP_WORD] = &&HANDLE_W_POP_WORD,
+        [OP_RET] = &&HANDLE_W_RET,
+        [OP_RET_LEAF] = &&HANDLE_W_RET_LEAF,
+        [OP_POP_WORD_0 ... OP_POP_WORD_3] = &&HANDLE_W_POP_WORD_L,
+        [OP_ADD_I32] = &&HANDLE_W_ADD_I32,
+        [OP_ADD_F32] = &&HANDLE_W_ADD_F32,
+        [OP_SUB_I32] = &&HANDLE_W_SUB_I32,
+        [OP_SUB_F32] = &&HANDLE_W_SUB_F32,
+        [OP_MUL_I32] = &&HANDLE_W_MUL_I32,
+        [OP_MUL_U32] = &&HANDLE_W_MUL_U32,
+        [OP_MUL_F32] = &&HANDLE_W_MUL_F32,
+        [OP_DIV_I32] = &&HANDLE_W_DIV_I32,
+        [OP_DIV_U32] = &&HANDLE_W_DIV_U32,
+        [OP_DIV_F32] = &&HANDLE_W_DIV_F32,
+        [OP_REM_I32] = &&HANDLE_W_REM_I32,
+        [OP_REM_U32] = &&HANDLE_W_REM_U32,
+        [OP_AND_WORD] = &&HANDLE_W_AND_WORD,
+        [OP_OR_WORD] = &&HANDLE_W_OR_WORD,
+        [OP_XOR_WORD] = &&HANDLE_W_XOR_WORD,
+        [OP_SHL_WORD] = &&HANDLE_W_SHL_WORD,
+        [OP_SHR_I32] = &&HANDLE_W_SHR_I32,
+        [OP_SHR_U32] = &&HANDLE_W_SHR_U32,
+        [OP_CMP_WORD_EQ] = &&HANDLE_W_CMP_WORD_EQ,
+        [OP_CMP_WORD_NE] = &&HANDLE_W_CMP_WORD_NE,
+        [OP_CMP_I32_GT] = &&HANDLE_W_CMP_I32_GT,
+        [OP_CMP_U32_GT] = &&HANDLE_W_CMP_U32_GT,
+        [OP_CMP_F32_GT] = &&HANDLE_W_CMP_F32_GT,
+        [OP_CMP_I32_LT] = &&HANDLE_W_CMP_I32_LT,
+        [OP_CMP_U32_LT] = &&HANDLE_W_CMP_U32_LT,
+        [OP_CMP_F32_LT] = &&HANDLE_W_CMP_F32_LT,
+        [OP_CMP_I32_GE] = &&HANDLE_W_CMP_I32_GE,
+        [OP_CMP_U32_GE] = &&HANDLE_W_CMP_U32_GE,
+        [OP_CMP_F32_GE] = &&HANDLE_W_CMP_F32_GE,
+        [OP_CMP_I32_LE] = &&HANDLE_W_CMP_I32_LE,
+        [OP_CMP_U32_LE] = &&HANDLE_W_CMP_U32_LE,
+        [OP_CMP_F32_LE] = &&HANDLE_W_CMP_F32_LE,
+        [OP_NEG_I32] = &&HANDLE_W_NEG_I32,
+        [OP_NEG_F32] = &&HANDLE_W_NEG_F32,
+        [OP_SQRT_F32] = &&HANDLE_W_SQRT_F32,
+        [OP_EXP_F32] = &&HANDLE_W_EXP_F32,
+        [OP_LOG_F32] = &&HANDLE_W_LOG_F32,
+        [OP_MEMMOV] = &&HANDLE_W_MEMMOV,
+        [OP_MEMCPY] = &&HANDLE_W_MEMCPY,
+        [OP_NOT_WORD] = &&HANDLE_W_NOT_WORD,
+        [OP_CMP_NOT] = &&HANDLE_W_CMP_NOT,
+        [OP_I32_TO_I8] = &&HANDLE_W_I32_TO_I8,
+        [OP_I32_TO_I16] = &&HANDLE_W_I32_TO_I16,
+        [OP_I32_TO_F32] = &&HANDLE_W_I32_TO_F32,
+        [OP_F32_TO_I32] = &&HANDLE_W_F32_TO_I32,
+        [OP_I32_TO_I64] = &&HANDLE_W_I32_TO_I64,
+        [OP_I32_TO_F64] = &&HANDLE_W_I32_TO_F64,
+        [OP_F32_TO_I64] = &&HANDLE_W_F32_TO_I64,
+        [OP_F32_TO_F64] = &&HANDLE_W_F32_TO_F64,
+        [OP_JMP_WORD_EQ] = &&HANDLE_W_JMP_WORD_EQ,
+        [OP_JMP_WORD_NE] = &&HANDLE_W_JMP_WORD_NE,
+        [OP_JMP_I32_GT] = &&HANDLE_W_JMP_I32_GT,
+        [OP_JMP_I32_LT] = &&HANDLE_W_JMP_I32_LT,
+        [OP_JMP_I32_GE] = &&HANDLE_W_JMP_I32_GE,
+        [OP_JMP_I32_LE] = &&HANDLE_W_JMP_I32_LE,
+        [OP_JMP_IF] = &&HANDLE_W_JMP_IF,
+        [OP_DUP_WORD] = &&HANDLE_W_DUP_WORD,
+        [OP_STORE_WORD] = &&HANDLE_W_STORE_WORD,
+    };
+    __attribute__((aligned(128)))
+    static const void* const CachedDWordPointers[256] = 
+    {
+        [0 ... 255] = &&HANDLE_SPILL_DWORD,
+        [OP_PUSH_WORD] = &&HANDLE_D_PUSH_WORD,
+        [OP_PUSH_WORD_0 ... OP_PUSH_WORD_3] = &&HANDLE_D_PUSH_WORD_L,
+        [OP_PUSH_DWORD] = &&HANDLE_D_PUSH_DWORD,
+        [OP_PUSH_DWORD_0 ... OP_PUSH_DWORD_3] = &&HANDLE_D_PUSH_DWORD_L,
+        [OP_PUSH_REF] = &&HANDLE_D_PUSH_REF,
+        [OP_PUSH_0_WORD ... OP_PUSH_I32_2] = &&HANDLE_D_PUSH_I32_V,
+        [OP_PUSH_0_DWORD ... OP_PUSH_I64_2] = &&HANDLE_D_PUSH_I64_V,
+        [OP_PUSH_F32_1] = &&HANDLE_D_PUSH_F32_1,
+        [OP_PUSH_F32_2] = &&HANDLE_D_PUSH_F32_2,
+        [OP_PUSH_F64_1] = &&HANDLE_D_PUSH_F64_1,
+        [OP_PUSH_F64_2] = &&HANDLE_D_PUSH_F64_2,
+        [OP_PUSH_I32] = &&HANDLE_D_PUSH_I32,
+        [OP_PUSH_I64] = &&HANDLE_D_PUSH_I64,
+        [OP_PUSH_CONST_WORD] = &&HANDLE_D_PUSH_CONST_WORD,
+        [OP_PUSH_CONST_WORD_W] = &&HANDLE_D_PUSH_CONST_WORD_W,
+        [OP_PUSH_CONST_DWORD] = &&HANDLE_D_PUSH_CONST_DWORD,
+        [OP_PUSH_CONST_DWORD_W] = &&HANDLE_D_PUSH_CONST_DWORD_W,
+        [OP_PUSH_CONST_STR] = &&HANDLE_D_PUSH_CONST_STR,
+        [OP_PUSH_CONST_STR_W] = &&HANDLE_D_PUSH_CONST_STR_W,
+        [OP_PUSH_GLOB_REF] = &&HANDLE_D_PUSH_GLOB_REF,
+        [OP_PUSH_GLOB_REF_W] = &&HANDLE_D_PUSH_GLOB_REF_W,
+        [OP_PUSH_TLS_REF] = &&HANDLE_D_PUSH_TLS_REF,
+        [OP_PUSH_TLS_REF_W] = &&HANDLE_D_PUSH_TLS_REF_W,
+        [OP_PUSH_FUNC] = &&HANDLE_D_PUSH_FUNC,
+        [OP_LOAD_GLOB_WORD] = &&HANDLE_D_LOAD_GLOB_WORD,
+        [OP_LOAD_GLOB_DWORD] = &&HANDLE_D_LOAD_GLOB_DWORD,
+        [OP_PUSH_WORD_WORD] = &&HANDLE_D_PUSH_WORD_WORD,
+
+        [OP_POP_DWORD] = &&HANDLE_D_POP_DWORD,
+        [OP_RET] = &&HANDLE_D_RET,
+        [OP_RET_LEAF] = &&HANDLE_D_RET_LEAF,
+        [OP_POP_DWORD_0 ... OP_POP_DWORD_3] = &&HANDLE_D_POP_DWORD_L,
+        [OP_ADD_I64] = &&HANDLE_D_ADD_I64,
+        [OP_ADD_F64] = &&HANDLE_D_ADD_F64,
+        [OP_SUB_I64] = &&HANDLE_D_SUB_I64,
+        [OP_SUB_F64] = &&HANDLE_D_SUB_F64,
+        [OP_MUL_I64] = &&HANDLE_D_MUL_I64,
+        [OP_MUL_U64] = &&HANDLE_D_MUL_U64,
+        [OP_MUL_F64] = &&HANDLE_D_MUL_F64,
+        [OP_DIV_I64] = &&HANDLE_D_DIV_I64,
+        [OP_DIV_U64] = &&HANDLE_D_DIV_U64,
+        [OP_DIV_F64] = &&HANDLE_D_DIV_F64,
+        [OP_REM_I64] = &&HANDLE_D_REM_I64,
+        [OP_REM_U64] = &&HANDLE_D_REM_U64,
+        [OP_AND_DWORD] = &&HANDLE_D_AND_DWORD,
+        [OP_OR_DWORD] = &&HANDLE_D_OR_DWORD,
+        [OP_XOR_DWORD] = &&HANDLE_D_XOR_DWORD,
+        [OP_SHL_DWORD] = &&HANDLE_D_SHL_DWORD,
+        [OP_SHR_I64] = &&HANDLE_D_SHR_I64,
+        [OP_SHR_U64] = &&HANDLE_D_SHR_U64,
+        [OP_CMP_DWORD_EQ] = &&HANDLE_D_CMP_DWORD_EQ,
+        [OP_CMP_DWORD_NE] = &&HANDLE_D_CMP_DWORD_NE,
+        [OP_CMP_I64_GT] = &&HANDLE_D_CMP_I64_GT,
+        [OP_CMP_U64_GT] = &&HANDLE_D_CMP_U64_GT,
+        [OP_CMP_F64_GT] = &&HANDLE_D_CMP_F64_GT,
+        [OP_CMP_I64_LT] = &&HANDLE_D_CMP_I64_LT,
+        [OP_CMP_U64_LT] = &&HANDLE_D_CMP_U64_LT,
+        [OP_CMP_F64_LT] = &&HANDLE_D_CMP_F64_LT,
+        [OP_CMP_I64_GE] = &&HANDLE_D_CMP_I64_GE,
+        [OP_CMP_U64_GE] = &&HANDLE_D_CMP_U64_GE,
+        [OP_CMP_F64_GE] = &&HANDLE_D_CMP_F64_GE,
+        [OP_CMP_I64_LE] = &&HANDLE_D_CMP_I64_LE,
+        [OP_CMP_U64_LE] = &&HANDLE_D_CMP_U64_LE,
+        [OP_CMP_F64_LE] = &&HANDLE_D_CMP_F64_LE,
+        [OP_NEG_I64] = &&HANDLE_D_NEG_I64,
+        [OP_NEG_F64] = &&HANDLE_D_NEG_F64,
+        [OP_SQRT_F64] = &&HANDLE_D_SQRT_F64,
+        [OP_EXP_F64] = &&HANDLE_D_EXP_F64,
+        [OP_LOG_F64] = &&HANDLE_D_LOG_F64,
+        [OP_NOT_DWORD] = &&HANDLE_D_NOT_DWORD,
+        [OP_I64_TO_F64] = &&HANDLE_D_I64_TO_F64,
+        [OP_F64_TO_I64] = &&HANDLE_D_F64_TO_I64,
+        [OP_I64_TO_I32] = &&HANDLE_D_I64_TO_I32,
+        [OP_I64_TO_F32] = &&HANDLE_D_I64_TO_F32,
+        [OP_F64_TO_I32] = &&HANDLE_D_F64_TO_I32,
+        [OP_F64_TO_F32] = &&HANDLE_D_F64_TO_F32,
+        [OP_DUP_DWORD] = &&HANDLE_D_DUP_DWORD,
+        [OP_LOAD_WORD] = &&HANDLE_D_LOAD_WORD,
+        [OP_LOAD_DWORD] = &&HANDLE_D_LOAD_DWORD,
+        [OP_STORE_DWORD] = &&HANDLE_D_STORE_DWORD,
+    };
+    // the less frequent instructions, reached through the prefix in the empty state
+    __attribute__((aligned(128)))
+    static const void* const ExtendedPointers[256] = 
+    {
+        [0 ... 255] = &&HANDLE_NOT_IMPLEMENTED,
+        [OP_EXT_POPCNT_I32] = &&HANDLE_POPCNT_I32,
+        [OP_EXT_POPCNT_I64] = &&HANDLE_POPCNT_I64,
+        [OP_EXT_CLZ_I32] = &&HANDLE_CLZ_I32,
+        [OP_EXT_CLZ_I64] = &&HANDLE_CLZ_I64,
+        [OP_EXT_CTZ_I32] = &&HANDLE_CTZ_I32,
+        [OP_EXT_CTZ_I64] = &&HANDLE_CTZ_I64,
+        [OP_EXT_ATOMIC_LOAD_WORD]   = &&HANDLE_ATOMIC_LOAD_WORD,
+        [OP_EXT_ATOMIC_LOAD_DWORD]  = &&HANDLE_ATOMIC_LOAD_DWORD,
+        [OP_EXT_ATOMIC_STORE_WORD]  = &&HANDLE_ATOMIC_STORE_WORD,
+        [OP_EXT_ATOMIC_STORE_DWORD] = &&HANDLE_ATOMIC_STORE_DWORD,
+        [OP_EXT_CAS_WORD]  = &&HANDLE_CAS_WORD,
+        [OP_EXT_CAS_DWORD] = &&HANDLE_CAS_DWORD,
+        [OP_EXT_FETCH_ADD_WORD]  = &&HANDLE_FETCH_ADD_WORD,
+        [OP_EXT_FETCH_ADD_DWORD] = &&HANDLE_FETCH_ADD_DWORD,
+        [OP_EXT_FETCH_SUB_WORD]  = &&HANDLE_FETCH_SUB_WORD,
+        [OP_EXT_FETCH_SUB_DWORD] = &&HANDLE_FETCH_SUB_DWORD,
+        [OP_EXT_FETCH_AND_WORD]  = &&HANDLE_FETCH_AND_WORD,
+        [OP_EXT_FETCH_AND_DWORD] = &&HANDLE_FETCH_AND_DWORD,
+        [OP_EXT_FETCH_OR_WORD]   = &&HANDLE_FETCH_OR_WORD,
+        [OP_EXT_FETCH_OR_DWORD]  = &&HANDLE_FETCH_OR_DWORD,
+        [OP_EXT_FETCH_XOR_WORD]  = &&HANDLE_FETCH_XOR_WORD,
+        [OP_EXT_FETCH_XOR_DWORD] = &&HANDLE_FETCH_XOR_DWORD,
+        [OP_EXT_FENCE] = &&HANDLE_FENCE,
+    };
+#pragma GCC diagnostic pop
 #pragma endregion
-    const void * const *instructionTable = InstructionPointers;
-LOOP:
     pc += 1;
-    goto *instructionTable[op];
+    goto *InstructionPointers[op];
 HANDLE_NOT_IMPLEMENTED:
     UNLIKELY(false, "Instruction not supported in function %s!\n", fh->Signature);
     exit(EXIT_FAILURE);
@@ -619,27 +1223,27 @@ HANDLE_PUSH_HWORD:
 HANDLE_PUSH_WORD:
     {
         sz l = iNextU8(&pc);
-        LOCAL_PUSH_WORD(sp, fp, l);
+        TOS_PUSH_WORD(sp, tos, *(fp + LOCALS_OFFSET + l));
     }
-    CONTINUE;
+    CONTINUE_WORD;
 HANDLE_PUSH_WORD_L:
     {
         sz l = op - OP_PUSH_WORD_0;
-        LOCAL_PUSH_WORD(sp, fp, l);
+        TOS_PUSH_WORD(sp, tos, *(fp + LOCALS_OFFSET + l));
     }
-    CONTINUE;
+    CONTINUE_WORD;
 HANDLE_PUSH_DWORD:
     {
         sz l = iNextU8(&pc);
-        LOCAL_PUSH_DWORD(sp, fp, l);
+        TOS_PUSH_DWORD(sp, tos, *(DWord*)(fp + LOCALS_OFFSET + l));
     }
-    CONTINUE;
+    CONTINUE_DWORD;
 HANDLE_PUSH_DWORD_L:
     {
         sz l = op - OP_PUSH_DWORD_0;
-        LOCAL_PUSH_DWORD(sp, fp, l);
+        TOS_PUSH_DWORD(sp, tos, *(DWord*)(fp + LOCALS_OFFSET + l));
     }
-    CONTINUE;
+    CONTINUE_DWORD;
 HANDLE_PUSH_WORDS:
     {
         sz l = iNextU8(&pc);
@@ -651,115 +1255,127 @@ HANDLE_PUSH_REF:
     {
         sz l      = iNextU8(&pc);
         DWord ref = RefToDWord(fp + LOCALS_OFFSET + l); 
-        VAL_PUSH_DWORD(sp, ref);
+        TOS_PUSH_DWORD(sp, tos, ref);
     }
-    CONTINUE;
+    CONTINUE_DWORD;
 #pragma endregion
 #pragma region Push Immediate
 HANDLE_PUSH_I32_V:
     {
         Word w = IntToWord(op - OP_PUSH_0_WORD);
-        VAL_PUSH_WORD(sp, w);
+        TOS_PUSH_WORD(sp, tos, w);
     }
-    CONTINUE;
+    CONTINUE_WORD;
 HANDLE_PUSH_I64_V:
     {
         DWord d = IntToDWord(op - OP_PUSH_0_DWORD);
-        VAL_PUSH_DWORD(sp, d);
+        TOS_PUSH_DWORD(sp, tos, d);
     }
-    CONTINUE;
+    CONTINUE_DWORD;
 HANDLE_PUSH_F32_1:
     {
         Word w = FloatToWord(1.0f);
-        VAL_PUSH_WORD(sp, w);
+        TOS_PUSH_WORD(sp, tos, w);
     }    
-    CONTINUE;
+    CONTINUE_WORD;
 HANDLE_PUSH_F32_2:
     {
         Word w = FloatToWord(2.0f);
-        VAL_PUSH_WORD(sp, w);
+        TOS_PUSH_WORD(sp, tos, w);
     }    
-    CONTINUE;
+    CONTINUE_WORD;
 HANDLE_PUSH_F64_1:
     {
         DWord d = FloatToDWord(1.0);
-        VAL_PUSH_DWORD(sp, d);
+        TOS_PUSH_DWORD(sp, tos, d);
     }    
-    CONTINUE;
+    CONTINUE_DWORD;
 HANDLE_PUSH_F64_2:
     {
         DWord d = FloatToDWord(2.0);
-        VAL_PUSH_DWORD(sp, d);
+        TOS_PUSH_DWORD(sp, tos, d);
     }    
-    CONTINUE;
+    CONTINUE_DWORD;
 HANDLE_PUSH_I32:
     {
         Word w = IntToWord((i32)iNextI8(&pc));
-        VAL_PUSH_WORD(sp, w);
+        TOS_PUSH_WORD(sp, tos, w);
     }
-    CONTINUE;
+    CONTINUE_WORD;
 HANDLE_PUSH_I64:
     {
         DWord d = IntToDWord((i64)iNextI8(&pc));
-        VAL_PUSH_DWORD(sp, d);
+        TOS_PUSH_DWORD(sp, tos, d);
     }
-    CONTINUE;
+    CONTINUE_DWORD;
 #pragma endregion
 #pragma region Push Constant
 HANDLE_PUSH_CONST_WORD:
     {
         Word w = *(wpool + iNextU8(&pc));
-        VAL_PUSH_WORD(sp, w);
+        TOS_PUSH_WORD(sp, tos, w);
     }
-    CONTINUE;
+    CONTINUE_WORD;
 HANDLE_PUSH_CONST_WORD_W:
     {
         Word w = *(wpool + iNextU16(&pc));
-        VAL_PUSH_WORD(sp, w);
+        TOS_PUSH_WORD(sp, tos, w);
     }    
-    CONTINUE;
+    CONTINUE_WORD;
 HANDLE_PUSH_CONST_DWORD:
     {
         DWord d = *(dpool + iNextU8(&pc));
-        VAL_PUSH_DWORD(sp, d);
+        TOS_PUSH_DWORD(sp, tos, d);
     }    
-    CONTINUE;
+    CONTINUE_DWORD;
 HANDLE_PUSH_CONST_DWORD_W:
     {
         DWord d = *(dpool + iNextU16(&pc));
-        VAL_PUSH_DWORD(sp, d);
+        TOS_PUSH_DWORD(sp, tos, d);
     }    
-    CONTINUE;
+    CONTINUE_DWORD;
 HANDLE_PUSH_CONST_STR:
     {
         DWord d = RefToDWord(*(spool + iNextU8(&pc)));
-        VAL_PUSH_DWORD(sp, d);
+        TOS_PUSH_DWORD(sp, tos, d);
     }    
-    CONTINUE;
+    CONTINUE_DWORD;
 HANDLE_PUSH_CONST_STR_W:
     {
         DWord d = RefToDWord(*(spool + iNextU16(&pc)));
-        VAL_PUSH_DWORD(sp, d);
+        TOS_PUSH_DWORD(sp, tos, d);
     }    
-    CONTINUE;
+    CONTINUE_DWORD;
 HANDLE_PUSH_GLOB_REF:
     {
         DWord d = RefToDWord(*(gpool + iNextU8(&pc)));
-        VAL_PUSH_DWORD(sp, d);
+        TOS_PUSH_DWORD(sp, tos, d);
     }
-    CONTINUE;
+    CONTINUE_DWORD;
 HANDLE_PUSH_GLOB_REF_W:
     {
         DWord d = RefToDWord(*(gpool + iNextU16(&pc)));
-        VAL_PUSH_DWORD(sp, d);
+        TOS_PUSH_DWORD(sp, tos, d);
     }
-    CONTINUE;
+    CONTINUE_DWORD;
+HANDLE_PUSH_TLS_REF:
+    {
+        DWord d = RefToDWord(tls + (sz)*(gpool + iNextU8(&pc)));
+        TOS_PUSH_DWORD(sp, tos, d);
+    }
+    CONTINUE_DWORD;
+HANDLE_PUSH_TLS_REF_W:
+    {
+        DWord d = RefToDWord(tls + (sz)*(gpool + iNextU16(&pc)));
+        TOS_PUSH_DWORD(sp, tos, d);
+    }
+    CONTINUE_DWORD;
 HANDLE_PUSH_FUNC:
     {
         DWord funcPtr = RefToDWord(*(fpool + iNextU16(&pc)));
-        VAL_PUSH_DWORD(sp, funcPtr);
+        TOS_PUSH_DWORD(sp, tos, funcPtr);
     }
-    CONTINUE;
+    CONTINUE_DWORD;
 #pragma endregion
 #pragma region Pop
 HANDLE_POP_BYTE:
@@ -950,6 +1566,26 @@ HANDLE_NEG_F64:
     UNARY_OPERATION_DWORD(sp, Float, -);
     CONTINUE;
 #pragma endregion
+#pragma region Math
+HANDLE_SQRT_F32:
+    SYSCALL_MATH_WORD(sp, sqrtf);
+    CONTINUE;
+HANDLE_SQRT_F64:
+    SYSCALL_MATH_DWORD(sp, sqrt);
+    CONTINUE;
+HANDLE_EXP_F32:
+    SYSCALL_MATH_WORD(sp, expf);
+    CONTINUE;
+HANDLE_EXP_F64:
+    SYSCALL_MATH_DWORD(sp, exp);
+    CONTINUE;
+HANDLE_LOG_F32:
+    SYSCALL_MATH_WORD(sp, logf);
+    CONTINUE;
+HANDLE_LOG_F64:
+    SYSCALL_MATH_DWORD(sp, log);
+    CONTINUE;
+#pragma endregion
 #pragma region Bitwise
 HANDLE_NOT_WORD:
     UNARY_OPERATION_WORD(sp, Int, ~);
@@ -1025,7 +1661,7 @@ HANDLE_F32_TO_I32:
     CAST_WORD_WORD(sp, Float, Int, i32);
     CONTINUE;
 HANDLE_F32_TO_I64:
-    CAST_WORD_WORD(sp, Float, Int, i64);
+    CAST_WORD_DWORD(sp, Float, Int, i64);
     CONTINUE;
 HANDLE_F32_TO_F64:
     CAST_WORD_DWORD(sp, Float, Float, f64);
@@ -1228,6 +1864,7 @@ HANDLE_LOAD_WORDS:
         sp += n;
         sp -= 2;
     }
+    CONTINUE;
 HANDLE_STORE_BYTE:
     {
         sz b = op - OP_STORE_BYTE_0;
@@ -1296,6 +1933,7 @@ HANDLE_LOAD_OFST_WORDS:
         sp += n;
         sp -= 2;
     }
+    CONTINUE;
 HANDLE_STORE_OFST_BYTE:
     {
         sz o = iNextU8(&pc);
@@ -1419,20 +2057,30 @@ HANDLE_FREE:
         sp -= 2;
     }
     CONTINUE;
+HANDLE_MEMMOV:
+    SYSCALL_MEMMOV(sp);
+    CONTINUE;
+HANDLE_MEMCPY:
+    SYSCALL_MEMCPY(sp);
+    CONTINUE;
 #pragma endregion
 #pragma region Control flow
 HANDLE_JMP:
     {
         i16 o = iNextI16(&pc);
         pc += o;
+        BACK_EDGE(o);
     }
     CONTINUE;
 HANDLE_JMP_IF:
     {
         i16 o = iNextI16(&pc);
-        if((sp - 1)->Int)
-            pc += o;
         sp -= 1;
+        if(sp->Int)
+        {
+            pc += o;
+            BACK_EDGE(o);
+        }
     }
     CONTINUE;
 HANDLE_CALL:
@@ -1442,8 +2090,158 @@ HANDLE_CALL:
         header = &fpool[f]->Header;
     }
     goto CALL_HEADER;
+HANDLE_CALL_FUNC:
+    header = (FunctionHeader*)(fbase + (sz)iNextU16(&pc) * SIZEOF_DWORD);
+    goto CALL_HEADER;
+HANDLE_CALL_LEAF:
+    // the callee is in the same module, the pools stay the same
+    header = (FunctionHeader*)(fbase + (sz)iNextU16(&pc) * SIZEOF_DWORD);
+    PUSH_LEAF_FRAME(header);
+    CONTINUE;
 HANDLE_INDCALL:
+    const InlineCacheEntry *entry;
     header = (FunctionHeader*)((DWord*)(sp - 2))->Ptr;
+    INLINE_CACHE_FIND(entry, header);
+    {
+        u16 awc = entry->AWC;
+        u16 lwc = entry->LWC;
+        u16 swc = entry->SWC;
+        PUSH_CALL_FRAME(header, awc, lwc, swc);
+        SWITCH_MODULE(entry->MT);
+    }
+    CONTINUE;
+HANDLE_TAILCALL:
+    {
+        u16 f = iNextU16(&pc);
+        header = &fpool[f]->Header;
+    }
+    {
+        u16 awc = header->AWC;
+        u16 lwc = header->LWC;
+        u16 swc = header->SWC;
+        REUSE_CALL_FRAME(header, awc, lwc, swc);
+        SWITCH_MODULE(fh->MT);
+    }
+    CONTINUE;
+HANDLE_INDTAILCALL:
+    header = (FunctionHeader*)((DWord*)(sp - 2))->Ptr;
+    // the validator cannot check the target, one that returns a different number of words is called and the return
+    // after the call keeps the words of the function
+    if(header->RWC != fh->RWC)
+        goto HANDLE_INDCALL;
+    INLINE_CACHE_FIND(entry, header);
+    {
+        u16 awc = entry->AWC;
+        u16 lwc = entry->LWC;
+        u16 swc = entry->SWC;
+        REUSE_CALL_FRAME(header, awc, lwc, swc);
+        SWITCH_MODULE(entry->MT);
+    }
+    CONTINUE;
+#pragma region Generators
+HANDLE_GEN_NEW:
+    {
+        u16 f = iNextU16(&pc);
+        header = &fpool[f]->Header;
+    }
+    {
+        // the arguments are the first locals of the saved frame, the stack of the generator starts empty
+        u16 awc = header->AWC;
+        GeneratorFrame *generator = malloc(sizeof(GeneratorFrame) + ((sz)header->LWC + FRAME_HEADER_SIZE + header->SWC) * SIZEOF_WORD);
+        generator->PC      = (Byte*)header->Code;
+        generator->Return  = NULL;
+        generator->Header  = header;
+        generator->StackWords = 0;
+        generator->Exit[0].UInt = OP_GEN_RETURN;
+        sp -= awc;
+        memcpy(generator->Frame, sp, awc * SIZEOF_WORD);
+        ((DWord*)sp)->Ptr = generator;
+        sp += 2;
+    }
+    CONTINUE;
+HANDLE_RESUME:
+    {
+        // the validator counts the values with the function of the instruction, the generator must run that one
+        u16 f = iNextU16(&pc);
+        GeneratorFrame *generator = ((DWord*)(sp - 2))->Ptr;
+        header = generator->Header;
+        if(header != &fpool[f]->Header)
+        {
+            printf("Resume of a generator of %s as one of %s in function %s\n", header->Signature, fpool[f]->Header.Signature, fh->Signature);
+            return -1;
+        }
+        if(generator->PC == NULL)
+        {
+            // a generator that has returned produces zeros
+            u16 rwc = header->RWC;
+            sp -= 2;
+            memset(sp, 0, (rwc + 1) * SIZEOF_WORD);
+            sp += rwc + 1;
+            CONTINUE;
+        }
+        if(generator->PC == generator->Exit)
+        {
+            printf("Resume of a running generator of %s in function %s\n", header->Signature, fh->Signature);
+            return -1;
+        }
+
+        // the frame is pushed above the reference of the generator, where the yield finds it, and returns in the exit of
+        // the generator, the PC of a running generator is its exit until it yields
+        u16 lwc = header->LWC;
+        Word *frameHeader = FRAME_HEADER(sp, lwc);
+        STACK_PROBE(frameHeader + FRAME_HEADER_SIZE + header->SWC, header);
+        memcpy(sp, generator->Frame, (lwc + FRAME_HEADER_SIZE + generator->StackWords) * SIZEOF_WORD);
+        PUSH_FRAME_HEADER(frameHeader, sp, generator->Exit, fp, fh, fbase);
+        generator->Return = pc;
+
+        fp = sp;
+        sp = frameHeader + FRAME_HEADER_SIZE + generator->StackWords;
+        pc = generator->PC;
+        generator->PC = generator->Exit;
+        fh = header;
+        SWITCH_MODULE(fh->MT);
+        CONSUME_FUEL();
+    }
+    CONTINUE;
+HANDLE_YIELD:
+    {
+        // the frame and the stack under the values are saved, the values take the place of the reference in the caller
+        GeneratorFrame *generator = ((DWord*)(fp - 2))->Ptr;
+        u16 rwc = fh->RWC;
+        u16 lwc = fh->LWC;
+        Word *frameHeader = FRAME_HEADER(fp, lwc);
+        Word *stack = frameHeader + FRAME_HEADER_SIZE;
+        u32 words = (u32)(sp - rwc - stack);
+        memcpy(generator->Frame, fp, (sz)(sp - rwc - fp) * SIZEOF_WORD);
+        generator->StackWords = words;
+        generator->PC     = pc;
+
+        for (u16 i = 0; i < rwc; i++)
+            fp[i - 2] = sp[i - rwc];
+        sp = fp - 2 + rwc;
+        sp->UInt = 1;
+        sp += 1;
+        pc = generator->Return;
+        fh = FRAME_FH(frameHeader, fbase);
+        fp = FRAME_FP(frameHeader, fp);
+        SWITCH_MODULE(fh->MT);
+    }
+    CONTINUE;
+HANDLE_GEN_RETURN:
+    {
+        // the return of the generator has popped its frame and has left the values over the reference
+        GeneratorFrame *generator = (GeneratorFrame*)(pc - 1 - offsetof(GeneratorFrame, Exit));
+        u16 rwc = generator->Header->RWC;
+        generator->PC = NULL;
+        for (u16 i = 0; i < rwc; i++)
+            sp[i - rwc - 2] = sp[i - rwc];
+        sp -= 2;
+        sp->UInt = 0;
+        sp += 1;
+        pc = generator->Return;
+    }
+    CONTINUE;
+#pragma endregion
 CALL_HEADER:
 /*
     [ pc_low ] [ pc_high ] [ fp_low ] [ fp_high ] [ mt_low ] [ mt_high ] [ awc | swc ] 
@@ -1454,31 +2252,8 @@ CALL_HEADER:
         u16 awc = header->AWC;
         u16 lwc = header->LWC;
         u16 swc = header->SWC;
-
-        for (u16 i = 0; i < awc; i++)
-            sp[LOCALS_OFFSET  + i] = sp[i - awc];
-
-        // push it right up the sp
-        Word *newFP = sp;
-        ((DWord*)(newFP + PC_OFFSET))->Ptr          = pc;
-        ((DWord*)(newFP + FP_OFFSET))->Ptr          = fp;
-        ((DWord*)(newFP + FH_OFFSET))->Ptr          = fh;
-
-        fp    = newFP;
-        sp    = newFP + LOCALS_OFFSET + lwc;
-        pc    = (Byte*)(header + 1);
-        fh    = header;
-        wpool = fh->MT->WordPool;
-        dpool = fh->MT->DWordPool;
-        fpool = fh->MT->FunctionPool;
-        spool = fh->MT->StringPool;
-        gpool = fh->MT->GlobalPool;
-
-        if(sp + swc >= context->StackTop)
-        {
-            printf("Stack overflow in function %s\n", fh->Signature);
-            return -1;
-        }
+        PUSH_CALL_FRAME(header, awc, lwc, swc);
+        SWITCH_MODULE(fh->MT);
     }
     CONTINUE;
 HANDLE_SYSCALL:
@@ -1495,13 +2270,16 @@ HANDLE_SYSCALL:
             &&HANDLE_SYSCALL_MEMMOV,
             &&HANDLE_SYSCALL_MEMCPY,
             &&HANDLE_SYSCALL_CLOCK,
-            &&HANDLE_SYSCALL_SCANF,
             &&HANDLE_SYSCALL_SQRT32,
             &&HANDLE_SYSCALL_SQRT64,
             &&HANDLE_SYSCALL_EXP32,
             &&HANDLE_SYSCALL_EXP64,
             &&HANDLE_SYSCALL_LOG32,
             &&HANDLE_SYSCALL_LOG64,
+            &&HANDLE_SYSCALL_SPAWN,
+            &&HANDLE_SYSCALL_JOIN,
+            &&HANDLE_SYSCALL_YIELD,
+            &&HANDLE_SYSCALL_PARFOR,
         };
         const void * const * syscallTable = SyscallPointers;
 
@@ -1514,145 +2292,710 @@ HANDLE_SYSCALL:
             return exitCode.Int;
         }
         HANDLE_SYSCALL_PRINT:
-        {
-            DWord str = *(DWord*)(sp - 2);
-            printf(str.Ptr);
-            sp -= 2;
+            SYSCALL_PRINT(sp);
             CONTINUE;
-        }
         HANDLE_SYSCALL_PRINTI:
-        {
-            DWord i = *(DWord*)(sp - 2);
-            printf("%ld", i.Int);
-            sp -= 2;
+            SYSCALL_PRINTI(sp);
             CONTINUE;
-        }
         HANDLE_SYSCALL_PRINTF:
-        {
-            DWord f = *(DWord*)(sp - 2);
-            printf("%lf", f.Float);
-            sp -= 2;
+            SYSCALL_PRINTF(sp);
             CONTINUE;
-        }
         HANDLE_SYSCALL_SCAN:
-        {
-            DWord buff = *(DWord*)(sp - 3);
-            Word  size = *(sp - 1);
-            
-            ch8 c = 0;
-            sz  i = 0;
-            while((c = getc(stdin)) != '\n' && i < size.UInt)
-            {
-                buff.BytePtr[i].Char = c;
-                i++;
-            }
-            sp -= 3;
+            SYSCALL_SCAN(sp);
             CONTINUE;
-        }
         HANDLE_SYSCALL_SCANI:
-        {
-            DWord i;
-            scanf("%ld", &i.Int);
-            *(DWord*)sp = i;
-            sp += 2;
+            SYSCALL_SCANI(sp);
             CONTINUE;
-        }
         HANDLE_SYSCALL_SCANF:
-        {
-            DWord f;
-            scanf("%lf", &f.Float);
-            *(DWord*)sp = f;
-            sp += 2;
+            SYSCALL_SCANF(sp);
             CONTINUE;
-        }
         HANDLE_SYSCALL_MEMMOV:
-        {
-            DWord dest = *(DWord*)(sp - 5);
-            DWord src  = *(DWord*)(sp - 3);
-            Word  n    = *        (sp - 1);
-            memmove(dest.Ptr, src.Ptr, n.UInt);
-            sp -= 5;
+            SYSCALL_MEMMOV(sp);
             CONTINUE;
-        }
         HANDLE_SYSCALL_MEMCPY:
-        {
-            DWord dest = *(DWord*)(sp - 5);
-            DWord src  = *(DWord*)(sp - 3);
-            Word  n    = *        (sp - 1);
-            memcpy(dest.Ptr, src.Ptr, n.UInt);
-            sp -= 5;
+            SYSCALL_MEMCPY(sp);
             CONTINUE;
-        }
         HANDLE_SYSCALL_CLOCK:
-        {
-            DWord t = { .Int = clock() };
-            *(DWord*)sp = t;
-            sp += 2;
+            SYSCALL_CLOCK(sp);
             CONTINUE;
-        }
         HANDLE_SYSCALL_SQRT32:
-        {
-            Word x = *(sp - 1);
-            Word y = { .Float = sqrtf(x.Float) };
-            *(sp - 1) = y;
+            SYSCALL_MATH_WORD(sp, sqrtf);
             CONTINUE;
-        }
         HANDLE_SYSCALL_SQRT64:
-        {
-            DWord x = *(DWord*)(sp - 2);
-            DWord y = { .Float = sqrt(x.Float) };
-            *(DWord*)(sp - 2) = y;
+            SYSCALL_MATH_DWORD(sp, sqrt);
             CONTINUE;
-        }
         HANDLE_SYSCALL_EXP32:
-        {
-            Word x = *(sp - 1);
-            Word y = { .Float = expf(x.Float) };
-            *(sp - 1) = y;
+            SYSCALL_MATH_WORD(sp, expf);
             CONTINUE;
-        }
         HANDLE_SYSCALL_EXP64:
+            SYSCALL_MATH_DWORD(sp, exp);
+            CONTINUE;
+        HANDLE_SYSCALL_LOG32:
+            SYSCALL_MATH_WORD(sp, logf);
+            CONTINUE;
+        HANDLE_SYSCALL_LOG64:
+            SYSCALL_MATH_DWORD(sp, log);
+            CONTINUE;
+        HANDLE_SYSCALL_SPAWN:
         {
-            DWord x = *(DWord*)(sp - 2);
-            DWord y = { .Float = exp(x.Float)  };
-            *(DWord*)(sp - 2) = y;
+            // the function is under its argument, the handle of the thread takes the place of both
+            FunctionHeader *function = ((DWord*)(sp - 4))->Ptr;
+            DWord argument = *(DWord*)(sp - 2);
+            ((DWord*)(sp - 4))->Ptr = SpawnThread(context, function, argument);
+            sp -= 2;
             CONTINUE;
         }
-        HANDLE_SYSCALL_LOG32:
+        HANDLE_SYSCALL_JOIN:
         {
-            Word x = *(sp - 1);
-            Word y = { .Float = logf(x.Float)  };
-            *(sp - 1) = y;
+            struct _GreenThread *thread = ((DWord*)(sp - 2))->Ptr;
+            i32 result;
+            // the join runs again when the scheduler resumes the thread
+            if(!ThreadResult(thread, &result))
+                WAIT_THREAD(thread);
+            (sp - 2)->Int = result;
+            sp -= 1;
             CONTINUE;
         }
-        HANDLE_SYSCALL_LOG64:
+        HANDLE_SYSCALL_YIELD:
+            YIELD_THREAD();
+        HANDLE_SYSCALL_PARFOR:
         {
-            DWord x = *(DWord*)(sp - 2);
-            DWord y = { .Float = log(x.Float) };
-            *(DWord*)(sp - 2) = y;
+            // the chunks this thread runs are called above the operand stack, the status takes the place of the function
+            FunctionHeader *function = ((DWord*)(sp - 5))->Ptr;
+            (sp - 5)->Int = ParallelFor(context, function, (sp - 3)->Int, (sp - 2)->Int, (sp - 1)->Int, sp);
+            sp -= 4;
             CONTINUE;
         }
     }
 HANDLE_RET:
-    Byte *prevPC =        ((DWord*)(fp + PC_OFFSET))->BytePtr; 
-    Word *prevFP =        ((DWord*)(fp + FP_OFFSET))->WordPtr;
-    FunctionHeader *prevFH = ((DWord*)(fp + FH_OFFSET))->Ptr;
-
-    Word *prevSP = fp - prevFH->AWC;
-    for (u16 i = 0; i < fh->RWC; i++)
-        prevSP[i] = sp[i - fh->RWC];
-    
-    sp    = prevSP + fh->RWC;
-    fp    = prevFP;
-    pc    = prevPC;
-    fh    = prevFH;
-    wpool = fh->MT->WordPool;
-    dpool = fh->MT->DWordPool;
-    spool = fh->MT->StringPool;
-    gpool = fh->MT->GlobalPool;
-    fpool = fh->MT->FunctionPool;
-
+    // the results of one and two words are returned in the tos register, the others at the frame pointer
+    if(fh->RWC == 1)
+    {
+        tos.UInt = (sp - 1)->UInt;
+        POP_CALL_FRAME(1);
+        SWITCH_MODULE(fh->MT);
+        CONTINUE_WORD;
+    }
+    if(fh->RWC == 2)
+    {
+        tos = *(DWord*)(sp - 2);
+        POP_CALL_FRAME(2);
+        SWITCH_MODULE(fh->MT);
+        CONTINUE_DWORD;
+    }
+    {
+        u16 rwc = fh->RWC;
+        for (u16 i = 0; i < rwc; i++)
+            fp[i] = sp[i - rwc];
+        POP_CALL_FRAME(rwc);
+    }
+    SWITCH_MODULE(fh->MT);
+    CONTINUE;
+HANDLE_RET_LEAF:
+    // a leaf is called only from its own module, the pools of the caller are already loaded
+    if(fh->RWC == 1)
+    {
+        tos.UInt = (sp - 1)->UInt;
+        POP_LEAF_FRAME(1);
+        CONTINUE_WORD;
+    }
+    if(fh->RWC == 2)
+    {
+        tos = *(DWord*)(sp - 2);
+        POP_LEAF_FRAME(2);
+        CONTINUE_DWORD;
+    }
+    {
+        u16 rwc = fh->RWC;
+        for (u16 i = 0; i < rwc; i++)
+            fp[i] = sp[i - rwc];
+        POP_LEAF_FRAME(rwc);
+    }
+    CONTINUE;
+#pragma endregion
+#pragma region Superinstructions
+HANDLE_LOAD_GLOB_WORD:
+    {
+        Word *g = *(gpool + iNextU8(&pc));
+        TOS_PUSH_WORD(sp, tos, *g);
+    }
+    CONTINUE_WORD;
+HANDLE_LOAD_GLOB_DWORD:
+    {
+        DWord *g = *(gpool + iNextU8(&pc));
+        TOS_PUSH_DWORD(sp, tos, *g);
+    }
+    CONTINUE_DWORD;
+HANDLE_PUSH_WORD_WORD:
+    {
+        sz a = iNextU8(&pc);
+        sz b = iNextU8(&pc);
+        LOCAL_PUSH_WORD(sp, fp, a);
+        TOS_PUSH_WORD(sp, tos, *(fp + LOCALS_OFFSET + b));
+    }
+    CONTINUE_WORD;
+HANDLE_ADD_I32_LOC_IMM:
+    {
+        sz  s = iNextU8(&pc);
+        i32 v = (i32) iNextI8(&pc);
+        sz  d = iNextU8(&pc);
+        (fp + LOCALS_OFFSET + d)->Int = (fp + LOCALS_OFFSET + s)->Int + v;
+    }
+    CONTINUE;
+HANDLE_ADD_I32_LOC_LOC:
+    {
+        sz a = iNextU8(&pc);
+        sz b = iNextU8(&pc);
+        sz d = iNextU8(&pc);
+        (fp + LOCALS_OFFSET + d)->Int = (fp + LOCALS_OFFSET + a)->Int + (fp + LOCALS_OFFSET + b)->Int;
+    }
+    CONTINUE;
+HANDLE_JMP_WORD_EQ:
+    COMPARE_JUMP_WORD(sp, pc, Int, ==);
+    CONTINUE;
+HANDLE_JMP_WORD_NE:
+    COMPARE_JUMP_WORD(sp, pc, Int, !=);
+    CONTINUE;
+HANDLE_JMP_I32_GT:
+    COMPARE_JUMP_WORD(sp, pc, Int, >);
+    CONTINUE;
+HANDLE_JMP_I32_LT:
+    COMPARE_JUMP_WORD(sp, pc, Int, <);
+    CONTINUE;
+HANDLE_JMP_I32_GE:
+    COMPARE_JUMP_WORD(sp, pc, Int, >=);
+    CONTINUE;
+HANDLE_JMP_I32_LE:
+    COMPARE_JUMP_WORD(sp, pc, Int, <=);
+    CONTINUE;
+#pragma endregion
+#pragma region Top of stack cache
+HANDLE_SPILL_WORD:
+    TOS_SPILL_WORD(sp, tos);
+    goto *InstructionPointers[op];
+HANDLE_SPILL_DWORD:
+    TOS_SPILL_DWORD(sp, tos);
+    goto *InstructionPointers[op];
+    TOS_SPILL_HANDLERS(PUSH_WORD);
+    TOS_SPILL_HANDLERS(PUSH_WORD_L);
+    TOS_SPILL_HANDLERS(PUSH_DWORD);
+    TOS_SPILL_HANDLERS(PUSH_DWORD_L);
+    TOS_SPILL_HANDLERS(PUSH_REF);
+    TOS_SPILL_HANDLERS(PUSH_I32_V);
+    TOS_SPILL_HANDLERS(PUSH_I64_V);
+    TOS_SPILL_HANDLERS(PUSH_F32_1);
+    TOS_SPILL_HANDLERS(PUSH_F32_2);
+    TOS_SPILL_HANDLERS(PUSH_F64_1);
+    TOS_SPILL_HANDLERS(PUSH_F64_2);
+    TOS_SPILL_HANDLERS(PUSH_I32);
+    TOS_SPILL_HANDLERS(PUSH_I64);
+    TOS_SPILL_HANDLERS(PUSH_CONST_WORD);
+    TOS_SPILL_HANDLERS(PUSH_CONST_WORD_W);
+    TOS_SPILL_HANDLERS(PUSH_CONST_DWORD);
+    TOS_SPILL_HANDLERS(PUSH_CONST_DWORD_W);
+    TOS_SPILL_HANDLERS(PUSH_CONST_STR);
+    TOS_SPILL_HANDLERS(PUSH_CONST_STR_W);
+    TOS_SPILL_HANDLERS(PUSH_GLOB_REF);
+    TOS_SPILL_HANDLERS(PUSH_GLOB_REF_W);
+    TOS_SPILL_HANDLERS(PUSH_TLS_REF);
+    TOS_SPILL_HANDLERS(PUSH_TLS_REF_W);
+    TOS_SPILL_HANDLERS(PUSH_FUNC);
+    TOS_SPILL_HANDLERS(LOAD_GLOB_WORD);
+    TOS_SPILL_HANDLERS(LOAD_GLOB_DWORD);
+    TOS_SPILL_HANDLERS(PUSH_WORD_WORD);
+// a result already in the tos register is returned as it is, nothing is written to the caller stack
+HANDLE_W_RET:
+    if(fh->RWC != 1)
+    {
+        TOS_SPILL_WORD(sp, tos);
+        goto HANDLE_RET;
+    }
+    POP_CALL_FRAME(1);
+    SWITCH_MODULE(fh->MT);
+    CONTINUE_WORD;
+HANDLE_W_RET_LEAF:
+    if(fh->RWC != 1)
+    {
+        TOS_SPILL_WORD(sp, tos);
+        goto HANDLE_RET_LEAF;
+    }
+    POP_LEAF_FRAME(1);
+    CONTINUE_WORD;
+HANDLE_D_RET:
+    if(fh->RWC != 2)
+    {
+        TOS_SPILL_DWORD(sp, tos);
+        goto HANDLE_RET;
+    }
+    POP_CALL_FRAME(2);
+    SWITCH_MODULE(fh->MT);
+    CONTINUE_DWORD;
+HANDLE_D_RET_LEAF:
+    if(fh->RWC != 2)
+    {
+        TOS_SPILL_DWORD(sp, tos);
+        goto HANDLE_RET_LEAF;
+    }
+    POP_LEAF_FRAME(2);
+    CONTINUE_DWORD;
+HANDLE_W_POP_WORD:
+    {
+        sz l = iNextU8(&pc);
+        *(fp + LOCALS_OFFSET + l) = tos.Word[0];
+        sp -= 1;
+    }
+    CONTINUE_EMPTY;
+HANDLE_W_POP_WORD_L:
+    {
+        sz l = op - OP_POP_WORD_0;
+        *(fp + LOCALS_OFFSET + l) = tos.Word[0];
+        sp -= 1;
+    }
+    CONTINUE_EMPTY;
+HANDLE_W_ADD_I32:
+    TOS_BINARY_OPERATION_WORD(sp, tos, Int, +);
+    CONTINUE_WORD;
+HANDLE_W_ADD_F32:
+    TOS_BINARY_OPERATION_WORD(sp, tos, Float, +);
+    CONTINUE_WORD;
+HANDLE_W_SUB_I32:
+    TOS_BINARY_OPERATION_WORD(sp, tos, Int, -);
+    CONTINUE_WORD;
+HANDLE_W_SUB_F32:
+    TOS_BINARY_OPERATION_WORD(sp, tos, Float, -);
+    CONTINUE_WORD;
+HANDLE_W_MUL_I32:
+    TOS_BINARY_OPERATION_WORD(sp, tos, Int, *);
+    CONTINUE_WORD;
+HANDLE_W_MUL_U32:
+    TOS_BINARY_OPERATION_WORD(sp, tos, UInt, *);
+    CONTINUE_WORD;
+HANDLE_W_MUL_F32:
+    TOS_BINARY_OPERATION_WORD(sp, tos, Float, *);
+    CONTINUE_WORD;
+HANDLE_W_DIV_I32:
+    TOS_BINARY_OPERATION_WORD(sp, tos, Int, /);
+    CONTINUE_WORD;
+HANDLE_W_DIV_U32:
+    TOS_BINARY_OPERATION_WORD(sp, tos, UInt, /);
+    CONTINUE_WORD;
+HANDLE_W_DIV_F32:
+    TOS_BINARY_OPERATION_WORD(sp, tos, Float, /);
+    CONTINUE_WORD;
+HANDLE_W_REM_I32:
+    TOS_BINARY_OPERATION_WORD(sp, tos, Int, %);
+    CONTINUE_WORD;
+HANDLE_W_REM_U32:
+    TOS_BINARY_OPERATION_WORD(sp, tos, UInt, %);
+    CONTINUE_WORD;
+HANDLE_W_AND_WORD:
+    TOS_BINARY_OPERATION_WORD(sp, tos, Int, &);
+    CONTINUE_WORD;
+HANDLE_W_OR_WORD:
+    TOS_BINARY_OPERATION_WORD(sp, tos, Int, |);
+    CONTINUE_WORD;
+HANDLE_W_XOR_WORD:
+    TOS_BINARY_OPERATION_WORD(sp, tos, Int, ^);
+    CONTINUE_WORD;
+HANDLE_W_SHL_WORD:
+    TOS_BINARY_OPERATION_WORD(sp, tos, Int, <<);
+    CONTINUE_WORD;
+HANDLE_W_SHR_I32:
+    TOS_BINARY_OPERATION_WORD(sp, tos, Int, >>);
+    CONTINUE_WORD;
+HANDLE_W_SHR_U32:
+    TOS_BINARY_OPERATION_WORD(sp, tos, UInt, >>);
+    CONTINUE_WORD;
+HANDLE_W_CMP_WORD_EQ:
+    TOS_BINARY_OPERATION_WORD(sp, tos, Int, ==);
+    CONTINUE_WORD;
+HANDLE_W_CMP_WORD_NE:
+    TOS_BINARY_OPERATION_WORD(sp, tos, Int, !=);
+    CONTINUE_WORD;
+HANDLE_W_CMP_I32_GT:
+    TOS_BINARY_OPERATION_WORD(sp, tos, Int, >);
+    CONTINUE_WORD;
+HANDLE_W_CMP_U32_GT:
+    TOS_BINARY_OPERATION_WORD(sp, tos, UInt, >);
+    CONTINUE_WORD;
+HANDLE_W_CMP_F32_GT:
+    TOS_BINARY_OPERATION_WORD(sp, tos, Float, >);
+    CONTINUE_WORD;
+HANDLE_W_CMP_I32_LT:
+    TOS_BINARY_OPERATION_WORD(sp, tos, Int, <);
+    CONTINUE_WORD;
+HANDLE_W_CMP_U32_LT:
+    TOS_BINARY_OPERATION_WORD(sp, tos, UInt, <);
+    CONTINUE_WORD;
+HANDLE_W_CMP_F32_LT:
+    TOS_BINARY_OPERATION_WORD(sp, tos, Float, <);
+    CONTINUE_WORD;
+HANDLE_W_CMP_I32_GE:
+    TOS_BINARY_OPERATION_WORD(sp, tos, Int, >=);
+    CONTINUE_WORD;
+HANDLE_W_CMP_U32_GE:
+    TOS_BINARY_OPERATION_WORD(sp, tos, UInt, >=);
+    CONTINUE_WORD;
+HANDLE_W_CMP_F32_GE:
+    TOS_BINARY_OPERATION_WORD(sp, tos, Float, >=);
+    CONTINUE_WORD;
+HANDLE_W_CMP_I32_LE:
+    TOS_BINARY_OPERATION_WORD(sp, tos, Int, <=);
+    CONTINUE_WORD;
+HANDLE_W_CMP_U32_LE:
+    TOS_BINARY_OPERATION_WORD(sp, tos, UInt, <=);
+    CONTINUE_WORD;
+HANDLE_W_CMP_F32_LE:
+    TOS_BINARY_OPERATION_WORD(sp, tos, Float, <=);
+    CONTINUE_WORD;
+HANDLE_W_NEG_I32:
+    TOS_UNARY_OPERATION_WORD(tos, Int, -);
+    CONTINUE_WORD;
+HANDLE_W_NEG_F32:
+    TOS_UNARY_OPERATION_WORD(tos, Float, -);
+    CONTINUE_WORD;
+HANDLE_W_SQRT_F32:
+    TOS_MATH_WORD(tos, sqrtf);
+    CONTINUE_WORD;
+HANDLE_W_EXP_F32:
+    TOS_MATH_WORD(tos, expf);
+    CONTINUE_WORD;
+HANDLE_W_LOG_F32:
+    TOS_MATH_WORD(tos, logf);
+    CONTINUE_WORD;
+HANDLE_W_MEMMOV:
+    {
+        // the size is in the tos register
+        DWord dest = *(DWord*)(sp - 5);
+        DWord src  = *(DWord*)(sp - 3);
+        memmove(dest.Ptr, src.Ptr, tos.Word[0].UInt);
+        sp -= 5;
+    }
+    CONTINUE_EMPTY;
+HANDLE_W_MEMCPY:
+    {
+        DWord dest = *(DWord*)(sp - 5);
+        DWord src  = *(DWord*)(sp - 3);
+        memcpy(dest.Ptr, src.Ptr, tos.Word[0].UInt);
+        sp -= 5;
+    }
+    CONTINUE_EMPTY;
+HANDLE_W_NOT_WORD:
+    TOS_UNARY_OPERATION_WORD(tos, Int, ~);
+    CONTINUE_WORD;
+HANDLE_W_CMP_NOT:
+    TOS_UNARY_OPERATION_WORD(tos, Int, !);
+    CONTINUE_WORD;
+HANDLE_W_I32_TO_I8:
+    TOS_CAST_WORD_WORD(tos, Int, Int, i8);
+    CONTINUE_WORD;
+HANDLE_W_I32_TO_I16:
+    TOS_CAST_WORD_WORD(tos, Int, Int, i16);
+    CONTINUE_WORD;
+HANDLE_W_I32_TO_F32:
+    TOS_CAST_WORD_WORD(tos, Int, Float, f32);
+    CONTINUE_WORD;
+HANDLE_W_F32_TO_I32:
+    TOS_CAST_WORD_WORD(tos, Float, Int, i32);
+    CONTINUE_WORD;
+HANDLE_W_I32_TO_I64:
+    TOS_CAST_WORD_DWORD(sp, tos, Int, Int, i64);
+    CONTINUE_DWORD;
+HANDLE_W_I32_TO_F64:
+    TOS_CAST_WORD_DWORD(sp, tos, Int, Float, f64);
+    CONTINUE_DWORD;
+HANDLE_W_F32_TO_I64:
+    TOS_CAST_WORD_DWORD(sp, tos, Float, Int, i64);
+    CONTINUE_DWORD;
+HANDLE_W_F32_TO_F64:
+    TOS_CAST_WORD_DWORD(sp, tos, Float, Float, f64);
+    CONTINUE_DWORD;
+HANDLE_W_JMP_WORD_EQ:
+    TOS_COMPARE_JUMP_WORD(sp, tos, pc, Int, ==);
+    CONTINUE_EMPTY;
+HANDLE_W_JMP_WORD_NE:
+    TOS_COMPARE_JUMP_WORD(sp, tos, pc, Int, !=);
+    CONTINUE_EMPTY;
+HANDLE_W_JMP_I32_GT:
+    TOS_COMPARE_JUMP_WORD(sp, tos, pc, Int, >);
+    CONTINUE_EMPTY;
+HANDLE_W_JMP_I32_LT:
+    TOS_COMPARE_JUMP_WORD(sp, tos, pc, Int, <);
+    CONTINUE_EMPTY;
+HANDLE_W_JMP_I32_GE:
+    TOS_COMPARE_JUMP_WORD(sp, tos, pc, Int, >=);
+    CONTINUE_EMPTY;
+HANDLE_W_JMP_I32_LE:
+    TOS_COMPARE_JUMP_WORD(sp, tos, pc, Int, <=);
+    CONTINUE_EMPTY;
+HANDLE_W_JMP_IF:
+    {
+        i16 o = iNextI16(&pc);
+        sp -= 1;
+        if(tos.Word[0].Int)
+        {
+            pc += o;
+            BACK_EDGE(o);
+        }
+    }
+    CONTINUE_EMPTY;
+HANDLE_W_DUP_WORD:
+    TOS_SPILL_WORD(sp, tos);
+    sp += 1;
+    CONTINUE_WORD;
+HANDLE_W_STORE_WORD:
+    {
+        DWord ref = *(DWord*)(sp - 3);
+        *ref.WordPtr = tos.Word[0];
+        sp -= 3;
+    }
+    CONTINUE_EMPTY;
+HANDLE_D_POP_DWORD:
+    {
+        sz l = iNextU8(&pc);
+        *(DWord*)(fp + LOCALS_OFFSET + l) = tos;
+        sp -= 2;
+    }
+    CONTINUE_EMPTY;
+HANDLE_D_POP_DWORD_L:
+    {
+        sz l = op - OP_POP_DWORD_0;
+        *(DWord*)(fp + LOCALS_OFFSET + l) = tos;
+        sp -= 2;
+    }
+    CONTINUE_EMPTY;
+HANDLE_D_ADD_I64:
+    TOS_BINARY_OPERATION_DWORD(sp, tos, Int, +);
+    CONTINUE_DWORD;
+HANDLE_D_ADD_F64:
+    TOS_BINARY_OPERATION_DWORD(sp, tos, Float, +);
+    CONTINUE_DWORD;
+HANDLE_D_SUB_I64:
+    TOS_BINARY_OPERATION_DWORD(sp, tos, Int, -);
+    CONTINUE_DWORD;
+HANDLE_D_SUB_F64:
+    TOS_BINARY_OPERATION_DWORD(sp, tos, Float, -);
+    CONTINUE_DWORD;
+HANDLE_D_MUL_I64:
+    TOS_BINARY_OPERATION_DWORD(sp, tos, Int, *);
+    CONTINUE_DWORD;
+HANDLE_D_MUL_U64:
+    TOS_BINARY_OPERATION_DWORD(sp, tos, UInt, *);
+    CONTINUE_DWORD;
+HANDLE_D_MUL_F64:
+    TOS_BINARY_OPERATION_DWORD(sp, tos, Float, *);
+    CONTINUE_DWORD;
+HANDLE_D_DIV_I64:
+    TOS_BINARY_OPERATION_DWORD(sp, tos, Int, /);
+    CONTINUE_DWORD;
+HANDLE_D_DIV_U64:
+    TOS_BINARY_OPERATION_DWORD(sp, tos, UInt, /);
+    CONTINUE_DWORD;
+HANDLE_D_DIV_F64:
+    TOS_BINARY_OPERATION_DWORD(sp, tos, Float, /);
+    CONTINUE_DWORD;
+HANDLE_D_REM_I64:
+    TOS_BINARY_OPERATION_DWORD(sp, tos, Int, %);
+    CONTINUE_DWORD;
+HANDLE_D_REM_U64:
+    TOS_BINARY_OPERATION_DWORD(sp, tos, UInt, %);
+    CONTINUE_DWORD;
+HANDLE_D_AND_DWORD:
+    TOS_BINARY_OPERATION_DWORD(sp, tos, Int, &);
+    CONTINUE_DWORD;
+HANDLE_D_OR_DWORD:
+    TOS_BINARY_OPERATION_DWORD(sp, tos, Int, |);
+    CONTINUE_DWORD;
+HANDLE_D_XOR_DWORD:
+    TOS_BINARY_OPERATION_DWORD(sp, tos, Int, ^);
+    CONTINUE_DWORD;
+HANDLE_D_SHL_DWORD:
+    TOS_BINARY_OPERATION_DWORD(sp, tos, Int, <<);
+    CONTINUE_DWORD;
+HANDLE_D_SHR_I64:
+    TOS_BINARY_OPERATION_DWORD(sp, tos, Int, >>);
+    CONTINUE_DWORD;
+HANDLE_D_SHR_U64:
+    TOS_BINARY_OPERATION_DWORD(sp, tos, UInt, >>);
+    CONTINUE_DWORD;
+HANDLE_D_CMP_DWORD_EQ:
+    TOS_BINARY_OPERATION_DWORD(sp, tos, Int, ==);
+    CONTINUE_DWORD;
+HANDLE_D_CMP_DWORD_NE:
+    TOS_BINARY_OPERATION_DWORD(sp, tos, Int, !=);
+    CONTINUE_DWORD;
+HANDLE_D_CMP_I64_GT:
+    TOS_BINARY_OPERATION_DWORD(sp, tos, Int, >);
+    CONTINUE_DWORD;
+HANDLE_D_CMP_U64_GT:
+    TOS_BINARY_OPERATION_DWORD(sp, tos, UInt, >);
+    CONTINUE_DWORD;
+HANDLE_D_CMP_F64_GT:
+    TOS_BINARY_OPERATION_DWORD(sp, tos, Float, >);
+    CONTINUE_DWORD;
+HANDLE_D_CMP_I64_LT:
+    TOS_BINARY_OPERATION_DWORD(sp, tos, Int, <);
+    CONTINUE_DWORD;
+HANDLE_D_CMP_U64_LT:
+    TOS_BINARY_OPERATION_DWORD(sp, tos, UInt, <);
+    CONTINUE_DWORD;
+HANDLE_D_CMP_F64_LT:
+    TOS_BINARY_OPERATION_DWORD(sp, tos, Float, <);
+    CONTINUE_DWORD;
+HANDLE_D_CMP_I64_GE:
+    TOS_BINARY_OPERATION_DWORD(sp, tos, Int, >=);
+    CONTINUE_DWORD;
+HANDLE_D_CMP_U64_GE:
+    TOS_BINARY_OPERATION_DWORD(sp, tos, UInt, >=);
+    CONTINUE_DWORD;
+HANDLE_D_CMP_F64_GE:
+    TOS_BINARY_OPERATION_DWORD(sp, tos, Float, >=);
+    CONTINUE_DWORD;
+HANDLE_D_CMP_I64_LE:
+    TOS_BINARY_OPERATION_DWORD(sp, tos, Int, <=);
+    CONTINUE_DWORD;
+HANDLE_D_CMP_U64_LE:
+    TOS_BINARY_OPERATION_DWORD(sp, tos, UInt, <=);
+    CONTINUE_DWORD;
+HANDLE_D_CMP_F64_LE:
+    TOS_BINARY_OPERATION_DWORD(sp, tos, Float, <=);
+    CONTINUE_DWORD;
+HANDLE_D_NEG_I64:
+    TOS_UNARY_OPERATION_DWORD(tos, Int, -);
+    CONTINUE_DWORD;
+HANDLE_D_NEG_F64:
+    TOS_UNARY_OPERATION_DWORD(tos, Float, -);
+    CONTINUE_DWORD;
+HANDLE_D_SQRT_F64:
+    TOS_MATH_DWORD(tos, sqrt);
+    CONTINUE_DWORD;
+HANDLE_D_EXP_F64:
+    TOS_MATH_DWORD(tos, exp);
+    CONTINUE_DWORD;
+HANDLE_D_LOG_F64:
+    TOS_MATH_DWORD(tos, log);
+    CONTINUE_DWORD;
+HANDLE_D_NOT_DWORD:
+    TOS_UNARY_OPERATION_DWORD(tos, Int, ~);
+    CONTINUE_DWORD;
+HANDLE_D_I64_TO_F64:
+    TOS_CAST_DWORD_DWORD(tos, Int, Float, f64);
+    CONTINUE_DWORD;
+HANDLE_D_F64_TO_I64:
+    TOS_CAST_DWORD_DWORD(tos, Float, Int, i64);
+    CONTINUE_DWORD;
+HANDLE_D_I64_TO_I32:
+    TOS_CAST_DWORD_WORD(sp, tos, Int, Int, i32);
+    CONTINUE_WORD;
+HANDLE_D_I64_TO_F32:
+    TOS_CAST_DWORD_WORD(sp, tos, Int, Float, f32);
+    CONTINUE_WORD;
+HANDLE_D_F64_TO_I32:
+    TOS_CAST_DWORD_WORD(sp, tos, Float, Int, i32);
+    CONTINUE_WORD;
+HANDLE_D_F64_TO_F32:
+    TOS_CAST_DWORD_WORD(sp, tos, Float, Float, f32);
+    CONTINUE_WORD;
+HANDLE_D_DUP_DWORD:
+    TOS_SPILL_DWORD(sp, tos);
+    sp += 2;
+    CONTINUE_DWORD;
+HANDLE_D_LOAD_WORD:
+    tos.UInt = tos.WordPtr->UInt;
+    sp -= 1;
+    CONTINUE_WORD;
+HANDLE_D_LOAD_DWORD:
+    tos = *tos.DWordPtr;
+    CONTINUE_DWORD;
+HANDLE_D_STORE_DWORD:
+    {
+        DWord ref = *(DWord*)(sp - 4);
+        *ref.DWordPtr = tos;
+        sp -= 4;
+    }
+    CONTINUE_EMPTY;
+#pragma endregion
+#pragma region Extended page
+HANDLE_EXTENDED:
+    op = pc->UInt;
+    pc += 1;
+    goto *ExtendedPointers[op];
+HANDLE_POPCNT_I32:
+    BIT_COUNT_WORD(sp, __builtin_popcount(v));
+    CONTINUE;
+HANDLE_POPCNT_I64:
+    BIT_COUNT_DWORD(sp, __builtin_popcountll(v));
+    CONTINUE;
+HANDLE_CLZ_I32:
+    BIT_COUNT_WORD(sp, v ? __builtin_clz(v) : 32);
+    CONTINUE;
+HANDLE_CLZ_I64:
+    BIT_COUNT_DWORD(sp, v ? __builtin_clzll(v) : 64);
+    CONTINUE;
+HANDLE_CTZ_I32:
+    BIT_COUNT_WORD(sp, v ? __builtin_ctz(v) : 32);
+    CONTINUE;
+HANDLE_CTZ_I64:
+    BIT_COUNT_DWORD(sp, v ? __builtin_ctzll(v) : 64);
+    CONTINUE;
+HANDLE_ATOMIC_LOAD_WORD:
+    ATOMIC_LOAD(sp, u32, 1);
+    CONTINUE;
+HANDLE_ATOMIC_LOAD_DWORD:
+    ATOMIC_LOAD(sp, u64, 2);
+    CONTINUE;
+HANDLE_ATOMIC_STORE_WORD:
+    ATOMIC_STORE(sp, u32, 1);
+    CONTINUE;
+HANDLE_ATOMIC_STORE_DWORD:
+    ATOMIC_STORE(sp, u64, 2);
+    CONTINUE;
+HANDLE_CAS_WORD:
+    ATOMIC_CAS(sp, u32, 1);
+    CONTINUE;
+HANDLE_CAS_DWORD:
+    ATOMIC_CAS(sp, u64, 2);
+    CONTINUE;
+HANDLE_FETCH_ADD_WORD:
+    ATOMIC_FETCH(sp, u32, 1, __atomic_fetch_add);
+    CONTINUE;
+HANDLE_FETCH_ADD_DWORD:
+    ATOMIC_FETCH(sp, u64, 2, __atomic_fetch_add);
+    CONTINUE;
+HANDLE_FETCH_SUB_WORD:
+    ATOMIC_FETCH(sp, u32, 1, __atomic_fetch_sub);
+    CONTINUE;
+HANDLE_FETCH_SUB_DWORD:
+    ATOMIC_FETCH(sp, u64, 2, __atomic_fetch_sub);
+    CONTINUE;
+HANDLE_FETCH_AND_WORD:
+    ATOMIC_FETCH(sp, u32, 1, __atomic_fetch_and);
+    CONTINUE;
+HANDLE_FETCH_AND_DWORD:
+    ATOMIC_FETCH(sp, u64, 2, __atomic_fetch_and);
+    CONTINUE;
+HANDLE_FETCH_OR_WORD:
+    ATOMIC_FETCH(sp, u32, 1, __atomic_fetch_or);
+    CONTINUE;
+HANDLE_FETCH_OR_DWORD:
+    ATOMIC_FETCH(sp, u64, 2, __atomic_fetch_or);
+    CONTINUE;
+HANDLE_FETCH_XOR_WORD:
+    ATOMIC_FETCH(sp, u32, 1, __atomic_fetch_xor);
+    CONTINUE;
+HANDLE_FETCH_XOR_DWORD:
+    ATOMIC_FETCH(sp, u64, 2, __atomic_fetch_xor);
+    CONTINUE;
+HANDLE_FENCE:
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
     CONTINUE;
 #pragma endregion
+#ifdef EXECUTE_FUEL
+SUSPEND:
+    if(fh->Leaf)
+        PUSH_FRAME_HEADER(FRAME_HEADER(fp, fh->LWC), fp, leafPC, leafFP, leafFH, fbase);
+    context->Suspended = (ExecutionState){ pc, sp, fp, fh };
+    return EXECUTE_SUSPENDED;
+#endif
     return 1;
 }
\ No newline at end of file
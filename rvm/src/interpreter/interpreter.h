@@ -0,0 +1,207 @@
+#pragma once
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <math.h>
+
+#include "raiu/raiu.h"
+
+/*
+    Layout of a frame, shared by the interpreters and the compiled code
+    [ local0 ] ... [ localN ]
+    [ pc_low ] [ pc_high ] [ fp ] [ fh ]
+    [ stack0 ] ... [ stackM ]
+    The frame pointer points to the first local, the arguments the caller left on its stack are the first locals of the
+    callee in place, so a call copies nothing. The header is after the LWC locals and the results of a call take the 
+    place of the arguments.
+    The header is compact, fp is the distance in words of the frame from the frame of the caller and fh is the offset
+    in dwords of the header of the caller from the functions buffer, only the return pc is a full pointer.
+*/
+#define LOCALS_OFFSET 0
+// offsets in the frame header
+#define PC_OFFSET 0
+#define FP_OFFSET 2
+#define FH_OFFSET 3
+#define FRAME_HEADER_SIZE 4
+#define FRAME_HEADER(fp, lwc) ((fp) + (lwc))
+// writes the frame header of a call from the frame fp to the frame newFP, fbase is the functions buffer
+#define PUSH_FRAME_HEADER(frameHeader, newFP, pc, fp, fh, fbase) do \
+{ \
+    ((DWord*)((frameHeader) + PC_OFFSET))->Ptr = (pc); \
+    ((frameHeader) + FP_OFFSET)->UInt = (u32)((newFP) - (fp)); \
+    ((frameHeader) + FH_OFFSET)->UInt = (u32)(((const Byte*)(fh) - (fbase)) / SIZEOF_DWORD); \
+} while (0)
+#define FRAME_PC(frameHeader)        (((DWord*)((frameHeader) + PC_OFFSET))->Ptr)
+#define FRAME_FP(frameHeader, fp)    ((fp) - ((frameHeader) + FP_OFFSET)->UInt)
+#define FRAME_FH(frameHeader, fbase) ((FunctionHeader*)((fbase) + (sz)((frameHeader) + FH_OFFSET)->UInt * SIZEOF_DWORD))
+
+/*
+    The stack grows on the faults after its top and is followed by a guard region, see interpreter/stack.c. A call 
+    touches the word after the frame of the callee instead of comparing it with the top of the stack, if the frame does
+    not fit the limit the probe faults in the guard and the signal handler finds the callee header in the probe register.
+    The address of every probe is kept in its own section, so the handler trusts the register only for their faults.
+*/
+#if defined(__x86_64__) && defined(__linux__)
+#define STACK_PROBE_REGISTER REG_RAX
+#define STACK_PROBE(limit, header) __asm__ volatile("1: movq %%rax, (%0)\n\t" \
+                                                    ".pushsection rvm_stack_probes, \"aw\"\n\t" \
+                                                    ".balign 8\n\t" \
+                                                    ".quad 1b\n\t" \
+                                                    ".popsection" : : "r"(limit), "a"(header) : "memory")
+#else
+#define STACK_PROBE(limit, header) do \
+{ \
+    if((Word*)(limit) >= context->StackTop && !GrowStack(context, limit)) \
+    { \
+        printf("Stack overflow in function %s\n", (header)->Signature); \
+        return -1; \
+    } \
+} while (0)
+#endif
+
+/*
+    The saved frame of a generator, the locals and the frame header of the function are followed by the words on its stack
+    when it yielded, as they are in the stack, so a resume and a yield copy them at once.
+    A resume pushes the frame with the exit as return address, so the return of the function runs OP_GEN_RETURN, which
+    finds the generator from the address of its exit.
+*/
+typedef struct _GeneratorFrame
+{
+    Byte           *PC;     // the instruction after the yield, Exit while it runs, NULL once the function has returned
+    Byte           *Return; // the instruction after the resume that runs the generator
+    FunctionHeader *Header;
+    u32             StackWords;
+    Byte            Exit[4];
+    Word            Frame[];
+} GeneratorFrame;
+
+/*
+    A cell of the threaded code, an instruction is the address of its handler followed by a cell for each operand,
+    see linker/threader.c for the operands of every instruction
+*/
+typedef union _Cell
+{
+    const void   *Handler;
+    union _Cell  *Target; // jump target
+    sz            Offset; // byte offset of a slot from the frame pointer
+    i64           Int;
+    u64           UInt;
+    Word          Word;
+    DWord         DWord;
+    void         *Ptr;
+} Cell;
+
+/*
+    Makes the pools of a module the current ones, the pool registers are reloaded only when the module changes, so the
+    calls and returns inside a module do not touch them
+*/
+#define SWITCH_MODULE(module) do \
+{ \
+    const ModuleTable *m = (module); \
+    if(m != mt) \
+    { \
+        mt    = m; \
+        wpool = m->WordPool; \
+        dpool = m->DWordPool; \
+        spool = m->StringPool; \
+        gpool = m->GlobalPool; \
+        fpool = m->FunctionPool; \
+    } \
+} while (0)
+
+static inline u8 iNextU8(Byte **pc)
+{
+    u8 v = (*pc)->UInt;
+    *pc += 1;
+    return v;
+}
+static inline u16 iNextU16(Byte **pc)
+{
+    u16 v = ((*pc + 0)->UInt << 0)|
+            ((*pc + 1)->UInt << 8);
+    *pc += 2;
+    return v;
+}
+static inline i8 iNextI8(Byte **pc)
+{
+    i8 v = (*pc)->UInt;
+    *pc += 1;
+    return v;
+}
+static inline i16 iNextI16(Byte **pc)
+{
+    i16 v = ((*pc + 0)->UInt << 0)|
+            ((*pc + 1)->UInt << 8);
+    *pc += 2;
+    return v;
+}
+
+#pragma region System calls
+// The system calls work on the stack pointer sp, the exit call is handled by the interpreters. They take the address of
+// no local, so a handler that runs them can still end with a tail call
+#define SYSCALL_PRINT(sp) do { \
+    DWord str = *(DWord*)(sp - 2); \
+    printf(str.Ptr); \
+    sp -= 2; \
+} while(0)
+#define SYSCALL_PRINTI(sp) do { \
+    DWord i = *(DWord*)(sp - 2); \
+    printf("%ld", i.Int); \
+    sp -= 2; \
+} while(0)
+#define SYSCALL_PRINTF(sp) do { \
+    DWord f = *(DWord*)(sp - 2); \
+    printf("%lf", f.Float); \
+    sp -= 2; \
+} while(0)
+#define SYSCALL_SCAN(sp) do { \
+    DWord buff = *(DWord*)(sp - 3); \
+    Word  size = *(sp - 1); \
+    ch8 c = 0; \
+    sz  i = 0; \
+    while((c = getc(stdin)) != '\n' && i < size.UInt) \
+    { \
+        buff.BytePtr[i].Char = c; \
+        i++; \
+    } \
+    sp -= 3; \
+} while(0)
+#define SYSCALL_SCANI(sp) do { \
+    scanf("%ld", &((DWord*)sp)->Int); \
+    sp += 2; \
+} while(0)
+#define SYSCALL_SCANF(sp) do { \
+    scanf("%lf", &((DWord*)sp)->Float); \
+    sp += 2; \
+} while(0)
+#define SYSCALL_MEMMOV(sp) do { \
+    DWord dest = *(DWord*)(sp - 5); \
+    DWord src  = *(DWord*)(sp - 3); \
+    Word  n    = *        (sp - 1); \
+    memmove(dest.Ptr, src.Ptr, n.UInt); \
+    sp -= 5; \
+} while(0)
+#define SYSCALL_MEMCPY(sp) do { \
+    DWord dest = *(DWord*)(sp - 5); \
+    DWord src  = *(DWord*)(sp - 3); \
+    Word  n    = *        (sp - 1); \
+    memcpy(dest.Ptr, src.Ptr, n.UInt); \
+    sp -= 5; \
+} while(0)
+#define SYSCALL_CLOCK(sp) do { \
+    DWord t = { .Int = clock() }; \
+    *(DWord*)sp = t; \
+    sp += 2; \
+} while(0)
+#define SYSCALL_MATH_WORD(sp, function) do { \
+    Word x = *(sp - 1); \
+    Word y = { .Float = function(x.Float) }; \
+    *(sp - 1) = y; \
+} while(0)
+#define SYSCALL_MATH_DWORD(sp, function) do { \
+    DWord x = *(DWord*)(sp - 2); \
+    DWord y = { .Float = function(x.Float) }; \
+    *(DWord*)(sp - 2) = y; \
+} while(0)
+#pragma endregion
@@ -0,0 +1,244 @@
+#include <stdio.h>
+#include <unistd.h>
+#include <pthread.h>
+
+#include "raiu/raiu.h"
+#include "metadata.h"
+#include "rvm.h"
+#include "interpreter.h"
+
+/*
+    A parallel loop splits an index range in chunks of grain indices and calls a function on each of them, the chunks are
+    taken in order from a shared counter by the thread that runs the loop and by a pool of OS threads that lives as long
+    as the program. Every worker of the pool has a copy of the program context with a stack, inline caches and thread-local
+    globals of its own, the thread that runs the loop calls its chunks on the free words above its operand stack, so the 
+    stack interpreter runs again from inside one of its own system calls. Execute keeps all its state in the context it is
+    given, so any number of them run at the same time.
+    A loop started while the pool is busy, by a chunk or by another green thread, runs all its chunks on the calling thread.
+*/
+#define POOL_STACK_WORDS 512
+
+/**
+ * @brief A loop the workers run the chunks of, it lives on the stack of the thread that runs the loop.
+ *
+ * @param Function The function called on each chunk with its first index and the end of the chunk
+ * @param Begin The first index of the loop
+ * @param End The end of the loop
+ * @param Grain The number of indices of a chunk
+ * @param Chunks The number of chunks of the loop
+ * @param Next The next chunk to run
+ * @param Failed A chunk has overflowed its stack or has ended with an error
+ */
+typedef struct _ParallelLoop
+{
+    FunctionHeader *Function;
+    i32  Begin;
+    i32  End;
+    i32  Grain;
+    u32  Chunks;
+    u32  Next;
+    bool Failed;
+} ParallelLoop;
+
+/**
+ * @brief The OS threads that run the parallel loops with the thread that starts them.
+ *
+ * @param Workers The contexts of the workers
+ * @param Threads The threads of the workers
+ * @param WorkerCount The number of workers, the thread that runs a loop is not one of them
+ * @param Busy Held by the thread that runs a loop on the pool
+ * @param Lock Guards the loop, the generation and the running workers
+ * @param Start Signals a new loop to the workers
+ * @param Finish Signals the end of the last worker of a loop
+ * @param Loop The loop the workers run
+ * @param Generation The number of loops the pool has run, a worker runs a loop when it changes
+ * @param Running The number of workers that run the loop
+ * @param Stop The program has ended
+ */
+typedef struct _WorkerPool
+{
+    ProgramContext *Workers;
+    pthread_t      *Threads;
+    u32             WorkerCount;
+    pthread_mutex_t Busy;
+    pthread_mutex_t Lock;
+    pthread_cond_t  Start;
+    pthread_cond_t  Finish;
+    ParallelLoop   *Loop;
+    u32  Generation;
+    u32  Running;
+    bool Stop;
+} WorkerPool;
+
+// calls the function on a chunk with a frame at the bottom of the stack, the function returns to a system call that
+// ends the interpreter with the word under the frame
+static i32 iCallChunk(ProgramContext *context, Word *stack, FunctionHeader *header, i32 begin, i32 end)
+{
+    static const Byte sChunkExit[] = { { .UInt = OP_SYSCALL }, { .UInt = OP_SYS_EXIT } };
+    Word *fp = stack + 1;
+    Word *frameHeader = FRAME_HEADER(fp, header->LWC);
+    // the frame is written before the function runs, so there is no probe to fault in the guard
+    Word *limit = frameHeader + FRAME_HEADER_SIZE + header->SWC;
+    if(limit >= context->StackTop && !GrowStack(context, limit))
+    {
+        printf("Stack overflow in function %s\n", header->Signature);
+        return -1;
+    }
+    stack->Int = 0;
+    fp[0].Int = begin;
+    fp[1].Int = end;
+    PUSH_FRAME_HEADER(frameHeader, fp, (Byte*)sChunkExit, fp, header, context->FunctionsBuffer);
+    context->Suspended = (ExecutionState){ (Byte*)header->Code, frameHeader + FRAME_HEADER_SIZE, fp, header };
+    return Execute(context);
+}
+// the engine a context runs the chunks of its loop with, it ends when all of them have been taken
+static i32 iRunChunks(ProgramContext *context)
+{
+    ParallelLoop *loop = context->Loop;
+    Word *stack = context->LoopStack;
+    u32 chunk;
+    while ((chunk = __atomic_fetch_add(&loop->Next, 1, __ATOMIC_RELAXED)) < loop->Chunks)
+    {
+        i64 begin = (i64)loop->Begin + (i64)chunk * loop->Grain;
+        i64 end   = begin + loop->Grain < loop->End ? begin + loop->Grain : loop->End;
+        if(iCallChunk(context, stack, loop->Function, (i32)begin, (i32)end) < 0)
+            __atomic_store_n(&loop->Failed, true, __ATOMIC_RELAXED);
+    }
+    return 0;
+}
+static void iRunLoop(ProgramContext *context, ParallelLoop *loop, Word *stack)
+{
+    // a chunk can run a loop of its own on the same context
+    ParallelLoop *outerLoop = context->Loop;
+    Word *outerStack = context->LoopStack;
+    context->Loop      = loop;
+    context->LoopStack = stack;
+    // an overflow ends only the chunk that caused it, the context goes on with the next ones
+    while (ExecuteGuarded(context, iRunChunks) < 0)
+        __atomic_store_n(&loop->Failed, true, __ATOMIC_RELAXED);
+    context->Loop      = outerLoop;
+    context->LoopStack = outerStack;
+}
+
+static void *iRunPoolWorker(void *argument)
+{
+    ProgramContext *worker = (ProgramContext*)argument;
+    WorkerPool *pool = worker->Pool;
+    u32 generation = 0;
+    pthread_mutex_lock(&pool->Lock);
+    while (true)
+    {
+        while (!pool->Stop && pool->Generation == generation)
+            pthread_cond_wait(&pool->Start, &pool->Lock);
+        if(pool->Stop)
+            break;
+        generation = pool->Generation;
+        ParallelLoop *loop = pool->Loop;
+        pthread_mutex_unlock(&pool->Lock);
+
+        iRunLoop(worker, loop, worker->StackBottom);
+
+        pthread_mutex_lock(&pool->Lock);
+        if(--pool->Running == 0)
+            pthread_cond_signal(&pool->Finish);
+    }
+    pthread_mutex_unlock(&pool->Lock);
+    return NULL;
+}
+
+WorkerPool *CreatePool(ProgramContext *context)
+{
+    u32 count = context->Options.Workers ? context->Options.Workers : (u32)sysconf(_SC_NPROCESSORS_ONLN);
+    // the thread that runs a loop is a worker too
+    if(count <= 1)
+        return NULL;
+    count--;
+
+    WorkerPool *pool = (WorkerPool*) calloc(1, sizeof(WorkerPool));
+    pool->Workers = (ProgramContext*) malloc(count * sizeof(ProgramContext));
+    pool->Threads = (pthread_t*) malloc(count * sizeof(pthread_t));
+    pthread_mutex_init(&pool->Busy, NULL);
+    pthread_mutex_init(&pool->Lock, NULL);
+    pthread_cond_init(&pool->Start, NULL);
+    pthread_cond_init(&pool->Finish, NULL);
+    for (u32 i = 0; i < count; i++)
+    {
+        // the buffers of the program are shared, the stack, the inline caches and the thread-local globals are not
+        ProgramContext *worker = pool->Workers + i;
+        *worker = *context;
+        worker->Pool      = pool;
+        worker->Scheduler = NULL;
+        if(!MapStack(worker, POOL_STACK_WORDS, context->Options.StackMaxSize))
+        {
+            printf("Cannot map the stack of a worker, the pool has %u of them\n", i);
+            break;
+        }
+        worker->InlineCaches = (InlineCache*) calloc(1U << context->InlineCachesBits, sizeof(InlineCache));
+        worker->ThreadLocals = context->ThreadLocalsSize ? (Byte*) calloc(1, context->ThreadLocalsSize) : NULL;
+        pthread_create(pool->Threads + i, NULL, iRunPoolWorker, worker);
+        pool->WorkerCount++;
+    }
+    LOG_INFO("Pool : %u workers for the parallel loops", pool->WorkerCount);
+    return pool;
+}
+void DestroyPool(WorkerPool *pool)
+{
+    if(pool == NULL)
+        return;
+    pthread_mutex_lock(&pool->Lock);
+    pool->Stop = true;
+    pthread_cond_broadcast(&pool->Start);
+    pthread_mutex_unlock(&pool->Lock);
+    for (u32 i = 0; i < pool->WorkerCount; i++)
+    {
+        pthread_join(pool->Threads[i], NULL);
+        UnmapStack(pool->Workers + i);
+        free(pool->Workers[i].InlineCaches);
+        free(pool->Workers[i].ThreadLocals);
+    }
+    pthread_cond_destroy(&pool->Finish);
+    pthread_cond_destroy(&pool->Start);
+    pthread_mutex_destroy(&pool->Lock);
+    pthread_mutex_destroy(&pool->Busy);
+    free(pool->Threads);
+    free(pool->Workers);
+    free(pool);
+}
+
+i32 ParallelFor(ProgramContext *context, FunctionHeader *header, i32 begin, i32 end, i32 grain, Word *sp)
+{
+    if(header == NULL || header->AWC != 2 || header->RWC != 0)
+    {
+        printf("Invalid parallel loop function %s\n", header ? header->Signature : "NULL");
+        return -1;
+    }
+    if(begin >= end)
+        return 0;
+    grain = grain > 0 ? grain : 1;
+    ParallelLoop loop = { header, begin, end, grain, (u32)(((i64)end - begin + grain - 1) / grain), 0, false };
+
+    WorkerPool *pool = context->Pool;
+    if(pool == NULL || loop.Chunks == 1 || pthread_mutex_trylock(&pool->Busy))
+    {
+        iRunLoop(context, &loop, sp);
+        return loop.Failed ? -1 : 0;
+    }
+
+    pthread_mutex_lock(&pool->Lock);
+    pool->Loop    = &loop;
+    pool->Running = pool->WorkerCount;
+    pool->Generation++;
+    pthread_cond_broadcast(&pool->Start);
+    pthread_mutex_unlock(&pool->Lock);
+
+    iRunLoop(context, &loop, sp);
+
+    // the loop lives on this stack, it must outlive the chunks of the workers
+    pthread_mutex_lock(&pool->Lock);
+    while (pool->Running)
+        pthread_cond_wait(&pool->Finish, &pool->Lock);
+    pool->Loop = NULL;
+    pthread_mutex_unlock(&pool->Lock);
+    pthread_mutex_unlock(&pool->Busy);
+    return loop.Failed ? -1 : 0;
+}
@@ -0,0 +1,984 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include <string.h>
+#include <time.h>
+#include <math.h>
+
+#include "raiu/raiu.h"
+#include "metadata.h"
+#include "rvm.h"
+#include "interpreter.h"
+
+// The operands of the register form are slots of the frame, see linker/translator.c for the encoding
+#define SLOT(fp, pc) ((fp) + iNextU8(&(pc)))
+
+#pragma region Operators
+#define REG_BINARY_OPERATION_WORD(fp, pc, type, operator) do \
+{ \
+    Word *d = SLOT(fp, pc); \
+    Word a = *SLOT(fp, pc); \
+    Word b = *SLOT(fp, pc); \
+    Word res; \
+    res.type = a.type operator b.type; \
+    *d = res; \
+} while (0)
+#define REG_BINARY_OPERATION_DWORD(fp, pc, type, operator) do \
+{ \
+    DWord *d = (DWord*)SLOT(fp, pc); \
+    DWord a = *(DWord*)SLOT(fp, pc); \
+    DWord b = *(DWord*)SLOT(fp, pc); \
+    DWord res; \
+    res.type = a.type operator b.type; \
+    *d = res; \
+} while (0)
+#define REG_UNARY_OPERATION_WORD(fp, pc, type, operator) do \
+{ \
+    Word *d = SLOT(fp, pc); \
+    Word a = *SLOT(fp, pc); \
+    Word res; \
+    res.type = operator a.type; \
+    *d = res; \
+} while (0)
+#define REG_UNARY_OPERATION_DWORD(fp, pc, type, operator) do \
+{ \
+    DWord *d = (DWord*)SLOT(fp, pc); \
+    DWord a = *(DWord*)SLOT(fp, pc); \
+    DWord res; \
+    res.type = operator a.type; \
+    *d = res; \
+} while (0)
+#define REG_MATH_WORD(fp, pc, function) do \
+{ \
+    Word *d = SLOT(fp, pc); \
+    Word a = *SLOT(fp, pc); \
+    Word res = { .Float = function(a.Float) }; \
+    *d = res; \
+} while (0)
+#define REG_MATH_DWORD(fp, pc, function) do \
+{ \
+    DWord *d = (DWord*)SLOT(fp, pc); \
+    DWord a = *(DWord*)SLOT(fp, pc); \
+    DWord res = { .Float = function(a.Float) }; \
+    *d = res; \
+} while (0)
+#define REG_SLOT_OPERATION_WORD(fp, pc, type, operator, cast) do \
+{ \
+    Word *s = SLOT(fp, pc); \
+    s->type = s->type operator (cast) iNextU8(&pc); \
+} while (0)
+#define REG_SLOT_OPERATION_DWORD(fp, pc, type, operator, cast) do \
+{ \
+    DWord *s = (DWord*)SLOT(fp, pc); \
+    s->type = s->type operator (cast) iNextU8(&pc); \
+} while (0)
+#define REG_CAST(fp, pc, TypeA, TypeB, typeA, typeB, cast) do \
+{ \
+    TypeB *d = (TypeB*)SLOT(fp, pc); \
+    TypeA from = *(TypeA*)SLOT(fp, pc); \
+    TypeB to; \
+    to.typeB = (cast) from.typeA; \
+    *d = to; \
+} while (0)
+#define REG_COMPARE_JUMP_WORD(fp, pc, type, operator) do \
+{ \
+    Word a = *SLOT(fp, pc); \
+    Word b = *SLOT(fp, pc); \
+    i16 o = iNextI16(&pc); \
+    if(a.type operator b.type) \
+        pc += o; \
+} while (0)
+#pragma endregion
+// Continue fetches the next instruction and dispatches it
+#define CONTINUE do \
+{ \
+    op = pc->UInt; \
+    pc += 1; \
+    goto *InstructionPointers[op]; \
+} while (0)
+
+i32 ExecuteRegister(ProgramContext *context)
+{
+    Byte            *pc;    // Program Counter
+    Word            *fp;    // Frame Pointer
+    Word            *sp;    // Stack Pointer, only set by the system calls
+    FunctionHeader  *fh;    // Function Header
+    const ModuleTable *mt;  // Module Table of the loaded pools
+    Word            *wpool; // Word Pool
+    DWord           *dpool; // DWord Pool
+    ch8            **spool; // String Pool
+    void           **gpool; // Global Pool
+    Function       **fpool; // Function Pool
+    u8               op;    // Opcode
+
+    // base of the caller headers in the frames
+    const Byte *fbase = context->FunctionsBuffer;
+
+    pc    = (Byte*)context->EntryPoint->Header.RegisterBody;
+    fp    = context->StackBottom;
+    sp    = fp;
+    fh    = &context->EntryPoint->Header;
+    mt    = fh->MT;
+    wpool = mt->WordPool;
+    dpool = mt->DWordPool;
+    spool = mt->StringPool;
+    gpool = mt->GlobalPool;
+    fpool = mt->FunctionPool;
+    op    = pc->UInt;
+
+#pragma region InstructionTable
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Woverride-init"
+    __attribute__((aligned(128)))
+    static const void* const InstructionPointers[256] =
+    {
+        [0 ... 255] = &&HANDLE_NOT_IMPLEMENTED,
+
+        [OP_PUSH_0_WORD ... OP_PUSH_I32_2] = &&HANDLE_PUSH_I32_V,
+        [OP_PUSH_0_DWORD ... OP_PUSH_I64_2] = &&HANDLE_PUSH_I64_V,
+        [OP_PUSH_F32_1] = &&HANDLE_PUSH_F32_1,
+        [OP_PUSH_F32_2] = &&HANDLE_PUSH_F32_2,
+        [OP_PUSH_F64_1] = &&HANDLE_PUSH_F64_1,
+        [OP_PUSH_F64_2] = &&HANDLE_PUSH_F64_2,
+        [OP_PUSH_I32] = &&HANDLE_PUSH_I32,
+        [OP_PUSH_I64] = &&HANDLE_PUSH_I64,
+        [OP_PUSH_CONST_WORD] = &&HANDLE_PUSH_CONST_WORD,
+        [OP_PUSH_CONST_WORD_W] = &&HANDLE_PUSH_CONST_WORD_W,
+        [OP_PUSH_CONST_DWORD] = &&HANDLE_PUSH_CONST_DWORD,
+        [OP_PUSH_CONST_DWORD_W] = &&HANDLE_PUSH_CONST_DWORD_W,
+        [OP_PUSH_CONST_STR] = &&HANDLE_PUSH_CONST_STR,
+        [OP_PUSH_CONST_STR_W] = &&HANDLE_PUSH_CONST_STR_W,
+        [OP_PUSH_GLOB_REF] = &&HANDLE_PUSH_GLOB_REF,
+        [OP_PUSH_GLOB_REF_W] = &&HANDLE_PUSH_GLOB_REF_W,
+        [OP_PUSH_FUNC] = &&HANDLE_PUSH_FUNC,
+        [OP_LOAD_GLOB_WORD] = &&HANDLE_LOAD_GLOB_WORD,
+        [OP_LOAD_GLOB_DWORD] = &&HANDLE_LOAD_GLOB_DWORD,
+
+        [OP_POP_WORD] = &&HANDLE_MOV_WORD,
+        [OP_POP_DWORD] = &&HANDLE_MOV_DWORD,
+
+        [OP_ADD_I32] = &&HANDLE_ADD_I32,
+        [OP_ADD_I64] = &&HANDLE_ADD_I64,
+        [OP_ADD_F32] = &&HANDLE_ADD_F32,
+        [OP_ADD_F64] = &&HANDLE_ADD_F64,
+        [OP_INC_I32] = &&HANDLE_INC_I32,
+        [OP_INC_I64] = &&HANDLE_INC_I64,
+        [OP_INC_F32] = &&HANDLE_INC_F32,
+        [OP_INC_F64] = &&HANDLE_INC_F64,
+        [OP_SUB_I32] = &&HANDLE_SUB_I32,
+        [OP_SUB_I64] = &&HANDLE_SUB_I64,
+        [OP_SUB_F32] = &&HANDLE_SUB_F32,
+        [OP_SUB_F64] = &&HANDLE_SUB_F64,
+        [OP_DEC_I32] = &&HANDLE_DEC_I32,
+        [OP_DEC_I64] = &&HANDLE_DEC_I64,
+        [OP_DEC_F32] = &&HANDLE_DEC_F32,
+        [OP_DEC_F64] = &&HANDLE_DEC_F64,
+        [OP_MUL_I32] = &&HANDLE_MUL_I32,
+        [OP_MUL_I64] = &&HANDLE_MUL_I64,
+        [OP_MUL_U32] = &&HANDLE_MUL_U32,
+        [OP_MUL_U64] = &&HANDLE_MUL_U64,
+        [OP_MUL_F32] = &&HANDLE_MUL_F32,
+        [OP_MUL_F64] = &&HANDLE_MUL_F64,
+        [OP_DIV_I32] = &&HANDLE_DIV_I32,
+        [OP_DIV_I64] = &&HANDLE_DIV_I64,
+        [OP_DIV_U32] = &&HANDLE_DIV_U32,
+        [OP_DIV_U64] = &&HANDLE_DIV_U64,
+        [OP_DIV_F32] = &&HANDLE_DIV_F32,
+        [OP_DIV_F64] = &&HANDLE_DIV_F64,
+        [OP_REM_I32] = &&HANDLE_REM_I32,
+        [OP_REM_I64] = &&HANDLE_REM_I64,
+        [OP_REM_U32] = &&HANDLE_REM_U32,
+        [OP_REM_U64] = &&HANDLE_REM_U64,
+        [OP_NEG_I32] = &&HANDLE_NEG_I32,
+        [OP_NEG_I64] = &&HANDLE_NEG_I64,
+        [OP_NEG_F32] = &&HANDLE_NEG_F32,
+        [OP_NEG_F64] = &&HANDLE_NEG_F64,
+        [OP_SQRT_F32] = &&HANDLE_SQRT_F32,
+        [OP_SQRT_F64] = &&HANDLE_SQRT_F64,
+        [OP_EXP_F32] = &&HANDLE_EXP_F32,
+        [OP_EXP_F64] = &&HANDLE_EXP_F64,
+        [OP_LOG_F32] = &&HANDLE_LOG_F32,
+        [OP_LOG_F64] = &&HANDLE_LOG_F64,
+
+        [OP_NOT_WORD] = &&HANDLE_NOT_WORD,
+        [OP_NOT_DWORD] = &&HANDLE_NOT_DWORD,
+        [OP_AND_WORD] = &&HANDLE_AND_WORD,
+        [OP_AND_DWORD] = &&HANDLE_AND_DWORD,
+        [OP_OR_WORD] = &&HANDLE_OR_WORD,
+        [OP_OR_DWORD] = &&HANDLE_OR_DWORD,
+        [OP_XOR_WORD] = &&HANDLE_XOR_WORD,
+        [OP_XOR_DWORD] = &&HANDLE_XOR_DWORD,
+        [OP_SHL_WORD] = &&HANDLE_SHL_WORD,
+        [OP_SHL_DWORD] = &&HANDLE_SHL_DWORD,
+        [OP_SHR_I32] = &&HANDLE_SHR_I32,
+        [OP_SHR_I64] = &&HANDLE_SHR_I64,
+        [OP_SHR_U32] = &&HANDLE_SHR_U32,
+        [OP_SHR_U64] = &&HANDLE_SHR_U64,
+
+        [OP_I32_TO_I8] = &&HANDLE_I32_TO_I8,
+        [OP_I32_TO_I16] = &&HANDLE_I32_TO_I16,
+        [OP_I32_TO_I64] = &&HANDLE_I32_TO_I64,
+        [OP_I32_TO_F32] = &&HANDLE_I32_TO_F32,
+        [OP_I32_TO_F64] = &&HANDLE_I32_TO_F64,
+        [OP_I64_TO_I32] = &&HANDLE_I64_TO_I32,
+        [OP_I64_TO_F32] = &&HANDLE_I64_TO_F32,
+        [OP_I64_TO_F64] = &&HANDLE_I64_TO_F64,
+        [OP_F32_TO_I32] = &&HANDLE_F32_TO_I32,
+        [OP_F32_TO_I64] = &&HANDLE_F32_TO_I64,
+        [OP_F32_TO_F64] = &&HANDLE_F32_TO_F64,
+        [OP_F64_TO_I32] = &&HANDLE_F64_TO_I32,
+        [OP_F64_TO_I64] = &&HANDLE_F64_TO_I64,
+        [OP_F64_TO_F32] = &&HANDLE_F64_TO_F32,
+
+        [OP_CMP_WORD_EQ] = &&HANDLE_CMP_WORD_EQ,
+        [OP_CMP_DWORD_EQ] = &&HANDLE_CMP_DWORD_EQ,
+        [OP_CMP_WORD_NE] = &&HANDLE_CMP_WORD_NE,
+        [OP_CMP_DWORD_NE] = &&HANDLE_CMP_DWORD_NE,
+        [OP_CMP_I32_GT] = &&HANDLE_CMP_I32_GT,
+        [OP_CMP_I64_GT] = &&HANDLE_CMP_I64_GT,
+        [OP_CMP_U32_GT] = &&HANDLE_CMP_U32_GT,
+        [OP_CMP_U64_GT] = &&HANDLE_CMP_U64_GT,
+        [OP_CMP_F32_GT] = &&HANDLE_CMP_F32_GT,
+        [OP_CMP_F64_GT] = &&HANDLE_CMP_F64_GT,
+        [OP_CMP_I32_LT] = &&HANDLE_CMP_I32_LT,
+        [OP_CMP_I64_LT] = &&HANDLE_CMP_I64_LT,
+        [OP_CMP_U32_LT] = &&HANDLE_CMP_U32_LT,
+        [OP_CMP_U64_LT] = &&HANDLE_CMP_U64_LT,
+        [OP_CMP_F32_LT] = &&HANDLE_CMP_F32_LT,
+        [OP_CMP_F64_LT] = &&HANDLE_CMP_F64_LT,
+        [OP_CMP_I32_GE] = &&HANDLE_CMP_I32_GE,
+        [OP_CMP_I64_GE] = &&HANDLE_CMP_I64_GE,
+        [OP_CMP_U32_GE] = &&HANDLE_CMP_U32_GE,
+        [OP_CMP_U64_GE] = &&HANDLE_CMP_U64_GE,
+        [OP_CMP_F32_GE] = &&HANDLE_CMP_F32_GE,
+        [OP_CMP_F64_GE] = &&HANDLE_CMP_F64_GE,
+        [OP_CMP_I32_LE] = &&HANDLE_CMP_I32_LE,
+        [OP_CMP_I64_LE] = &&HANDLE_CMP_I64_LE,
+        [OP_CMP_U32_LE] = &&HANDLE_CMP_U32_LE,
+        [OP_CMP_U64_LE] = &&HANDLE_CMP_U64_LE,
+        [OP_CMP_F32_LE] = &&HANDLE_CMP_F32_LE,
+        [OP_CMP_F64_LE] = &&HANDLE_CMP_F64_LE,
+        [OP_CMP_NOT] = &&HANDLE_CMP_NOT,
+
+        [OP_LOAD_WORD] = &&HANDLE_LOAD_WORD,
+        [OP_LOAD_DWORD] = &&HANDLE_LOAD_DWORD,
+        [OP_STORE_WORD] = &&HANDLE_STORE_WORD,
+        [OP_STORE_DWORD] = &&HANDLE_STORE_DWORD,
+        [OP_LOAD_OFST_WORD] = &&HANDLE_LOAD_OFST_WORD,
+        [OP_LOAD_OFST_DWORD] = &&HANDLE_LOAD_OFST_DWORD,
+        [OP_STORE_OFST_WORD] = &&HANDLE_STORE_OFST_WORD,
+        [OP_STORE_OFST_DWORD] = &&HANDLE_STORE_OFST_DWORD,
+        [OP_MEMMOV] = &&HANDLE_MEMMOV,
+        [OP_MEMCPY] = &&HANDLE_MEMCPY,
+
+        [OP_JMP] = &&HANDLE_JMP,
+        [OP_JMP_IF] = &&HANDLE_JMP_IF,
+        [OP_CALL] = &&HANDLE_CALL,
+        [OP_TAILCALL] = &&HANDLE_TAILCALL,
+        [OP_SYSCALL] = &&HANDLE_SYSCALL,
+        [OP_RET] = &&HANDLE_RET,
+
+        [OP_ADD_I32_LOC_IMM] = &&HANDLE_ADD_I32_LOC_IMM,
+        [OP_ADD_I32_LOC_LOC] = &&HANDLE_ADD_I32_LOC_LOC,
+        [OP_JMP_WORD_EQ] = &&HANDLE_JMP_WORD_EQ,
+        [OP_JMP_WORD_NE] = &&HANDLE_JMP_WORD_NE,
+        [OP_JMP_I32_GT] = &&HANDLE_JMP_I32_GT,
+        [OP_JMP_I32_LT] = &&HANDLE_JMP_I32_LT,
+        [OP_JMP_I32_GE] = &&HANDLE_JMP_I32_GE,
+        [OP_JMP_I32_LE] = &&HANDLE_JMP_I32_LE,
+    };
+#pragma GCC diagnostic pop
+#pragma endregion
+    pc += 1;
+    goto *InstructionPointers[op];
+HANDLE_NOT_IMPLEMENTED:
+    UNLIKELY(false, "Instruction not supported by the register form in function %s!\n", fh->Signature);
+    exit(EXIT_FAILURE);
+#pragma region Push
+HANDLE_PUSH_I32_V:
+    *SLOT(fp, pc) = IntToWord(op - OP_PUSH_0_WORD);
+    CONTINUE;
+HANDLE_PUSH_I64_V:
+    *(DWord*)SLOT(fp, pc) = IntToDWord(op - OP_PUSH_0_DWORD);
+    CONTINUE;
+HANDLE_PUSH_F32_1:
+    *SLOT(fp, pc) = FloatToWord(1.0f);
+    CONTINUE;
+HANDLE_PUSH_F32_2:
+    *SLOT(fp, pc) = FloatToWord(2.0f);
+    CONTINUE;
+HANDLE_PUSH_F64_1:
+    *(DWord*)SLOT(fp, pc) = FloatToDWord(1.0);
+    CONTINUE;
+HANDLE_PUSH_F64_2:
+    *(DWord*)SLOT(fp, pc) = FloatToDWord(2.0);
+    CONTINUE;
+HANDLE_PUSH_I32:
+    {
+        Word *d = SLOT(fp, pc);
+        *d = IntToWord((i32)iNextI8(&pc));
+    }
+    CONTINUE;
+HANDLE_PUSH_I64:
+    {
+        DWord *d = (DWord*)SLOT(fp, pc);
+        *d = IntToDWord((i64)iNextI8(&pc));
+    }
+    CONTINUE;
+HANDLE_PUSH_CONST_WORD:
+    {
+        Word *d = SLOT(fp, pc);
+        *d = *(wpool + iNextU8(&pc));
+    }
+    CONTINUE;
+HANDLE_PUSH_CONST_WORD_W:
+    {
+        Word *d = SLOT(fp, pc);
+        *d = *(wpool + iNextU16(&pc));
+    }
+    CONTINUE;
+HANDLE_PUSH_CONST_DWORD:
+    {
+        DWord *d = (DWord*)SLOT(fp, pc);
+        *d = *(dpool + iNextU8(&pc));
+    }
+    CONTINUE;
+HANDLE_PUSH_CONST_DWORD_W:
+    {
+        DWord *d = (DWord*)SLOT(fp, pc);
+        *d = *(dpool + iNextU16(&pc));
+    }
+    CONTINUE;
+HANDLE_PUSH_CONST_STR:
+    {
+        DWord *d = (DWord*)SLOT(fp, pc);
+        *d = RefToDWord(*(spool + iNextU8(&pc)));
+    }
+    CONTINUE;
+HANDLE_PUSH_CONST_STR_W:
+    {
+        DWord *d = (DWord*)SLOT(fp, pc);
+        *d = RefToDWord(*(spool + iNextU16(&pc)));
+    }
+    CONTINUE;
+HANDLE_PUSH_GLOB_REF:
+    {
+        DWord *d = (DWord*)SLOT(fp, pc);
+        *d = RefToDWord(*(gpool + iNextU8(&pc)));
+    }
+    CONTINUE;
+HANDLE_PUSH_GLOB_REF_W:
+    {
+        DWord *d = (DWord*)SLOT(fp, pc);
+        *d = RefToDWord(*(gpool + iNextU16(&pc)));
+    }
+    CONTINUE;
+HANDLE_PUSH_FUNC:
+    {
+        DWord *d = (DWord*)SLOT(fp, pc);
+        *d = RefToDWord(*(fpool + iNextU16(&pc)));
+    }
+    CONTINUE;
+HANDLE_LOAD_GLOB_WORD:
+    {
+        Word *d = SLOT(fp, pc);
+        *d = *(Word*)*(gpool + iNextU8(&pc));
+    }
+    CONTINUE;
+HANDLE_LOAD_GLOB_DWORD:
+    {
+        DWord *d = (DWord*)SLOT(fp, pc);
+        *d = *(DWord*)*(gpool + iNextU8(&pc));
+    }
+    CONTINUE;
+HANDLE_MOV_WORD:
+    {
+        Word *d = SLOT(fp, pc);
+        *d = *SLOT(fp, pc);
+    }
+    CONTINUE;
+HANDLE_MOV_DWORD:
+    {
+        DWord *d = (DWord*)SLOT(fp, pc);
+        *d = *(DWord*)SLOT(fp, pc);
+    }
+    CONTINUE;
+#pragma endregion
+#pragma region Arithmetic
+HANDLE_ADD_I32:
+    REG_BINARY_OPERATION_WORD(fp, pc, Int, +);
+    CONTINUE;
+HANDLE_ADD_I64:
+    REG_BINARY_OPERATION_DWORD(fp, pc, Int, +);
+    CONTINUE;
+HANDLE_ADD_F32:
+    REG_BINARY_OPERATION_WORD(fp, pc, Float, +);
+    CONTINUE;
+HANDLE_ADD_F64:
+    REG_BINARY_OPERATION_DWORD(fp, pc, Float, +);
+    CONTINUE;
+HANDLE_INC_I32:
+    REG_SLOT_OPERATION_WORD(fp, pc, Int, +, i32);
+    CONTINUE;
+HANDLE_INC_I64:
+    REG_SLOT_OPERATION_DWORD(fp, pc, Int, +, i64);
+    CONTINUE;
+HANDLE_INC_F32:
+    REG_SLOT_OPERATION_WORD(fp, pc, Float, +, f32);
+    CONTINUE;
+HANDLE_INC_F64:
+    REG_SLOT_OPERATION_DWORD(fp, pc, Float, +, f64);
+    CONTINUE;
+HANDLE_SUB_I32:
+    REG_BINARY_OPERATION_WORD(fp, pc, Int, -);
+    CONTINUE;
+HANDLE_SUB_I64:
+    REG_BINARY_OPERATION_DWORD(fp, pc, Int, -);
+    CONTINUE;
+HANDLE_SUB_F32:
+    REG_BINARY_OPERATION_WORD(fp, pc, Float, -);
+    CONTINUE;
+HANDLE_SUB_F64:
+    REG_BINARY_OPERATION_DWORD(fp, pc, Float, -);
+    CONTINUE;
+HANDLE_DEC_I32:
+    REG_SLOT_OPERATION_WORD(fp, pc, Int, -, i32);
+    CONTINUE;
+HANDLE_DEC_I64:
+    REG_SLOT_OPERATION_DWORD(fp, pc, Int, -, i64);
+    CONTINUE;
+HANDLE_DEC_F32:
+    REG_SLOT_OPERATION_WORD(fp, pc, Float, -, f32);
+    CONTINUE;
+HANDLE_DEC_F64:
+    REG_SLOT_OPERATION_DWORD(fp, pc, Float, -, f64);
+    CONTINUE;
+HANDLE_MUL_I32:
+    REG_BINARY_OPERATION_WORD(fp, pc, Int, *);
+    CONTINUE;
+HANDLE_MUL_I64:
+    REG_BINARY_OPERATION_DWORD(fp, pc, Int, *);
+    CONTINUE;
+HANDLE_MUL_U32:
+    REG_BINARY_OPERATION_WORD(fp, pc, UInt, *);
+    CONTINUE;
+HANDLE_MUL_U64:
+    REG_BINARY_OPERATION_DWORD(fp, pc, UInt, *);
+    CONTINUE;
+HANDLE_MUL_F32:
+    REG_BINARY_OPERATION_WORD(fp, pc, Float, *);
+    CONTINUE;
+HANDLE_MUL_F64:
+    REG_BINARY_OPERATION_DWORD(fp, pc, Float, *);
+    CONTINUE;
+HANDLE_DIV_I32:
+    REG_BINARY_OPERATION_WORD(fp, pc, Int, /);
+    CONTINUE;
+HANDLE_DIV_I64:
+    REG_BINARY_OPERATION_DWORD(fp, pc, Int, /);
+    CONTINUE;
+HANDLE_DIV_U32:
+    REG_BINARY_OPERATION_WORD(fp, pc, UInt, /);
+    CONTINUE;
+HANDLE_DIV_U64:
+    REG_BINARY_OPERATION_DWORD(fp, pc, UInt, /);
+    CONTINUE;
+HANDLE_DIV_F32:
+    REG_BINARY_OPERATION_WORD(fp, pc, Float, /);
+    CONTINUE;
+HANDLE_DIV_F64:
+    REG_BINARY_OPERATION_DWORD(fp, pc, Float, /);
+    CONTINUE;
+HANDLE_REM_I32:
+    REG_BINARY_OPERATION_WORD(fp, pc, Int, %);
+    CONTINUE;
+HANDLE_REM_I64:
+    REG_BINARY_OPERATION_DWORD(fp, pc, Int, %);
+    CONTINUE;
+HANDLE_REM_U32:
+    REG_BINARY_OPERATION_WORD(fp, pc, UInt, %);
+    CONTINUE;
+HANDLE_REM_U64:
+    REG_BINARY_OPERATION_DWORD(fp, pc, UInt, %);
+    CONTINUE;
+HANDLE_NEG_I32:
+    REG_UNARY_OPERATION_WORD(fp, pc, Int, -);
+    CONTINUE;
+HANDLE_NEG_I64:
+    REG_UNARY_OPERATION_DWORD(fp, pc, Int, -);
+    CONTINUE;
+HANDLE_NEG_F32:
+    REG_UNARY_OPERATION_WORD(fp, pc, Float, -);
+    CONTINUE;
+HANDLE_NEG_F64:
+    REG_UNARY_OPERATION_DWORD(fp, pc, Float, -);
+    CONTINUE;
+#pragma endregion
+#pragma region Math
+HANDLE_SQRT_F32:
+    REG_MATH_WORD(fp, pc, sqrtf);
+    CONTINUE;
+HANDLE_SQRT_F64:
+    REG_MATH_DWORD(fp, pc, sqrt);
+    CONTINUE;
+HANDLE_EXP_F32:
+    REG_MATH_WORD(fp, pc, expf);
+    CONTINUE;
+HANDLE_EXP_F64:
+    REG_MATH_DWORD(fp, pc, exp);
+    CONTINUE;
+HANDLE_LOG_F32:
+    REG_MATH_WORD(fp, pc, logf);
+    CONTINUE;
+HANDLE_LOG_F64:
+    REG_MATH_DWORD(fp, pc, log);
+    CONTINUE;
+#pragma endregion
+#pragma region Bitwise
+HANDLE_NOT_WORD:
+    REG_UNARY_OPERATION_WORD(fp, pc, Int, ~);
+    CONTINUE;
+HANDLE_NOT_DWORD:
+    REG_UNARY_OPERATION_DWORD(fp, pc, Int, ~);
+    CONTINUE;
+HANDLE_AND_WORD:
+    REG_BINARY_OPERATION_WORD(fp, pc, Int, &);
+    CONTINUE;
+HANDLE_AND_DWORD:
+    REG_BINARY_OPERATION_DWORD(fp, pc, Int, &);
+    CONTINUE;
+HANDLE_OR_WORD:
+    REG_BINARY_OPERATION_WORD(fp, pc, Int, |);
+    CONTINUE;
+HANDLE_OR_DWORD:
+    REG_BINARY_OPERATION_DWORD(fp, pc, Int, |);
+    CONTINUE;
+HANDLE_XOR_WORD:
+    REG_BINARY_OPERATION_WORD(fp, pc, Int, ^);
+    CONTINUE;
+HANDLE_XOR_DWORD:
+    REG_BINARY_OPERATION_DWORD(fp, pc, Int, ^);
+    CONTINUE;
+HANDLE_SHL_WORD:
+    REG_BINARY_OPERATION_WORD(fp, pc, Int, <<);
+    CONTINUE;
+HANDLE_SHL_DWORD:
+    REG_BINARY_OPERATION_DWORD(fp, pc, Int, <<);
+    CONTINUE;
+HANDLE_SHR_I32:
+    REG_BINARY_OPERATION_WORD(fp, pc, Int, >>);
+    CONTINUE;
+HANDLE_SHR_I64:
+    REG_BINARY_OPERATION_DWORD(fp, pc, Int, >>);
+    CONTINUE;
+HANDLE_SHR_U32:
+    REG_BINARY_OPERATION_WORD(fp, pc, UInt, >>);
+    CONTINUE;
+HANDLE_SHR_U64:
+    REG_BINARY_OPERATION_DWORD(fp, pc, UInt, >>);
+    CONTINUE;
+#pragma endregion
+#pragma region Cast
+HANDLE_I32_TO_I8:
+    REG_CAST(fp, pc, Word, Word, Int, Int, i8);
+    CONTINUE;
+HANDLE_I32_TO_I16:
+    REG_CAST(fp, pc, Word, Word, Int, Int, i16);
+    CONTINUE;
+HANDLE_I32_TO_I64:
+    REG_CAST(fp, pc, Word, DWord, Int, Int, i64);
+    CONTINUE;
+HANDLE_I32_TO_F32:
+    REG_CAST(fp, pc, Word, Word, Int, Float, f32);
+    CONTINUE;
+HANDLE_I32_TO_F64:
+    REG_CAST(fp, pc, Word, DWord, Int, Float, f64);
+    CONTINUE;
+HANDLE_I64_TO_I32:
+    REG_CAST(fp, pc, DWord, Word, Int, Int, i32);
+    CONTINUE;
+HANDLE_I64_TO_F32:
+    REG_CAST(fp, pc, DWord, Word, Int, Float, f32);
+    CONTINUE;
+HANDLE_I64_TO_F64:
+    REG_CAST(fp, pc, DWord, DWord, Int, Float, f64);
+    CONTINUE;
+HANDLE_F32_TO_I32:
+    REG_CAST(fp, pc, Word, Word, Float, Int, i32);
+    CONTINUE;
+HANDLE_F32_TO_I64:
+    REG_CAST(fp, pc, Word, DWord, Float, Int, i64);
+    CONTINUE;
+HANDLE_F32_TO_F64:
+    REG_CAST(fp, pc, Word, DWord, Float, Float, f64);
+    CONTINUE;
+HANDLE_F64_TO_I32:
+    REG_CAST(fp, pc, DWord, Word, Float, Int, i32);
+    CONTINUE;
+HANDLE_F64_TO_I64:
+    REG_CAST(fp, pc, DWord, DWord, Float, Int, i64);
+    CONTINUE;
+HANDLE_F64_TO_F32:
+    REG_CAST(fp, pc, DWord, Word, Float, Float, f32);
+    CONTINUE;
+#pragma endregion
+#pragma region Compare
+HANDLE_CMP_WORD_EQ:
+    REG_BINARY_OPERATION_WORD(fp, pc, Int, ==);
+    CONTINUE;
+HANDLE_CMP_DWORD_EQ:
+    REG_BINARY_OPERATION_DWORD(fp, pc, Int, ==);
+    CONTINUE;
+HANDLE_CMP_WORD_NE:
+    REG_BINARY_OPERATION_WORD(fp, pc, Int, !=);
+    CONTINUE;
+HANDLE_CMP_DWORD_NE:
+    REG_BINARY_OPERATION_DWORD(fp, pc, Int, !=);
+    CONTINUE;
+HANDLE_CMP_I32_GT:
+    REG_BINARY_OPERATION_WORD(fp, pc, Int, >);
+    CONTINUE;
+HANDLE_CMP_I64_GT:
+    REG_BINARY_OPERATION_DWORD(fp, pc, Int, >);
+    CONTINUE;
+HANDLE_CMP_U32_GT:
+    REG_BINARY_OPERATION_WORD(fp, pc, UInt, >);
+    CONTINUE;
+HANDLE_CMP_U64_GT:
+    REG_BINARY_OPERATION_DWORD(fp, pc, UInt, >);
+    CONTINUE;
+HANDLE_CMP_F32_GT:
+    REG_BINARY_OPERATION_WORD(fp, pc, Float, >);
+    CONTINUE;
+HANDLE_CMP_F64_GT:
+    REG_BINARY_OPERATION_DWORD(fp, pc, Float, >);
+    CONTINUE;
+HANDLE_CMP_I32_LT:
+    REG_BINARY_OPERATION_WORD(fp, pc, Int, <);
+    CONTINUE;
+HANDLE_CMP_I64_LT:
+    REG_BINARY_OPERATION_DWORD(fp, pc, Int, <);
+    CONTINUE;
+HANDLE_CMP_U32_LT:
+    REG_BINARY_OPERATION_WORD(fp, pc, UInt, <);
+    CONTINUE;
+HANDLE_CMP_U64_LT:
+    REG_BINARY_OPERATION_DWORD(fp, pc, UInt, <);
+    CONTINUE;
+HANDLE_CMP_F32_LT:
+    REG_BINARY_OPERATION_WORD(fp, pc, Float, <);
+    CONTINUE;
+HANDLE_CMP_F64_LT:
+    REG_BINARY_OPERATION_DWORD(fp, pc, Float, <);
+    CONTINUE;
+HANDLE_CMP_I32_GE:
+    REG_BINARY_OPERATION_WORD(fp, pc, Int, >=);
+    CONTINUE;
+HANDLE_CMP_I64_GE:
+    REG_BINARY_OPERATION_DWORD(fp, pc, Int, >=);
+    CONTINUE;
+HANDLE_CMP_U32_GE:
+    REG_BINARY_OPERATION_WORD(fp, pc, UInt, >=);
+    CONTINUE;
+HANDLE_CMP_U64_GE:
+    REG_BINARY_OPERATION_DWORD(fp, pc, UInt, >=);
+    CONTINUE;
+HANDLE_CMP_F32_GE:
+    REG_BINARY_OPERATION_WORD(fp, pc, Float, >=);
+    CONTINUE;
+HANDLE_CMP_F64_GE:
+    REG_BINARY_OPERATION_DWORD(fp, pc, Float, >=);
+    CONTINUE;
+HANDLE_CMP_I32_LE:
+    REG_BINARY_OPERATION_WORD(fp, pc, Int, <=);
+    CONTINUE;
+HANDLE_CMP_I64_LE:
+    REG_BINARY_OPERATION_DWORD(fp, pc, Int, <=);
+    CONTINUE;
+HANDLE_CMP_U32_LE:
+    REG_BINARY_OPERATION_WORD(fp, pc, UInt, <=);
+    CONTINUE;
+HANDLE_CMP_U64_LE:
+    REG_BINARY_OPERATION_DWORD(fp, pc, UInt, <=);
+    CONTINUE;
+HANDLE_CMP_F32_LE:
+    REG_BINARY_OPERATION_WORD(fp, pc, Float, <=);
+    CONTINUE;
+HANDLE_CMP_F64_LE:
+    REG_BINARY_OPERATION_DWORD(fp, pc, Float, <=);
+    CONTINUE;
+HANDLE_CMP_NOT:
+    REG_UNARY_OPERATION_WORD(fp, pc, Int, !);
+    CONTINUE;
+#pragma endregion
+#pragma region Load & Store
+HANDLE_LOAD_WORD:
+    {
+        Word *d = SLOT(fp, pc);
+        DWord ref = *(DWord*)SLOT(fp, pc);
+        *d = *ref.WordPtr;
+    }
+    CONTINUE;
+HANDLE_LOAD_DWORD:
+    {
+        DWord *d = (DWord*)SLOT(fp, pc);
+        DWord ref = *(DWord*)SLOT(fp, pc);
+        *d = *(DWord*)ref.WordPtr;
+    }
+    CONTINUE;
+HANDLE_STORE_WORD:
+    {
+        DWord ref = *(DWord*)SLOT(fp, pc);
+        *ref.WordPtr = *SLOT(fp, pc);
+    }
+    CONTINUE;
+HANDLE_STORE_DWORD:
+    {
+        DWord ref = *(DWord*)SLOT(fp, pc);
+        *(DWord*)ref.WordPtr = *(DWord*)SLOT(fp, pc);
+    }
+    CONTINUE;
+HANDLE_LOAD_OFST_WORD:
+    {
+        Word *d = SLOT(fp, pc);
+        DWord ref = *(DWord*)SLOT(fp, pc);
+        *d = *(ref.WordPtr + iNextU8(&pc));
+    }
+    CONTINUE;
+HANDLE_LOAD_OFST_DWORD:
+    {
+        DWord *d = (DWord*)SLOT(fp, pc);
+        DWord ref = *(DWord*)SLOT(fp, pc);
+        *d = *(DWord*)(ref.WordPtr + iNextU8(&pc));
+    }
+    CONTINUE;
+HANDLE_STORE_OFST_WORD:
+    {
+        DWord ref = *(DWord*)SLOT(fp, pc);
+        Word  val = *SLOT(fp, pc);
+        *(ref.WordPtr + iNextU8(&pc)) = val;
+    }
+    CONTINUE;
+HANDLE_STORE_OFST_DWORD:
+    {
+        DWord ref = *(DWord*)SLOT(fp, pc);
+        DWord val = *(DWord*)SLOT(fp, pc);
+        *(DWord*)(ref.WordPtr + iNextU8(&pc)) = val;
+    }
+    CONTINUE;
+HANDLE_MEMMOV:
+    {
+        DWord dest = *(DWord*)SLOT(fp, pc);
+        DWord src  = *(DWord*)SLOT(fp, pc);
+        Word  n    = *SLOT(fp, pc);
+        memmove(dest.Ptr, src.Ptr, n.UInt);
+    }
+    CONTINUE;
+HANDLE_MEMCPY:
+    {
+        DWord dest = *(DWord*)SLOT(fp, pc);
+        DWord src  = *(DWord*)SLOT(fp, pc);
+        Word  n    = *SLOT(fp, pc);
+        memcpy(dest.Ptr, src.Ptr, n.UInt);
+    }
+    CONTINUE;
+#pragma endregion
+#pragma region Control flow
+HANDLE_JMP:
+    {
+        i16 o = iNextI16(&pc);
+        pc += o;
+    }
+    CONTINUE;
+HANDLE_JMP_IF:
+    {
+        Word c = *SLOT(fp, pc);
+        i16 o = iNextI16(&pc);
+        if(c.Int)
+            pc += o;
+    }
+    CONTINUE;
+HANDLE_CALL:
+    {
+        // the arguments are the first locals of the callee frame like in the stack interpreter
+        Word *newFP = SLOT(fp, pc);
+        FunctionHeader *header = &fpool[iNextU16(&pc)]->Header;
+        u16 lwc = header->LWC;
+        u16 swc = header->SWC;
+
+        Word *frameHeader = FRAME_HEADER(newFP, lwc);
+        STACK_PROBE(frameHeader + FRAME_HEADER_SIZE + swc, header);
+        PUSH_FRAME_HEADER(frameHeader, newFP, pc, fp, fh, fbase);
+
+        fp    = newFP;
+        pc    = (Byte*)header->RegisterBody;
+        fh    = header;
+        SWITCH_MODULE(fh->MT);
+    }
+    CONTINUE;
+HANDLE_TAILCALL:
+    {
+        // the arguments become the first locals of the running frame and its header is moved after the callee locals
+        Word *args = SLOT(fp, pc);
+        FunctionHeader *header = &fpool[iNextU16(&pc)]->Header;
+        u16 lwc = header->LWC;
+        u16 swc = header->SWC;
+
+        Word link[FRAME_HEADER_SIZE];
+        memcpy(link, FRAME_HEADER(fp, fh->LWC), sizeof(link));
+        memmove(fp, args, header->AWC * SIZEOF_WORD);
+        Word *frameHeader = FRAME_HEADER(fp, lwc);
+        STACK_PROBE(frameHeader + FRAME_HEADER_SIZE + swc, header);
+        memcpy(frameHeader, link, sizeof(link));
+
+        pc    = (Byte*)header->RegisterBody;
+        fh    = header;
+        SWITCH_MODULE(fh->MT);
+    }
+    CONTINUE;
+HANDLE_SYSCALL:
+    {
+        static const void *SyscallPointers[] =
+        {
+            &&HANDLE_SYSCALL_EXIT,
+            &&HANDLE_SYSCALL_PRINT,
+            &&HANDLE_SYSCALL_PRINTI,
+            &&HANDLE_SYSCALL_PRINTF,
+            &&HANDLE_SYSCALL_SCAN,
+            &&HANDLE_SYSCALL_SCANI,
+            &&HANDLE_SYSCALL_SCANF,
+            &&HANDLE_SYSCALL_MEMMOV,
+            &&HANDLE_SYSCALL_MEMCPY,
+            &&HANDLE_SYSCALL_CLOCK,
+            &&HANDLE_SYSCALL_SQRT32,
+            &&HANDLE_SYSCALL_SQRT64,
+            &&HANDLE_SYSCALL_EXP32,
+            &&HANDLE_SYSCALL_EXP64,
+            &&HANDLE_SYSCALL_LOG32,
+            &&HANDLE_SYSCALL_LOG64,
+        };
+
+        sp = SLOT(fp, pc);
+        u8 f = iNextU8(&pc);
+        goto *SyscallPointers[f];
+
+        HANDLE_SYSCALL_EXIT:
+        {
+            Word exitCode = *(sp - 1);
+            return exitCode.Int;
+        }
+        HANDLE_SYSCALL_PRINT:
+            SYSCALL_PRINT(sp);
+            CONTINUE;
+        HANDLE_SYSCALL_PRINTI:
+            SYSCALL_PRINTI(sp);
+            CONTINUE;
+        HANDLE_SYSCALL_PRINTF:
+            SYSCALL_PRINTF(sp);
+            CONTINUE;
+        HANDLE_SYSCALL_SCAN:
+            SYSCALL_SCAN(sp);
+            CONTINUE;
+        HANDLE_SYSCALL_SCANI:
+            SYSCALL_SCANI(sp);
+            CONTINUE;
+        HANDLE_SYSCALL_SCANF:
+            SYSCALL_SCANF(sp);
+            CONTINUE;
+        HANDLE_SYSCALL_MEMMOV:
+            SYSCALL_MEMMOV(sp);
+            CONTINUE;
+        HANDLE_SYSCALL_MEMCPY:
+            SYSCALL_MEMCPY(sp);
+            CONTINUE;
+        HANDLE_SYSCALL_CLOCK:
+            SYSCALL_CLOCK(sp);
+            CONTINUE;
+        HANDLE_SYSCALL_SQRT32:
+            SYSCALL_MATH_WORD(sp, sqrtf);
+            CONTINUE;
+        HANDLE_SYSCALL_SQRT64:
+            SYSCALL_MATH_DWORD(sp, sqrt);
+            CONTINUE;
+        HANDLE_SYSCALL_EXP32:
+            SYSCALL_MATH_WORD(sp, expf);
+            CONTINUE;
+        HANDLE_SYSCALL_EXP64:
+            SYSCALL_MATH_DWORD(sp, exp);
+            CONTINUE;
+        HANDLE_SYSCALL_LOG32:
+            SYSCALL_MATH_WORD(sp, logf);
+            CONTINUE;
+        HANDLE_SYSCALL_LOG64:
+            SYSCALL_MATH_DWORD(sp, log);
+            CONTINUE;
+    }
+HANDLE_RET:
+    {
+        Word *results = SLOT(fp, pc);
+        Word *frameHeader = FRAME_HEADER(fp, fh->LWC);
+        Byte *prevPC = FRAME_PC(frameHeader);
+        Word *prevFP = FRAME_FP(frameHeader, fp);
+        FunctionHeader *prevFH = FRAME_FH(frameHeader, fbase);
+
+        // the results take the place of the arguments in the caller frame, the common sizes are moved at once
+        switch (fh->RWC)
+        {
+        case 0:
+            break;
+        case 1:
+            *fp = *results;
+            break;
+        case 2:
+            *(DWord*)fp = *(DWord*)results;
+            break;
+        default:
+            for (u16 i = 0; i < fh->RWC; i++)
+                fp[i] = results[i];
+            break;
+        }
+
+        fp    = prevFP;
+        pc    = prevPC;
+        fh    = prevFH;
+        SWITCH_MODULE(fh->MT);
+    }
+    CONTINUE;
+#pragma endregion
+#pragma region Superinstructions
+HANDLE_ADD_I32_LOC_IMM:
+    {
+        Word *s = SLOT(fp, pc);
+        i32   v = (i32) iNextI8(&pc);
+        Word *d = SLOT(fp, pc);
+        d->Int = s->Int + v;
+    }
+    CONTINUE;
+HANDLE_ADD_I32_LOC_LOC:
+    {
+        Word *a = SLOT(fp, pc);
+        Word *b = SLOT(fp, pc);
+        Word *d = SLOT(fp, pc);
+        d->Int = a->Int + b->Int;
+    }
+    CONTINUE;
+HANDLE_JMP_WORD_EQ:
+    REG_COMPARE_JUMP_WORD(fp, pc, Int, ==);
+    CONTINUE;
+HANDLE_JMP_WORD_NE:
+    REG_COMPARE_JUMP_WORD(fp, pc, Int, !=);
+    CONTINUE;
+HANDLE_JMP_I32_GT:
+    REG_COMPARE_JUMP_WORD(fp, pc, Int, >);
+    CONTINUE;
+HANDLE_JMP_I32_LT:
+    REG_COMPARE_JUMP_WORD(fp, pc, Int, <);
+    CONTINUE;
+HANDLE_JMP_I32_GE:
+    REG_COMPARE_JUMP_WORD(fp, pc, Int, >=);
+    CONTINUE;
+HANDLE_JMP_I32_LE:
+    REG_COMPARE_JUMP_WORD(fp, pc, Int, <=);
+    CONTINUE;
+#pragma endregion
+}
@@ -0,0 +1,427 @@
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+
+#include "raiu/raiu.h"
+#include "metadata.h"
+#include "rvm.h"
+#include "interpreter.h"
+
+/*
+    The green threads of a program are run M:N by a pool of workers, every worker is an OS thread with its own copy of
+    the program context that shares the linked buffers and owns the inline caches and the registers of the thread it
+    runs. A green thread is a stack of its own and the registers saved by the fueled stack interpreter, the workers run
+    it a slice of fuel at a time, so a thread that never yields still lets the others run.
+    Every worker has a deque of the runnable threads, it pushes and pops the threads it spawns at the bottom and puts the
+    suspended ones at the top, an idle worker steals from the top of the others. A slice is thousands of instructions, so
+    a lock on each deque costs nothing compared to it.
+    A worker that finds no thread to run sleeps until one is queued. When no thread is queued and no worker runs a slice,
+    every thread left waits in a join that can never end and the program ends with a deadlock.
+    The program ends when its main thread ends, the threads still running are dropped like the ones of a process.
+*/
+#define THREAD_STACK_WORDS 512
+#define THREAD_SLICE_FUEL  10000
+
+/**
+ * @brief A green thread, the scheduler owns it until the program ends so that a join always finds it.
+ *
+ * @param State The registers the stack interpreter resumes from, the PC of the main thread is NULL before it starts
+ * @param StackBottom The stack of the thread, see interpreter/stack.c
+ * @param StackTop The upper limit of the stack
+ * @param StackLimit The size the stack can grow to
+ * @param ThreadLocals The copy of the thread-local globals of the thread
+ * @param Lock Guards the result and the waiters
+ * @param Waiters The threads suspended in a join of this one, linked by NextWaiter
+ * @param NextWaiter The next thread waiting for the same one
+ * @param Next The next thread spawned by the program
+ * @param Result The exit code of the thread, the result of its joins
+ * @param Finished The thread has ended
+ */
+typedef struct _GreenThread
+{
+    ExecutionState State;
+    Word *StackBottom;
+    Word *StackTop;
+    Word *StackLimit;
+    Byte *ThreadLocals;
+    pthread_mutex_t      Lock;
+    struct _GreenThread *Waiters;
+    struct _GreenThread *NextWaiter;
+    struct _GreenThread *Next;
+    i32  Result;
+    bool Finished;
+} GreenThread;
+
+/**
+ * @brief The runnable threads of a worker, a ring buffer that grows when it is full.
+ */
+typedef struct _ThreadDeque
+{
+    pthread_mutex_t Lock;
+    GreenThread   **Items;
+    u32 Head;
+    u32 Count;
+    u32 Capacity;
+} ThreadDeque;
+
+/**
+ * @brief The workers and the threads of a program.
+ *
+ * @param Workers The contexts of the workers
+ * @param Deques The runnable threads of each worker
+ * @param WorkerCount The number of workers
+ * @param Main The thread of the entry point
+ * @param Threads All the threads of the program, linked by Next
+ * @param Lock Guards the counts of the threads, the idle workers wait on it
+ * @param Wake Signalled when a thread is queued and when the program ends
+ * @param Runnable The number of threads queued in the deques
+ * @param Running The number of workers running a slice
+ * @param Result The exit code of the main thread
+ * @param Done The main thread has ended
+ */
+typedef struct _Scheduler
+{
+    ProgramContext *Workers;
+    ThreadDeque    *Deques;
+    u32             WorkerCount;
+    GreenThread    *Main;
+    GreenThread    *Threads;
+    pthread_mutex_t Lock;
+    pthread_cond_t  Wake;
+    u32  Runnable;
+    u32  Running;
+    i32  Result;
+    bool Done;
+} Scheduler;
+
+#pragma region Deque
+static void iDequeGrow(ThreadDeque *deque)
+{
+    u32 capacity = deque->Capacity ? 2 * deque->Capacity : 16;
+    GreenThread **items = (GreenThread**) malloc(capacity * sizeof(GreenThread*));
+    for (u32 i = 0; i < deque->Count; i++)
+        items[i] = deque->Items[(deque->Head + i) % deque->Capacity];
+    free(deque->Items);
+    deque->Items    = items;
+    deque->Head     = 0;
+    deque->Capacity = capacity;
+}
+// a queued thread wakes an idle worker
+static void iWakeWorker(Scheduler *scheduler)
+{
+    pthread_mutex_lock(&scheduler->Lock);
+    scheduler->Runnable++;
+    pthread_cond_signal(&scheduler->Wake);
+    pthread_mutex_unlock(&scheduler->Lock);
+}
+static void iDequePushBottom(Scheduler *scheduler, ThreadDeque *deque, GreenThread *thread)
+{
+    pthread_mutex_lock(&deque->Lock);
+    if(deque->Count == deque->Capacity)
+        iDequeGrow(deque);
+    deque->Items[(deque->Head + deque->Count) % deque->Capacity] = thread;
+    deque->Count++;
+    pthread_mutex_unlock(&deque->Lock);
+    iWakeWorker(scheduler);
+}
+static void iDequePushTop(Scheduler *scheduler, ThreadDeque *deque, GreenThread *thread)
+{
+    pthread_mutex_lock(&deque->Lock);
+    if(deque->Count == deque->Capacity)
+        iDequeGrow(deque);
+    deque->Head = (deque->Head + deque->Capacity - 1) % deque->Capacity;
+    deque->Items[deque->Head] = thread;
+    deque->Count++;
+    pthread_mutex_unlock(&deque->Lock);
+    iWakeWorker(scheduler);
+}
+static GreenThread *iDequePopBottom(ThreadDeque *deque)
+{
+    GreenThread *thread = NULL;
+    pthread_mutex_lock(&deque->Lock);
+    if(deque->Count)
+    {
+        deque->Count--;
+        thread = deque->Items[(deque->Head + deque->Count) % deque->Capacity];
+    }
+    pthread_mutex_unlock(&deque->Lock);
+    return thread;
+}
+static GreenThread *iDequePopTop(ThreadDeque *deque)
+{
+    GreenThread *thread = NULL;
+    pthread_mutex_lock(&deque->Lock);
+    if(deque->Count)
+    {
+        thread = deque->Items[deque->Head];
+        deque->Head = (deque->Head + 1) % deque->Capacity;
+        deque->Count--;
+    }
+    pthread_mutex_unlock(&deque->Lock);
+    return thread;
+}
+#pragma endregion
+
+static GreenThread *iCreateThread(Scheduler *scheduler)
+{
+    GreenThread *thread = (GreenThread*) calloc(1, sizeof(GreenThread));
+    pthread_mutex_init(&thread->Lock, NULL);
+    // the threads are spawned by all the workers at the same time
+    thread->Next = __atomic_load_n(&scheduler->Threads, __ATOMIC_RELAXED);
+    while (!__atomic_compare_exchange_n(&scheduler->Threads, &thread->Next, thread, true, __ATOMIC_RELEASE, __ATOMIC_RELAXED))
+        ;
+    return thread;
+}
+static void iUnmapThreadStack(GreenThread *thread)
+{
+    // the stack functions work on the fields of a context
+    ProgramContext stack = { 0 };
+    stack.StackBottom = thread->StackBottom;
+    stack.StackTop    = thread->StackTop;
+    stack.StackLimit  = thread->StackLimit;
+    UnmapStack(&stack);
+    thread->StackBottom = NULL;
+}
+static void iFinishThread(Scheduler *scheduler, ProgramContext *worker, GreenThread *thread, i32 result)
+{
+    // the stack and the thread-local globals of the main thread are the ones of the program
+    if(thread != scheduler->Main)
+    {
+        iUnmapThreadStack(thread);
+        free(thread->ThreadLocals);
+        thread->ThreadLocals = NULL;
+    }
+
+    pthread_mutex_lock(&thread->Lock);
+    thread->Result = result;
+    __atomic_store_n(&thread->Finished, true, __ATOMIC_RELEASE);
+    GreenThread *waiter = thread->Waiters;
+    thread->Waiters = NULL;
+    pthread_mutex_unlock(&thread->Lock);
+    for (; waiter; waiter = waiter->NextWaiter)
+        iDequePushBottom(scheduler, scheduler->Deques + worker->Worker, waiter);
+
+    if(thread == scheduler->Main)
+    {
+        pthread_mutex_lock(&scheduler->Lock);
+        scheduler->Result = result;
+        __atomic_store_n(&scheduler->Done, true, __ATOMIC_RELEASE);
+        pthread_cond_broadcast(&scheduler->Wake);
+        pthread_mutex_unlock(&scheduler->Lock);
+    }
+}
+
+GreenThread *SpawnThread(ProgramContext *context, FunctionHeader *header, DWord argument)
+{
+    // the thread returns to a system call that ends it with the result of the function
+    static const Byte sThreadExit[] = { { .UInt = OP_SYSCALL }, { .UInt = OP_SYS_EXIT } };
+    if(header == NULL || header->AWC != 2 || header->RWC != 1)
+    {
+        printf("Invalid thread function %s\n", header ? header->Signature : "NULL");
+        return NULL;
+    }
+    // a worker of the parallel loops runs outside of the scheduler
+    if(context->Scheduler == NULL)
+    {
+        printf("Cannot spawn a thread of %s outside of the scheduler\n", header->Signature);
+        return NULL;
+    }
+
+    Scheduler *scheduler = context->Scheduler;
+    ProgramContext stack = { 0 };
+    sz words = (sz)header->LWC + FRAME_HEADER_SIZE + header->SWC;
+    if(!MapStack(&stack, words > THREAD_STACK_WORDS ? words : THREAD_STACK_WORDS, context->Options.StackMaxSize))
+    {
+        printf("Cannot map the stack of a thread of %s\n", header->Signature);
+        return NULL;
+    }
+
+    // the frame of the function is the first one of the stack and returns to itself
+    Word *fp = stack.StackBottom;
+    *(DWord*)fp = argument;
+    Word *frameHeader = FRAME_HEADER(fp, header->LWC);
+    PUSH_FRAME_HEADER(frameHeader, fp, (Byte*)sThreadExit, fp, header, context->FunctionsBuffer);
+
+    GreenThread *thread = iCreateThread(scheduler);
+    thread->StackBottom = stack.StackBottom;
+    thread->StackTop    = stack.StackTop;
+    thread->StackLimit  = stack.StackLimit;
+    thread->ThreadLocals = context->ThreadLocalsSize ? (Byte*) calloc(1, context->ThreadLocalsSize) : NULL;
+    thread->State = (ExecutionState){ (Byte*)header->Code, frameHeader + FRAME_HEADER_SIZE, fp, header };
+    context->Spawned++;
+    iDequePushBottom(scheduler, scheduler->Deques + context->Worker, thread);
+    return thread;
+}
+bool ThreadResult(GreenThread *thread, i32 *result)
+{
+    if(thread == NULL)
+    {
+        *result = -1;
+        return true;
+    }
+    if(!__atomic_load_n(&thread->Finished, __ATOMIC_ACQUIRE))
+        return false;
+    *result = thread->Result;
+    return true;
+}
+
+static GreenThread *iNextThread(Scheduler *scheduler, ProgramContext *worker)
+{
+    GreenThread *thread = iDequePopBottom(scheduler->Deques + worker->Worker);
+    for (u32 i = 1; thread == NULL && i < scheduler->WorkerCount; i++)
+    {
+        thread = iDequePopTop(scheduler->Deques + (worker->Worker + i) % scheduler->WorkerCount);
+        worker->Steals += thread != NULL;
+    }
+    // the thread leaves the queued ones only once its worker counts as running, a worker that finds nothing queued and
+    // nothing running never misses one in between
+    if(thread)
+    {
+        pthread_mutex_lock(&scheduler->Lock);
+        scheduler->Runnable--;
+        scheduler->Running++;
+        pthread_mutex_unlock(&scheduler->Lock);
+    }
+    return thread;
+}
+// sleeps until a thread is queued or the program ends, the threads left wait on each other if none can wake the worker
+static void iWaitForThread(Scheduler *scheduler)
+{
+    pthread_mutex_lock(&scheduler->Lock);
+    while (!scheduler->Done && !scheduler->Runnable)
+    {
+        if(!scheduler->Running)
+        {
+            printf("Deadlock, all the threads are waiting in a join\n");
+            scheduler->Result = -1;
+            __atomic_store_n(&scheduler->Done, true, __ATOMIC_RELEASE);
+            pthread_cond_broadcast(&scheduler->Wake);
+            break;
+        }
+        pthread_cond_wait(&scheduler->Wake, &scheduler->Lock);
+    }
+    pthread_mutex_unlock(&scheduler->Lock);
+}
+// runs a slice of the thread and queues it again, one blocked in a join is queued by the thread it waits for when it ends
+static void iRunSlice(Scheduler *scheduler, ProgramContext *worker, GreenThread *thread)
+{
+    worker->StackBottom = thread->StackBottom;
+    worker->StackTop    = thread->StackTop;
+    worker->StackLimit  = thread->StackLimit;
+    worker->ThreadLocals = thread->ThreadLocals;
+    worker->Suspended   = thread->State;
+    i32 ret = ExecuteGuarded(worker, ExecuteFueled);
+    thread->StackTop = worker->StackTop;
+    if(ret != EXECUTE_SUSPENDED)
+    {
+        iFinishThread(scheduler, worker, thread, ret);
+        return;
+    }
+
+    thread->State = worker->Suspended;
+    GreenThread *joining = worker->Joining;
+    worker->Joining = NULL;
+    if(joining)
+    {
+        pthread_mutex_lock(&joining->Lock);
+        bool finished = joining->Finished;
+        if(!finished)
+        {
+            thread->NextWaiter = joining->Waiters;
+            joining->Waiters   = thread;
+        }
+        pthread_mutex_unlock(&joining->Lock);
+        if(!finished)
+            return;
+    }
+    // a thread that has been suspended goes after the others of the worker
+    iDequePushTop(scheduler, scheduler->Deques + worker->Worker, thread);
+}
+static void *iRunWorker(void *argument)
+{
+    ProgramContext *worker = (ProgramContext*)argument;
+    Scheduler *scheduler   = worker->Scheduler;
+    while (!__atomic_load_n(&scheduler->Done, __ATOMIC_ACQUIRE))
+    {
+        GreenThread *thread = iNextThread(scheduler, worker);
+        if(thread == NULL)
+        {
+            iWaitForThread(scheduler);
+            continue;
+        }
+        // the threads the slice queues are counted before the worker stops running
+        iRunSlice(scheduler, worker, thread);
+        pthread_mutex_lock(&scheduler->Lock);
+        scheduler->Running--;
+        pthread_mutex_unlock(&scheduler->Lock);
+    }
+    return NULL;
+}
+
+i32 RunThreads(ProgramContext *context)
+{
+    Scheduler scheduler = { 0 };
+    scheduler.WorkerCount = context->Options.Workers ? context->Options.Workers : (u32)sysconf(_SC_NPROCESSORS_ONLN);
+    scheduler.WorkerCount = scheduler.WorkerCount ? scheduler.WorkerCount : 1;
+    scheduler.Workers = (ProgramContext*) malloc(scheduler.WorkerCount * sizeof(ProgramContext));
+    scheduler.Deques  = (ThreadDeque*) calloc(scheduler.WorkerCount, sizeof(ThreadDeque));
+    for (u32 i = 0; i < scheduler.WorkerCount; i++)
+    {
+        // the buffers of the program are shared, the inline caches are filled at run time and each worker has its own
+        ProgramContext *worker = scheduler.Workers + i;
+        *worker = *context;
+        worker->Scheduler    = &scheduler;
+        worker->Worker       = i;
+        worker->Options.Fuel = context->Options.Fuel ? context->Options.Fuel : THREAD_SLICE_FUEL;
+        worker->InlineCaches = (InlineCache*) calloc(1U << context->InlineCachesBits, sizeof(InlineCache));
+        pthread_mutex_init(&scheduler.Deques[i].Lock, NULL);
+    }
+    pthread_mutex_init(&scheduler.Lock, NULL);
+    pthread_cond_init(&scheduler.Wake, NULL);
+
+    scheduler.Main = iCreateThread(&scheduler);
+    scheduler.Main->StackBottom = context->StackBottom;
+    scheduler.Main->StackTop    = context->StackTop;
+    scheduler.Main->StackLimit  = context->StackLimit;
+    scheduler.Main->ThreadLocals = context->ThreadLocals;
+    iDequePushBottom(&scheduler, scheduler.Deques, scheduler.Main);
+
+    // the first worker is the thread that runs the program
+    pthread_t *threads = (pthread_t*) malloc(scheduler.WorkerCount * sizeof(pthread_t));
+    for (u32 i = 1; i < scheduler.WorkerCount; i++)
+        pthread_create(threads + i, NULL, iRunWorker, scheduler.Workers + i);
+    iRunWorker(scheduler.Workers);
+    for (u32 i = 1; i < scheduler.WorkerCount; i++)
+        pthread_join(threads[i], NULL);
+    free(threads);
+
+    context->StackTop = scheduler.Main->StackTop;
+    for (u32 i = 0; i < scheduler.WorkerCount; i++)
+    {
+        context->Slices  += scheduler.Workers[i].Slices;
+        context->Spawned += scheduler.Workers[i].Spawned;
+        context->Steals  += scheduler.Workers[i].Steals;
+        free(scheduler.Workers[i].InlineCaches);
+        free(scheduler.Deques[i].Items);
+        pthread_mutex_destroy(&scheduler.Deques[i].Lock);
+    }
+    while (scheduler.Threads)
+    {
+        GreenThread *thread = scheduler.Threads;
+        scheduler.Threads = thread->Next;
+        if(thread != scheduler.Main && thread->StackBottom)
+        {
+            iUnmapThreadStack(thread);
+            free(thread->ThreadLocals);
+        }
+        pthread_mutex_destroy(&thread->Lock);
+        free(thread);
+    }
+    pthread_cond_destroy(&scheduler.Wake);
+    pthread_mutex_destroy(&scheduler.Lock);
+    free(scheduler.Workers);
+    free(scheduler.Deques);
+    LOG_INFO("Scheduler : %u green threads on %u workers", context->Spawned, scheduler.WorkerCount);
+    return scheduler.Result;
+}
@@ -0,0 +1,156 @@
+#define _GNU_SOURCE // registers of the signal context
+#include <stdio.h>
+#include <string.h>
+#include <signal.h>
+#include <setjmp.h>
+#include <ucontext.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/mman.h>
+
+#include "raiu/raiu.h"
+#include "metadata.h"
+#include "rvm.h"
+#include "interpreter.h"
+
+/*
+    The stack is a reservation of address space without access, only its first part is readable and writable and it 
+    grows towards the limit when a frame touches the pages after the top. After the limit there is a guard region that 
+    is at least as big as the largest frame, so a call whose frame does not fit the limit touches it with its stack 
+    probe and faults as an overflow. The frames never move, so the pointers to them stay valid when the stack grows.
+    [ StackBottom ... StackTop ) [ reserved ... StackLimit ) [ guard ]
+*/
+#define MAX_FRAME_SIZE ((sz)(2 * UINT16_MAX + FRAME_HEADER_SIZE + 1) * SIZEOF_WORD)
+
+// the workers of the scheduler run guarded engines at the same time, the handler is installed once for the program and
+// a fault is handled with the context of the thread that raised it
+static _Thread_local const ProgramContext *sGuardedContext;
+static _Thread_local sigjmp_buf            sOverflowJump;
+static _Thread_local const ch8            *sOverflowFunction;
+#ifdef STACK_PROBE_REGISTER
+// the addresses of the probes, the linker defines the bounds of their section
+extern const Byte *const __start_rvm_stack_probes[];
+extern const Byte *const __stop_rvm_stack_probes[];
+#endif
+static pthread_once_t sGuardOnce = PTHREAD_ONCE_INIT;
+static sz             sGuardSize;
+
+static inline sz iPageAlign(sz size)
+{
+    sz page = (sz)sysconf(_SC_PAGESIZE);
+    return (size + page - 1) / page * page;
+}
+
+bool MapStack(ProgramContext *context, sz words, sz maxWords)
+{
+    sz limit = iPageAlign((maxWords > words ? maxWords : words) * SIZEOF_WORD);
+    sz size  = iPageAlign(words * SIZEOF_WORD);
+    sz guard = iPageAlign(MAX_FRAME_SIZE);
+
+    u8 *stack = mmap(NULL, limit + guard, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if(stack == MAP_FAILED)
+        return false;
+    if(mprotect(stack, size, PROT_READ | PROT_WRITE))
+    {
+        munmap(stack, limit + guard);
+        return false;
+    }
+    context->StackBottom = (Word*)stack;
+    context->StackTop    = (Word*)(stack + size);
+    context->StackLimit  = (Word*)(stack + limit);
+    return true;
+}
+void UnmapStack(ProgramContext *context)
+{
+    if(context->StackBottom)
+        munmap(context->StackBottom, (u8*)context->StackLimit - (u8*)context->StackBottom + iPageAlign(MAX_FRAME_SIZE));
+    context->StackBottom = NULL;
+    context->StackTop    = NULL;
+    context->StackLimit  = NULL;
+}
+bool GrowStack(ProgramContext *context, const void *address)
+{
+    const u8 *top   = (const u8*)context->StackTop;
+    const u8 *limit = (const u8*)context->StackLimit;
+    if((const u8*)address < top || (const u8*)address >= limit)
+        return false;
+
+    // the stack doubles until it holds the address, so a deep recursion grows it a logarithmic number of times
+    sz size = top - (const u8*)context->StackBottom;
+    sz grow = size;
+    while (top + grow <= (const u8*)address)
+        grow *= 2;
+    grow = top + grow > limit ? (sz)(limit - top) : grow;
+    if(mprotect((void*)top, grow, PROT_READ | PROT_WRITE))
+        return false;
+    context->StackTop = (Word*)(top + grow);
+    return true;
+}
+
+static void iStackFaultHandler(int signal, siginfo_t *info, void *ucontext)
+{
+    (void)signal;
+    const u8 *address = info->si_addr;
+    if(sGuardedContext && GrowStack((ProgramContext*)sGuardedContext, address))
+        return; // the faulting instruction runs again on the new pages
+    // a thread that runs no engine faults outside of the stacks
+    const u8 *limit = sGuardedContext ? (const u8*)sGuardedContext->StackLimit : NULL;
+    if(!sGuardedContext || address < (const u8*)sGuardedContext->StackTop || address >= limit + sGuardSize)
+    {
+        // not in the stack, the fault is raised again with the default action
+        struct sigaction action = { .sa_handler = SIG_DFL };
+        sigaction(SIGSEGV, &action, NULL);
+        return;
+    }
+
+#ifdef STACK_PROBE_REGISTER
+    // the probe of a call keeps the callee header in a known register, the message is printed out of the handler, any 
+    // other instruction that faults in the guard has nothing in it
+    const greg_t *registers = ((ucontext_t*)ucontext)->uc_mcontext.gregs;
+    sOverflowFunction = NULL;
+    for (const Byte *const *probe = __start_rvm_stack_probes; probe < __stop_rvm_stack_probes; probe++)
+    {
+        if(*probe == (const Byte*)registers[REG_RIP])
+        {
+            sOverflowFunction = ((const FunctionHeader*)registers[STACK_PROBE_REGISTER])->Signature;
+            break;
+        }
+    }
+#else
+    (void)ucontext;
+    sOverflowFunction = NULL;
+#endif
+    siglongjmp(sOverflowJump, 1);
+}
+// the signal is not blocked in the handler, so the jump out of it does not have to restore the signal mask and the
+// guarded engines save none
+static void iInstallGuard(void)
+{
+    sGuardSize = iPageAlign(MAX_FRAME_SIZE);
+    struct sigaction action = { 0 };
+    action.sa_sigaction = iStackFaultHandler;
+    action.sa_flags     = SA_SIGINFO | SA_NODEFER;
+    sigemptyset(&action.sa_mask);
+    sigaction(SIGSEGV, &action, NULL);
+}
+
+i32 ExecuteGuarded(ProgramContext *context, i32 (*execute)(ProgramContext *context))
+{
+    pthread_once(&sGuardOnce, iInstallGuard);
+
+    // a parallel loop runs its chunks guarded from the engine that runs the loop, the guard of the engine comes back after
+    const ProgramContext *outerContext = sGuardedContext;
+    sigjmp_buf outerJump;
+    memcpy(outerJump, sOverflowJump, sizeof(sigjmp_buf));
+    sGuardedContext = context;
+    volatile i32 ret = -1;
+    if(sigsetjmp(sOverflowJump, 0) == 0)
+        ret = execute(context);
+    else if(sOverflowFunction)
+        printf("Stack overflow in function %s\n", sOverflowFunction);
+    else
+        printf("Stack overflow\n");
+    sGuardedContext = outerContext;
+    memcpy(sOverflowJump, outerJump, sizeof(sigjmp_buf));
+    return ret;
+}
\ No newline at end of file
@@ -0,0 +1,309 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include <string.h>
+#include <time.h>
+#include <math.h>
+
+#include "raiu/raiu.h"
+#include "metadata.h"
+#include "rvm.h"
+#include "interpreter.h"
+
+// The operands of the threaded code are cells, a slot is its byte offset from the frame pointer, see linker/threader.c
+#define SLOT(fp, pc) ((Word*)((u8*)(fp) + ((pc)++)->Offset))
+
+#pragma region Operators
+#define REG_BINARY_OPERATION_WORD(fp, pc, type, operator) do \
+{ \
+    Word *d = SLOT(fp, pc); \
+    Word a = *SLOT(fp, pc); \
+    Word b = *SLOT(fp, pc); \
+    Word res; \
+    res.type = a.type operator b.type; \
+    *d = res; \
+} while (0)
+#define REG_BINARY_OPERATION_DWORD(fp, pc, type, operator) do \
+{ \
+    DWord *d = (DWord*)SLOT(fp, pc); \
+    DWord a = *(DWord*)SLOT(fp, pc); \
+    DWord b = *(DWord*)SLOT(fp, pc); \
+    DWord res; \
+    res.type = a.type operator b.type; \
+    *d = res; \
+} while (0)
+#define REG_UNARY_OPERATION_WORD(fp, pc, type, operator) do \
+{ \
+    Word *d = SLOT(fp, pc); \
+    Word a = *SLOT(fp, pc); \
+    Word res; \
+    res.type = operator a.type; \
+    *d = res; \
+} while (0)
+#define REG_UNARY_OPERATION_DWORD(fp, pc, type, operator) do \
+{ \
+    DWord *d = (DWord*)SLOT(fp, pc); \
+    DWord a = *(DWord*)SLOT(fp, pc); \
+    DWord res; \
+    res.type = operator a.type; \
+    *d = res; \
+} while (0)
+#define REG_MATH_WORD(fp, pc, function) do \
+{ \
+    Word *d = SLOT(fp, pc); \
+    Word a = *SLOT(fp, pc); \
+    Word res = { .Float = function(a.Float) }; \
+    *d = res; \
+} while (0)
+#define REG_MATH_DWORD(fp, pc, function) do \
+{ \
+    DWord *d = (DWord*)SLOT(fp, pc); \
+    DWord a = *(DWord*)SLOT(fp, pc); \
+    DWord res = { .Float = function(a.Float) }; \
+    *d = res; \
+} while (0)
+#define REG_SLOT_OPERATION_WORD(fp, pc, type, operator, cast) do \
+{ \
+    Word *s = SLOT(fp, pc); \
+    s->type = s->type operator (cast) ((pc)++)->UInt; \
+} while (0)
+#define REG_SLOT_OPERATION_DWORD(fp, pc, type, operator, cast) do \
+{ \
+    DWord *s = (DWord*)SLOT(fp, pc); \
+    s->type = s->type operator (cast) ((pc)++)->UInt; \
+} while (0)
+#define REG_CAST(fp, pc, TypeA, TypeB, typeA, typeB, cast) do \
+{ \
+    TypeB *d = (TypeB*)SLOT(fp, pc); \
+    TypeA from = *(TypeA*)SLOT(fp, pc); \
+    TypeB to; \
+    to.typeB = (cast) from.typeA; \
+    *d = to; \
+} while (0)
+#define REG_COMPARE_JUMP_WORD(fp, pc, type, operator) do \
+{ \
+    Word a = *SLOT(fp, pc); \
+    Word b = *SLOT(fp, pc); \
+    Cell *t = ((pc)++)->Target; \
+    if(a.type operator b.type) \
+        pc = t; \
+} while (0)
+#pragma endregion
+#ifdef THREADED_TAILCALLS
+/*
+    Every handler is a function and dispatches the next one with a tail call, so the registers are its arguments and
+    each handler is compiled on its own instead of in a single function. The tail calls are guaranteed by musttail when
+    the compiler has it, otherwise they are the sibling calls of the optimizer and the CMake option builds this file
+    optimized. A handler must not take the address of its locals, that would keep its frame alive.
+*/
+#if defined(__has_attribute) && __has_attribute(musttail)
+#define MUSTTAIL __attribute__((musttail))
+#else
+#define MUSTTAIL
+#endif
+typedef i32 (*ThreadedHandler)(Cell *pc, Word *fp, FunctionHeader *fh, ProgramContext *context, const Byte *fbase);
+// not every handler reads every register, those that stop the program read none of them
+#define UNUSED __attribute__((unused))
+#define HANDLER(name) static i32 HANDLE_##name(Cell *pc UNUSED, Word *fp UNUSED, FunctionHeader *fh UNUSED, \
+    ProgramContext *context UNUSED, const Byte *fbase UNUSED)
+#define HANDLER_ADDRESS(name) ((const void*)HANDLE_##name)
+// Continue calls the handler of the next instruction, there is no opcode to decode
+#define CONTINUE MUSTTAIL return ((ThreadedHandler)(pc)->Handler)((pc) + 1, fp, fh, context, fbase)
+#include "threaded_handlers.h"
+#else
+#define HANDLER(name) HANDLE_##name:
+#define HANDLER_ADDRESS(name) (&&HANDLE_##name)
+// Continue jumps to the handler of the next instruction, there is no opcode to decode
+#define CONTINUE goto *((pc)++)->Handler
+#endif
+
+/**
+ * Runs the threaded code, if handlers is not NULL it only sets it to the table of the handlers indexed by the opcodes
+ * of the register form. With the computed gotos the labels are local to this function so the table can not be built 
+ * elsewhere.
+ */
+static i32 iExecuteThreaded(ProgramContext *context, const void *const **handlers)
+{
+#pragma region InstructionTable
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Woverride-init"
+    static const void* const ThreadedPointers[256] =
+    {
+        [0 ... 255] = HANDLER_ADDRESS(NOT_IMPLEMENTED),
+
+        [OP_PUSH_I32] = HANDLER_ADDRESS(PUSH_WORD),
+        [OP_PUSH_I64] = HANDLER_ADDRESS(PUSH_DWORD),
+        [OP_LOAD_GLOB_WORD] = HANDLER_ADDRESS(LOAD_GLOB_WORD),
+        [OP_LOAD_GLOB_DWORD] = HANDLER_ADDRESS(LOAD_GLOB_DWORD),
+
+        [OP_POP_WORD] = HANDLER_ADDRESS(MOV_WORD),
+        [OP_POP_DWORD] = HANDLER_ADDRESS(MOV_DWORD),
+
+        [OP_ADD_I32] = HANDLER_ADDRESS(ADD_I32),
+        [OP_ADD_I64] = HANDLER_ADDRESS(ADD_I64),
+        [OP_ADD_F32] = HANDLER_ADDRESS(ADD_F32),
+        [OP_ADD_F64] = HANDLER_ADDRESS(ADD_F64),
+        [OP_INC_I32] = HANDLER_ADDRESS(INC_I32),
+        [OP_INC_I64] = HANDLER_ADDRESS(INC_I64),
+        [OP_INC_F32] = HANDLER_ADDRESS(INC_F32),
+        [OP_INC_F64] = HANDLER_ADDRESS(INC_F64),
+        [OP_SUB_I32] = HANDLER_ADDRESS(SUB_I32),
+        [OP_SUB_I64] = HANDLER_ADDRESS(SUB_I64),
+        [OP_SUB_F32] = HANDLER_ADDRESS(SUB_F32),
+        [OP_SUB_F64] = HANDLER_ADDRESS(SUB_F64),
+        [OP_DEC_I32] = HANDLER_ADDRESS(DEC_I32),
+        [OP_DEC_I64] = HANDLER_ADDRESS(DEC_I64),
+        [OP_DEC_F32] = HANDLER_ADDRESS(DEC_F32),
+        [OP_DEC_F64] = HANDLER_ADDRESS(DEC_F64),
+        [OP_MUL_I32] = HANDLER_ADDRESS(MUL_I32),
+        [OP_MUL_I64] = HANDLER_ADDRESS(MUL_I64),
+        [OP_MUL_U32] = HANDLER_ADDRESS(MUL_U32),
+        [OP_MUL_U64] = HANDLER_ADDRESS(MUL_U64),
+        [OP_MUL_F32] = HANDLER_ADDRESS(MUL_F32),
+        [OP_MUL_F64] = HANDLER_ADDRESS(MUL_F64),
+        [OP_DIV_I32] = HANDLER_ADDRESS(DIV_I32),
+        [OP_DIV_I64] = HANDLER_ADDRESS(DIV_I64),
+        [OP_DIV_U32] = HANDLER_ADDRESS(DIV_U32),
+        [OP_DIV_U64] = HANDLER_ADDRESS(DIV_U64),
+        [OP_DIV_F32] = HANDLER_ADDRESS(DIV_F32),
+        [OP_DIV_F64] = HANDLER_ADDRESS(DIV_F64),
+        [OP_REM_I32] = HANDLER_ADDRESS(REM_I32),
+        [OP_REM_I64] = HANDLER_ADDRESS(REM_I64),
+        [OP_REM_U32] = HANDLER_ADDRESS(REM_U32),
+        [OP_REM_U64] = HANDLER_ADDRESS(REM_U64),
+        [OP_NEG_I32] = HANDLER_ADDRESS(NEG_I32),
+        [OP_NEG_I64] = HANDLER_ADDRESS(NEG_I64),
+        [OP_NEG_F32] = HANDLER_ADDRESS(NEG_F32),
+        [OP_NEG_F64] = HANDLER_ADDRESS(NEG_F64),
+        [OP_SQRT_F32] = HANDLER_ADDRESS(SQRT_F32),
+        [OP_SQRT_F64] = HANDLER_ADDRESS(SQRT_F64),
+        [OP_EXP_F32] = HANDLER_ADDRESS(EXP_F32),
+        [OP_EXP_F64] = HANDLER_ADDRESS(EXP_F64),
+        [OP_LOG_F32] = HANDLER_ADDRESS(LOG_F32),
+        [OP_LOG_F64] = HANDLER_ADDRESS(LOG_F64),
+
+        [OP_NOT_WORD] = HANDLER_ADDRESS(NOT_WORD),
+        [OP_NOT_DWORD] = HANDLER_ADDRESS(NOT_DWORD),
+        [OP_AND_WORD] = HANDLER_ADDRESS(AND_WORD),
+        [OP_AND_DWORD] = HANDLER_ADDRESS(AND_DWORD),
+        [OP_OR_WORD] = HANDLER_ADDRESS(OR_WORD),
+        [OP_OR_DWORD] = HANDLER_ADDRESS(OR_DWORD),
+        [OP_XOR_WORD] = HANDLER_ADDRESS(XOR_WORD),
+        [OP_XOR_DWORD] = HANDLER_ADDRESS(XOR_DWORD),
+        [OP_SHL_WORD] = HANDLER_ADDRESS(SHL_WORD),
+        [OP_SHL_DWORD] = HANDLER_ADDRESS(SHL_DWORD),
+        [OP_SHR_I32] = HANDLER_ADDRESS(SHR_I32),
+        [OP_SHR_I64] = HANDLER_ADDRESS(SHR_I64),
+        [OP_SHR_U32] = HANDLER_ADDRESS(SHR_U32),
+        [OP_SHR_U64] = HANDLER_ADDRESS(SHR_U64),
+
+        [OP_I32_TO_I8] = HANDLER_ADDRESS(I32_TO_I8),
+        [OP_I32_TO_I16] = HANDLER_ADDRESS(I32_TO_I16),
+        [OP_I32_TO_I64] = HANDLER_ADDRESS(I32_TO_I64),
+        [OP_I32_TO_F32] = HANDLER_ADDRESS(I32_TO_F32),
+        [OP_I32_TO_F64] = HANDLER_ADDRESS(I32_TO_F64),
+        [OP_I64_TO_I32] = HANDLER_ADDRESS(I64_TO_I32),
+        [OP_I64_TO_F32] = HANDLER_ADDRESS(I64_TO_F32),
+        [OP_I64_TO_F64] = HANDLER_ADDRESS(I64_TO_F64),
+        [OP_F32_TO_I32] = HANDLER_ADDRESS(F32_TO_I32),
+        [OP_F32_TO_I64] = HANDLER_ADDRESS(F32_TO_I64),
+        [OP_F32_TO_F64] = HANDLER_ADDRESS(F32_TO_F64),
+        [OP_F64_TO_I32] = HANDLER_ADDRESS(F64_TO_I32),
+        [OP_F64_TO_I64] = HANDLER_ADDRESS(F64_TO_I64),
+        [OP_F64_TO_F32] = HANDLER_ADDRESS(F64_TO_F32),
+
+        [OP_CMP_WORD_EQ] = HANDLER_ADDRESS(CMP_WORD_EQ),
+        [OP_CMP_DWORD_EQ] = HANDLER_ADDRESS(CMP_DWORD_EQ),
+        [OP_CMP_WORD_NE] = HANDLER_ADDRESS(CMP_WORD_NE),
+        [OP_CMP_DWORD_NE] = HANDLER_ADDRESS(CMP_DWORD_NE),
+        [OP_CMP_I32_GT] = HANDLER_ADDRESS(CMP_I32_GT),
+        [OP_CMP_I64_GT] = HANDLER_ADDRESS(CMP_I64_GT),
+        [OP_CMP_U32_GT] = HANDLER_ADDRESS(CMP_U32_GT),
+        [OP_CMP_U64_GT] = HANDLER_ADDRESS(CMP_U64_GT),
+        [OP_CMP_F32_GT] = HANDLER_ADDRESS(CMP_F32_GT),
+        [OP_CMP_F64_GT] = HANDLER_ADDRESS(CMP_F64_GT),
+        [OP_CMP_I32_LT] = HANDLER_ADDRESS(CMP_I32_LT),
+        [OP_CMP_I64_LT] = HANDLER_ADDRESS(CMP_I64_LT),
+        [OP_CMP_U32_LT] = HANDLER_ADDRESS(CMP_U32_LT),
+        [OP_CMP_U64_LT] = HANDLER_ADDRESS(CMP_U64_LT),
+        [OP_CMP_F32_LT] = HANDLER_ADDRESS(CMP_F32_LT),
+        [OP_CMP_F64_LT] = HANDLER_ADDRESS(CMP_F64_LT),
+        [OP_CMP_I32_GE] = HANDLER_ADDRESS(CMP_I32_GE),
+        [OP_CMP_I64_GE] = HANDLER_ADDRESS(CMP_I64_GE),
+        [OP_CMP_U32_GE] = HANDLER_ADDRESS(CMP_U32_GE),
+        [OP_CMP_U64_GE] = HANDLER_ADDRESS(CMP_U64_GE),
+        [OP_CMP_F32_GE] = HANDLER_ADDRESS(CMP_F32_GE),
+        [OP_CMP_F64_GE] = HANDLER_ADDRESS(CMP_F64_GE),
+        [OP_CMP_I32_LE] = HANDLER_ADDRESS(CMP_I32_LE),
+        [OP_CMP_I64_LE] = HANDLER_ADDRESS(CMP_I64_LE),
+        [OP_CMP_U32_LE] = HANDLER_ADDRESS(CMP_U32_LE),
+        [OP_CMP_U64_LE] = HANDLER_ADDRESS(CMP_U64_LE),
+        [OP_CMP_F32_LE] = HANDLER_ADDRESS(CMP_F32_LE),
+        [OP_CMP_F64_LE] = HANDLER_ADDRESS(CMP_F64_LE),
+        [OP_CMP_NOT] = HANDLER_ADDRESS(CMP_NOT),
+
+        [OP_LOAD_WORD] = HANDLER_ADDRESS(LOAD_WORD),
+        [OP_LOAD_DWORD] = HANDLER_ADDRESS(LOAD_DWORD),
+        [OP_STORE_WORD] = HANDLER_ADDRESS(STORE_WORD),
+        [OP_STORE_DWORD] = HANDLER_ADDRESS(STORE_DWORD),
+        [OP_LOAD_OFST_WORD] = HANDLER_ADDRESS(LOAD_OFST_WORD),
+        [OP_LOAD_OFST_DWORD] = HANDLER_ADDRESS(LOAD_OFST_DWORD),
+        [OP_STORE_OFST_WORD] = HANDLER_ADDRESS(STORE_OFST_WORD),
+        [OP_STORE_OFST_DWORD] = HANDLER_ADDRESS(STORE_OFST_DWORD),
+        [OP_MEMMOV] = HANDLER_ADDRESS(MEMMOV),
+        [OP_MEMCPY] = HANDLER_ADDRESS(MEMCPY),
+
+        [OP_JMP] = HANDLER_ADDRESS(JMP),
+        [OP_JMP_IF] = HANDLER_ADDRESS(JMP_IF),
+        [OP_CALL] = HANDLER_ADDRESS(CALL),
+        [OP_TAILCALL] = HANDLER_ADDRESS(TAILCALL),
+        [OP_SYSCALL] = HANDLER_ADDRESS(SYSCALL),
+        [OP_RET] = HANDLER_ADDRESS(RET),
+
+        [OP_ADD_I32_LOC_IMM] = HANDLER_ADDRESS(ADD_I32_LOC_IMM),
+        [OP_ADD_I32_LOC_LOC] = HANDLER_ADDRESS(ADD_I32_LOC_LOC),
+        [OP_JMP_WORD_EQ] = HANDLER_ADDRESS(JMP_WORD_EQ),
+        [OP_JMP_WORD_NE] = HANDLER_ADDRESS(JMP_WORD_NE),
+        [OP_JMP_I32_GT] = HANDLER_ADDRESS(JMP_I32_GT),
+        [OP_JMP_I32_LT] = HANDLER_ADDRESS(JMP_I32_LT),
+        [OP_JMP_I32_GE] = HANDLER_ADDRESS(JMP_I32_GE),
+        [OP_JMP_I32_LE] = HANDLER_ADDRESS(JMP_I32_LE),
+    };
+#pragma GCC diagnostic pop
+#pragma endregion
+    if(handlers)
+    {
+        *handlers = ThreadedPointers;
+        return 0;
+    }
+
+    Cell            *pc; // Program Counter
+    Word            *fp; // Frame Pointer
+    FunctionHeader  *fh; // Function Header
+#ifndef THREADED_TAILCALLS
+    Word            *sp; // Stack Pointer, only set by the system calls
+#endif
+
+    // base of the caller headers in the frames
+    const Byte *fbase = context->FunctionsBuffer;
+
+    pc = context->EntryPoint->Header.ThreadedBody;
+    fp = context->StackBottom;
+    fh = &context->EntryPoint->Header;
+
+#ifdef THREADED_TAILCALLS
+    return ((ThreadedHandler)pc->Handler)(pc + 1, fp, fh, context, fbase);
+#else
+    sp = fp;
+    CONTINUE;
+#include "threaded_handlers.h"
+#endif
+}
+
+const void *const *ThreadedHandlers(void)
+{
+    const void *const *handlers;
+    iExecuteThreaded(NULL, &handlers);
+    return handlers;
+}
+i32 ExecuteThreaded(ProgramContext *context) { return iExecuteThreaded(context, NULL); }
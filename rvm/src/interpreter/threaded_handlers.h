@@ -0,0 +1,837 @@
+/*
+    The handlers of the threaded code, included by interpreter/threaded.c. HANDLER(name) opens the handler of a register 
+    instruction and CONTINUE dispatches the next one, with the computed gotos the handlers are labels in the body of 
+    ExecuteThreaded and with THREADED_TAILCALLS they are functions that get the registers as arguments.
+    The registers are pc, fp, fh, context and fbase, the stack pointer is set only by the system calls and it is a local
+    of their handler when it is a function.
+*/
+HANDLER(NOT_IMPLEMENTED)
+{
+    UNLIKELY(false, "Instruction not supported by the threaded code in function %s!\n", fh->Signature);
+    exit(EXIT_FAILURE);
+}
+#pragma region Push
+HANDLER(PUSH_WORD)
+{
+    Word *d = SLOT(fp, pc);
+    *d = (pc++)->Word;
+    CONTINUE;
+}
+HANDLER(PUSH_DWORD)
+{
+    DWord *d = (DWord*)SLOT(fp, pc);
+    *d = (pc++)->DWord;
+    CONTINUE;
+}
+HANDLER(LOAD_GLOB_WORD)
+{
+    Word *d = SLOT(fp, pc);
+    *d = *(Word*)(pc++)->Ptr;
+    CONTINUE;
+}
+HANDLER(LOAD_GLOB_DWORD)
+{
+    DWord *d = (DWord*)SLOT(fp, pc);
+    *d = *(DWord*)(pc++)->Ptr;
+    CONTINUE;
+}
+HANDLER(MOV_WORD)
+{
+    Word *d = SLOT(fp, pc);
+    *d = *SLOT(fp, pc);
+    CONTINUE;
+}
+HANDLER(MOV_DWORD)
+{
+    DWord *d = (DWord*)SLOT(fp, pc);
+    *d = *(DWord*)SLOT(fp, pc);
+    CONTINUE;
+}
+#pragma endregion
+#pragma region Arithmetic
+HANDLER(ADD_I32)
+{
+    REG_BINARY_OPERATION_WORD(fp, pc, Int, +);
+    CONTINUE;
+}
+HANDLER(ADD_I64)
+{
+    REG_BINARY_OPERATION_DWORD(fp, pc, Int, +);
+    CONTINUE;
+}
+HANDLER(ADD_F32)
+{
+    REG_BINARY_OPERATION_WORD(fp, pc, Float, +);
+    CONTINUE;
+}
+HANDLER(ADD_F64)
+{
+    REG_BINARY_OPERATION_DWORD(fp, pc, Float, +);
+    CONTINUE;
+}
+HANDLER(INC_I32)
+{
+    REG_SLOT_OPERATION_WORD(fp, pc, Int, +, i32);
+    CONTINUE;
+}
+HANDLER(INC_I64)
+{
+    REG_SLOT_OPERATION_DWORD(fp, pc, Int, +, i64);
+    CONTINUE;
+}
+HANDLER(INC_F32)
+{
+    REG_SLOT_OPERATION_WORD(fp, pc, Float, +, f32);
+    CONTINUE;
+}
+HANDLER(INC_F64)
+{
+    REG_SLOT_OPERATION_DWORD(fp, pc, Float, +, f64);
+    CONTINUE;
+}
+HANDLER(SUB_I32)
+{
+    REG_BINARY_OPERATION_WORD(fp, pc, Int, -);
+    CONTINUE;
+}
+HANDLER(SUB_I64)
+{
+    REG_BINARY_OPERATION_DWORD(fp, pc, Int, -);
+    CONTINUE;
+}
+HANDLER(SUB_F32)
+{
+    REG_BINARY_OPERATION_WORD(fp, pc, Float, -);
+    CONTINUE;
+}
+HANDLER(SUB_F64)
+{
+    REG_BINARY_OPERATION_DWORD(fp, pc, Float, -);
+    CONTINUE;
+}
+HANDLER(DEC_I32)
+{
+    REG_SLOT_OPERATION_WORD(fp, pc, Int, -, i32);
+    CONTINUE;
+}
+HANDLER(DEC_I64)
+{
+    REG_SLOT_OPERATION_DWORD(fp, pc, Int, -, i64);
+    CONTINUE;
+}
+HANDLER(DEC_F32)
+{
+    REG_SLOT_OPERATION_WORD(fp, pc, Float, -, f32);
+    CONTINUE;
+}
+HANDLER(DEC_F64)
+{
+    REG_SLOT_OPERATION_DWORD(fp, pc, Float, -, f64);
+    CONTINUE;
+}
+HANDLER(MUL_I32)
+{
+    REG_BINARY_OPERATION_WORD(fp, pc, Int, *);
+    CONTINUE;
+}
+HANDLER(MUL_I64)
+{
+    REG_BINARY_OPERATION_DWORD(fp, pc, Int, *);
+    CONTINUE;
+}
+HANDLER(MUL_U32)
+{
+    REG_BINARY_OPERATION_WORD(fp, pc, UInt, *);
+    CONTINUE;
+}
+HANDLER(MUL_U64)
+{
+    REG_BINARY_OPERATION_DWORD(fp, pc, UInt, *);
+    CONTINUE;
+}
+HANDLER(MUL_F32)
+{
+    REG_BINARY_OPERATION_WORD(fp, pc, Float, *);
+    CONTINUE;
+}
+HANDLER(MUL_F64)
+{
+    REG_BINARY_OPERATION_DWORD(fp, pc, Float, *);
+    CONTINUE;
+}
+HANDLER(DIV_I32)
+{
+    REG_BINARY_OPERATION_WORD(fp, pc, Int, /);
+    CONTINUE;
+}
+HANDLER(DIV_I64)
+{
+    REG_BINARY_OPERATION_DWORD(fp, pc, Int, /);
+    CONTINUE;
+}
+HANDLER(DIV_U32)
+{
+    REG_BINARY_OPERATION_WORD(fp, pc, UInt, /);
+    CONTINUE;
+}
+HANDLER(DIV_U64)
+{
+    REG_BINARY_OPERATION_DWORD(fp, pc, UInt, /);
+    CONTINUE;
+}
+HANDLER(DIV_F32)
+{
+    REG_BINARY_OPERATION_WORD(fp, pc, Float, /);
+    CONTINUE;
+}
+HANDLER(DIV_F64)
+{
+    REG_BINARY_OPERATION_DWORD(fp, pc, Float, /);
+    CONTINUE;
+}
+HANDLER(REM_I32)
+{
+    REG_BINARY_OPERATION_WORD(fp, pc, Int, %);
+    CONTINUE;
+}
+HANDLER(REM_I64)
+{
+    REG_BINARY_OPERATION_DWORD(fp, pc, Int, %);
+    CONTINUE;
+}
+HANDLER(REM_U32)
+{
+    REG_BINARY_OPERATION_WORD(fp, pc, UInt, %);
+    CONTINUE;
+}
+HANDLER(REM_U64)
+{
+    REG_BINARY_OPERATION_DWORD(fp, pc, UInt, %);
+    CONTINUE;
+}
+HANDLER(NEG_I32)
+{
+    REG_UNARY_OPERATION_WORD(fp, pc, Int, -);
+    CONTINUE;
+}
+HANDLER(NEG_I64)
+{
+    REG_UNARY_OPERATION_DWORD(fp, pc, Int, -);
+    CONTINUE;
+}
+HANDLER(NEG_F32)
+{
+    REG_UNARY_OPERATION_WORD(fp, pc, Float, -);
+    CONTINUE;
+}
+HANDLER(NEG_F64)
+{
+    REG_UNARY_OPERATION_DWORD(fp, pc, Float, -);
+    CONTINUE;
+}
+#pragma endregion
+#pragma region Math
+HANDLER(SQRT_F32)
+{
+    REG_MATH_WORD(fp, pc, sqrtf);
+    CONTINUE;
+}
+HANDLER(SQRT_F64)
+{
+    REG_MATH_DWORD(fp, pc, sqrt);
+    CONTINUE;
+}
+HANDLER(EXP_F32)
+{
+    REG_MATH_WORD(fp, pc, expf);
+    CONTINUE;
+}
+HANDLER(EXP_F64)
+{
+    REG_MATH_DWORD(fp, pc, exp);
+    CONTINUE;
+}
+HANDLER(LOG_F32)
+{
+    REG_MATH_WORD(fp, pc, logf);
+    CONTINUE;
+}
+HANDLER(LOG_F64)
+{
+    REG_MATH_DWORD(fp, pc, log);
+    CONTINUE;
+}
+#pragma endregion
+#pragma region Bitwise
+HANDLER(NOT_WORD)
+{
+    REG_UNARY_OPERATION_WORD(fp, pc, Int, ~);
+    CONTINUE;
+}
+HANDLER(NOT_DWORD)
+{
+    REG_UNARY_OPERATION_DWORD(fp, pc, Int, ~);
+    CONTINUE;
+}
+HANDLER(AND_WORD)
+{
+    REG_BINARY_OPERATION_WORD(fp, pc, Int, &);
+    CONTINUE;
+}
+HANDLER(AND_DWORD)
+{
+    REG_BINARY_OPERATION_DWORD(fp, pc, Int, &);
+    CONTINUE;
+}
+HANDLER(OR_WORD)
+{
+    REG_BINARY_OPERATION_WORD(fp, pc, Int, |);
+    CONTINUE;
+}
+HANDLER(OR_DWORD)
+{
+    REG_BINARY_OPERATION_DWORD(fp, pc, Int, |);
+    CONTINUE;
+}
+HANDLER(XOR_WORD)
+{
+    REG_BINARY_OPERATION_WORD(fp, pc, Int, ^);
+    CONTINUE;
+}
+HANDLER(XOR_DWORD)
+{
+    REG_BINARY_OPERATION_DWORD(fp, pc, Int, ^);
+    CONTINUE;
+}
+HANDLER(SHL_WORD)
+{
+    REG_BINARY_OPERATION_WORD(fp, pc, Int, <<);
+    CONTINUE;
+}
+HANDLER(SHL_DWORD)
+{
+    REG_BINARY_OPERATION_DWORD(fp, pc, Int, <<);
+    CONTINUE;
+}
+HANDLER(SHR_I32)
+{
+    REG_BINARY_OPERATION_WORD(fp, pc, Int, >>);
+    CONTINUE;
+}
+HANDLER(SHR_I64)
+{
+    REG_BINARY_OPERATION_DWORD(fp, pc, Int, >>);
+    CONTINUE;
+}
+HANDLER(SHR_U32)
+{
+    REG_BINARY_OPERATION_WORD(fp, pc, UInt, >>);
+    CONTINUE;
+}
+HANDLER(SHR_U64)
+{
+    REG_BINARY_OPERATION_DWORD(fp, pc, UInt, >>);
+    CONTINUE;
+}
+#pragma endregion
+#pragma region Cast
+HANDLER(I32_TO_I8)
+{
+    REG_CAST(fp, pc, Word, Word, Int, Int, i8);
+    CONTINUE;
+}
+HANDLER(I32_TO_I16)
+{
+    REG_CAST(fp, pc, Word, Word, Int, Int, i16);
+    CONTINUE;
+}
+HANDLER(I32_TO_I64)
+{
+    REG_CAST(fp, pc, Word, DWord, Int, Int, i64);
+    CONTINUE;
+}
+HANDLER(I32_TO_F32)
+{
+    REG_CAST(fp, pc, Word, Word, Int, Float, f32);
+    CONTINUE;
+}
+HANDLER(I32_TO_F64)
+{
+    REG_CAST(fp, pc, Word, DWord, Int, Float, f64);
+    CONTINUE;
+}
+HANDLER(I64_TO_I32)
+{
+    REG_CAST(fp, pc, DWord, Word, Int, Int, i32);
+    CONTINUE;
+}
+HANDLER(I64_TO_F32)
+{
+    REG_CAST(fp, pc, DWord, Word, Int, Float, f32);
+    CONTINUE;
+}
+HANDLER(I64_TO_F64)
+{
+    REG_CAST(fp, pc, DWord, DWord, Int, Float, f64);
+    CONTINUE;
+}
+HANDLER(F32_TO_I32)
+{
+    REG_CAST(fp, pc, Word, Word, Float, Int, i32);
+    CONTINUE;
+}
+HANDLER(F32_TO_I64)
+{
+    REG_CAST(fp, pc, Word, DWord, Float, Int, i64);
+    CONTINUE;
+}
+HANDLER(F32_TO_F64)
+{
+    REG_CAST(fp, pc, Word, DWord, Float, Float, f64);
+    CONTINUE;
+}
+HANDLER(F64_TO_I32)
+{
+    REG_CAST(fp, pc, DWord, Word, Float, Int, i32);
+    CONTINUE;
+}
+HANDLER(F64_TO_I64)
+{
+    REG_CAST(fp, pc, DWord, DWord, Float, Int, i64);
+    CONTINUE;
+}
+HANDLER(F64_TO_F32)
+{
+    REG_CAST(fp, pc, DWord, Word, Float, Float, f32);
+    CONTINUE;
+}
+#pragma endregion
+#pragma region Compare
+HANDLER(CMP_WORD_EQ)
+{
+    REG_BINARY_OPERATION_WORD(fp, pc, Int, ==);
+    CONTINUE;
+}
+HANDLER(CMP_DWORD_EQ)
+{
+    REG_BINARY_OPERATION_DWORD(fp, pc, Int, ==);
+    CONTINUE;
+}
+HANDLER(CMP_WORD_NE)
+{
+    REG_BINARY_OPERATION_WORD(fp, pc, Int, !=);
+    CONTINUE;
+}
+HANDLER(CMP_DWORD_NE)
+{
+    REG_BINARY_OPERATION_DWORD(fp, pc, Int, !=);
+    CONTINUE;
+}
+HANDLER(CMP_I32_GT)
+{
+    REG_BINARY_OPERATION_WORD(fp, pc, Int, >);
+    CONTINUE;
+}
+HANDLER(CMP_I64_GT)
+{
+    REG_BINARY_OPERATION_DWORD(fp, pc, Int, >);
+    CONTINUE;
+}
+HANDLER(CMP_U32_GT)
+{
+    REG_BINARY_OPERATION_WORD(fp, pc, UInt, >);
+    CONTINUE;
+}
+HANDLER(CMP_U64_GT)
+{
+    REG_BINARY_OPERATION_DWORD(fp, pc, UInt, >);
+    CONTINUE;
+}
+HANDLER(CMP_F32_GT)
+{
+    REG_BINARY_OPERATION_WORD(fp, pc, Float, >);
+    CONTINUE;
+}
+HANDLER(CMP_F64_GT)
+{
+    REG_BINARY_OPERATION_DWORD(fp, pc, Float, >);
+    CONTINUE;
+}
+HANDLER(CMP_I32_LT)
+{
+    REG_BINARY_OPERATION_WORD(fp, pc, Int, <);
+    CONTINUE;
+}
+HANDLER(CMP_I64_LT)
+{
+    REG_BINARY_OPERATION_DWORD(fp, pc, Int, <);
+    CONTINUE;
+}
+HANDLER(CMP_U32_LT)
+{
+    REG_BINARY_OPERATION_WORD(fp, pc, UInt, <);
+    CONTINUE;
+}
+HANDLER(CMP_U64_LT)
+{
+    REG_BINARY_OPERATION_DWORD(fp, pc, UInt, <);
+    CONTINUE;
+}
+HANDLER(CMP_F32_LT)
+{
+    REG_BINARY_OPERATION_WORD(fp, pc, Float, <);
+    CONTINUE;
+}
+HANDLER(CMP_F64_LT)
+{
+    REG_BINARY_OPERATION_DWORD(fp, pc, Float, <);
+    CONTINUE;
+}
+HANDLER(CMP_I32_GE)
+{
+    REG_BINARY_OPERATION_WORD(fp, pc, Int, >=);
+    CONTINUE;
+}
+HANDLER(CMP_I64_GE)
+{
+    REG_BINARY_OPERATION_DWORD(fp, pc, Int, >=);
+    CONTINUE;
+}
+HANDLER(CMP_U32_GE)
+{
+    REG_BINARY_OPERATION_WORD(fp, pc, UInt, >=);
+    CONTINUE;
+}
+HANDLER(CMP_U64_GE)
+{
+    REG_BINARY_OPERATION_DWORD(fp, pc, UInt, >=);
+    CONTINUE;
+}
+HANDLER(CMP_F32_GE)
+{
+    REG_BINARY_OPERATION_WORD(fp, pc, Float, >=);
+    CONTINUE;
+}
+HANDLER(CMP_F64_GE)
+{
+    REG_BINARY_OPERATION_DWORD(fp, pc, Float, >=);
+    CONTINUE;
+}
+HANDLER(CMP_I32_LE)
+{
+    REG_BINARY_OPERATION_WORD(fp, pc, Int, <=);
+    CONTINUE;
+}
+HANDLER(CMP_I64_LE)
+{
+    REG_BINARY_OPERATION_DWORD(fp, pc, Int, <=);
+    CONTINUE;
+}
+HANDLER(CMP_U32_LE)
+{
+    REG_BINARY_OPERATION_WORD(fp, pc, UInt, <=);
+    CONTINUE;
+}
+HANDLER(CMP_U64_LE)
+{
+    REG_BINARY_OPERATION_DWORD(fp, pc, UInt, <=);
+    CONTINUE;
+}
+HANDLER(CMP_F32_LE)
+{
+    REG_BINARY_OPERATION_WORD(fp, pc, Float, <=);
+    CONTINUE;
+}
+HANDLER(CMP_F64_LE)
+{
+    REG_BINARY_OPERATION_DWORD(fp, pc, Float, <=);
+    CONTINUE;
+}
+HANDLER(CMP_NOT)
+{
+    REG_UNARY_OPERATION_WORD(fp, pc, Int, !);
+    CONTINUE;
+}
+#pragma endregion
+#pragma region Load & Store
+HANDLER(LOAD_WORD)
+{
+    Word *d = SLOT(fp, pc);
+    DWord ref = *(DWord*)SLOT(fp, pc);
+    *d = *ref.WordPtr;
+    CONTINUE;
+}
+HANDLER(LOAD_DWORD)
+{
+    DWord *d = (DWord*)SLOT(fp, pc);
+    DWord ref = *(DWord*)SLOT(fp, pc);
+    *d = *(DWord*)ref.WordPtr;
+    CONTINUE;
+}
+HANDLER(STORE_WORD)
+{
+    DWord ref = *(DWord*)SLOT(fp, pc);
+    *ref.WordPtr = *SLOT(fp, pc);
+    CONTINUE;
+}
+HANDLER(STORE_DWORD)
+{
+    DWord ref = *(DWord*)SLOT(fp, pc);
+    *(DWord*)ref.WordPtr = *(DWord*)SLOT(fp, pc);
+    CONTINUE;
+}
+// the offset is in bytes like the slots so SLOT applies it to the reference
+HANDLER(LOAD_OFST_WORD)
+{
+    Word *d = SLOT(fp, pc);
+    DWord ref = *(DWord*)SLOT(fp, pc);
+    *d = *SLOT(ref.WordPtr, pc);
+    CONTINUE;
+}
+HANDLER(LOAD_OFST_DWORD)
+{
+    DWord *d = (DWord*)SLOT(fp, pc);
+    DWord ref = *(DWord*)SLOT(fp, pc);
+    *d = *(DWord*)SLOT(ref.WordPtr, pc);
+    CONTINUE;
+}
+HANDLER(STORE_OFST_WORD)
+{
+    DWord ref = *(DWord*)SLOT(fp, pc);
+    Word  val = *SLOT(fp, pc);
+    *SLOT(ref.WordPtr, pc) = val;
+    CONTINUE;
+}
+HANDLER(STORE_OFST_DWORD)
+{
+    DWord ref = *(DWord*)SLOT(fp, pc);
+    DWord val = *(DWord*)SLOT(fp, pc);
+    *(DWord*)SLOT(ref.WordPtr, pc) = val;
+    CONTINUE;
+}
+HANDLER(MEMMOV)
+{
+    DWord dest = *(DWord*)SLOT(fp, pc);
+    DWord src  = *(DWord*)SLOT(fp, pc);
+    Word  n    = *SLOT(fp, pc);
+    memmove(dest.Ptr, src.Ptr, n.UInt);
+    CONTINUE;
+}
+HANDLER(MEMCPY)
+{
+    DWord dest = *(DWord*)SLOT(fp, pc);
+    DWord src  = *(DWord*)SLOT(fp, pc);
+    Word  n    = *SLOT(fp, pc);
+    memcpy(dest.Ptr, src.Ptr, n.UInt);
+    CONTINUE;
+}
+#pragma endregion
+#pragma region Control flow
+HANDLER(JMP)
+{
+    pc = pc->Target;
+    CONTINUE;
+}
+HANDLER(JMP_IF)
+{
+    Word  c = *SLOT(fp, pc);
+    Cell *t = (pc++)->Target;
+    if(c.Int)
+        pc = t;
+    CONTINUE;
+}
+HANDLER(CALL)
+{
+    // the arguments are the first locals of the callee frame like in the stack interpreter
+    Word *newFP = SLOT(fp, pc);
+    FunctionHeader *header = &((Function*)(pc++)->Ptr)->Header;
+    u16 lwc = header->LWC;
+    u16 swc = header->SWC;
+
+    Word *frameHeader = FRAME_HEADER(newFP, lwc);
+    STACK_PROBE(frameHeader + FRAME_HEADER_SIZE + swc, header);
+    PUSH_FRAME_HEADER(frameHeader, newFP, pc, fp, fh, fbase);
+
+    fp = newFP;
+    pc = header->ThreadedBody;
+    fh = header;
+    CONTINUE;
+}
+HANDLER(TAILCALL)
+{
+    // the arguments become the first locals of the running frame and its header is moved after the callee locals
+    Word *args = SLOT(fp, pc);
+    FunctionHeader *header = &((Function*)(pc++)->Ptr)->Header;
+    u16 lwc = header->LWC;
+    u16 swc = header->SWC;
+
+    Word link[FRAME_HEADER_SIZE];
+    memcpy(link, FRAME_HEADER(fp, fh->LWC), sizeof(link));
+    memmove(fp, args, header->AWC * SIZEOF_WORD);
+    Word *frameHeader = FRAME_HEADER(fp, lwc);
+    STACK_PROBE(frameHeader + FRAME_HEADER_SIZE + swc, header);
+    memcpy(frameHeader, link, sizeof(link));
+
+    pc = header->ThreadedBody;
+    fh = header;
+    CONTINUE;
+}
+HANDLER(SYSCALL)
+{
+    static const void *SyscallPointers[] =
+    {
+        &&HANDLE_SYSCALL_EXIT,
+        &&HANDLE_SYSCALL_PRINT,
+        &&HANDLE_SYSCALL_PRINTI,
+        &&HANDLE_SYSCALL_PRINTF,
+        &&HANDLE_SYSCALL_SCAN,
+        &&HANDLE_SYSCALL_SCANI,
+        &&HANDLE_SYSCALL_SCANF,
+        &&HANDLE_SYSCALL_MEMMOV,
+        &&HANDLE_SYSCALL_MEMCPY,
+        &&HANDLE_SYSCALL_CLOCK,
+        &&HANDLE_SYSCALL_SQRT32,
+        &&HANDLE_SYSCALL_SQRT64,
+        &&HANDLE_SYSCALL_EXP32,
+        &&HANDLE_SYSCALL_EXP64,
+        &&HANDLE_SYSCALL_LOG32,
+        &&HANDLE_SYSCALL_LOG64,
+    };
+
+#ifdef THREADED_TAILCALLS
+    Word *sp;
+#endif
+    sp = SLOT(fp, pc);
+    u64 f = (pc++)->UInt;
+    goto *SyscallPointers[f];
+
+    HANDLE_SYSCALL_EXIT:
+    {
+        Word exitCode = *(sp - 1);
+        return exitCode.Int;
+    }
+    HANDLE_SYSCALL_PRINT:
+        SYSCALL_PRINT(sp);
+        CONTINUE;
+    HANDLE_SYSCALL_PRINTI:
+        SYSCALL_PRINTI(sp);
+        CONTINUE;
+    HANDLE_SYSCALL_PRINTF:
+        SYSCALL_PRINTF(sp);
+        CONTINUE;
+    HANDLE_SYSCALL_SCAN:
+        SYSCALL_SCAN(sp);
+        CONTINUE;
+    HANDLE_SYSCALL_SCANI:
+        SYSCALL_SCANI(sp);
+        CONTINUE;
+    HANDLE_SYSCALL_SCANF:
+        SYSCALL_SCANF(sp);
+        CONTINUE;
+    HANDLE_SYSCALL_MEMMOV:
+        SYSCALL_MEMMOV(sp);
+        CONTINUE;
+    HANDLE_SYSCALL_MEMCPY:
+        SYSCALL_MEMCPY(sp);
+        CONTINUE;
+    HANDLE_SYSCALL_CLOCK:
+        SYSCALL_CLOCK(sp);
+        CONTINUE;
+    HANDLE_SYSCALL_SQRT32:
+        SYSCALL_MATH_WORD(sp, sqrtf);
+        CONTINUE;
+    HANDLE_SYSCALL_SQRT64:
+        SYSCALL_MATH_DWORD(sp, sqrt);
+        CONTINUE;
+    HANDLE_SYSCALL_EXP32:
+        SYSCALL_MATH_WORD(sp, expf);
+        CONTINUE;
+    HANDLE_SYSCALL_EXP64:
+        SYSCALL_MATH_DWORD(sp, exp);
+        CONTINUE;
+    HANDLE_SYSCALL_LOG32:
+        SYSCALL_MATH_WORD(sp, logf);
+        CONTINUE;
+    HANDLE_SYSCALL_LOG64:
+        SYSCALL_MATH_DWORD(sp, log);
+        CONTINUE;
+}
+HANDLER(RET)
+{
+    Word *results = SLOT(fp, pc);
+    Word *frameHeader = FRAME_HEADER(fp, fh->LWC);
+    Cell *prevPC = FRAME_PC(frameHeader);
+    Word *prevFP = FRAME_FP(frameHeader, fp);
+    FunctionHeader *prevFH = FRAME_FH(frameHeader, fbase);
+
+    // the results take the place of the arguments in the caller frame, the common sizes are moved at once
+    switch (fh->RWC)
+    {
+    case 0:
+        break;
+    case 1:
+        *fp = *results;
+        break;
+    case 2:
+        *(DWord*)fp = *(DWord*)results;
+        break;
+    default:
+        for (u16 i = 0; i < fh->RWC; i++)
+            fp[i] = results[i];
+        break;
+    }
+
+    fp = prevFP;
+    pc = prevPC;
+    fh = prevFH;
+    CONTINUE;
+}
+#pragma endregion
+#pragma region Superinstructions
+HANDLER(ADD_I32_LOC_IMM)
+{
+    Word *s = SLOT(fp, pc);
+    i32   v = (i32) (pc++)->Int;
+    Word *d = SLOT(fp, pc);
+    d->Int = s->Int + v;
+    CONTINUE;
+}
+HANDLER(ADD_I32_LOC_LOC)
+{
+    Word *a = SLOT(fp, pc);
+    Word *b = SLOT(fp, pc);
+    Word *d = SLOT(fp, pc);
+    d->Int = a->Int + b->Int;
+    CONTINUE;
+}
+HANDLER(JMP_WORD_EQ)
+{
+    REG_COMPARE_JUMP_WORD(fp, pc, Int, ==);
+    CONTINUE;
+}
+HANDLER(JMP_WORD_NE)
+{
+    REG_COMPARE_JUMP_WORD(fp, pc, Int, !=);
+    CONTINUE;
+}
+HANDLER(JMP_I32_GT)
+{
+    REG_COMPARE_JUMP_WORD(fp, pc, Int, >);
+    CONTINUE;
+}
+HANDLER(JMP_I32_LT)
+{
+    REG_COMPARE_JUMP_WORD(fp, pc, Int, <);
+    CONTINUE;
+}
+HANDLER(JMP_I32_GE)
+{
+    REG_COMPARE_JUMP_WORD(fp, pc, Int, >=);
+    CONTINUE;
+}
+HANDLER(JMP_I32_LE)
+{
+    REG_COMPARE_JUMP_WORD(fp, pc, Int, <=);
+    CONTINUE;
+}
+#pragma endregion
@@ -0,0 +1,6 @@
+/*
+    The tiered variant of the stack interpreter, it is the same code of interpreter.c compiled with the hotness counters.
+    Keeping it in its own function leaves Execute without them, so a program that runs with no tiering pays nothing.
+*/
+#define EXECUTE_TIERING
+#include "interpreter.c"
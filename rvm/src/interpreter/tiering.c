@@ -0,0 +1,45 @@
+#include <stdlib.h>
+#include <stdio.h>
+
+#include "raiu/raiu.h"
+#include "metadata.h"
+#include "rvm.h"
+#include "linker/linker.h"
+
+Byte *TierUp(ProgramContext *context, FunctionHeader *header, TierReason reason, Byte *pc)
+{
+    if(!context->Options.Tiering || header->Tier > 0)
+        return pc;
+
+    // a function is promoted once, even if the fusion finds nothing to rewrite
+    header->Tier = 1;
+
+    Function *function = (Function*)header;
+    u32  size    = header->Size;
+    u8  *code    = malloc(size + 1);
+    u32 *offsets = pc ? malloc((size + 1) * sizeof(u32)) : NULL;
+    u32  newSize = 0;
+    u32  fused   = FuseBody(function, code, &newSize, offsets);
+    if(!fused)
+    {
+        free(code);
+        free(offsets);
+        return pc;
+    }
+
+    TierEvent event = { header, code, newSize, header->Calls, header->BackEdges, fused, reason };
+    List_TierEvent_PushBack(&context->TierEvents, &event);
+    header->Code = code;
+    LOG_INFO("Tiering : Function %s promoted to tier 1", header->Signature);
+
+    // on stack replacement, pc is the target of a backward branch and a branch target always starts an instruction 
+    // of the fused body
+    if(pc)
+    {
+        const u8 *body = function->Body;
+        DEVEL_ASSERT(pc >= (Byte*)body && pc < (Byte*)(body + size), "Tiering : pc outside the body of %s\n", header->Signature);
+        pc = (Byte*)(code + offsets[(u8*)pc - body]);
+    }
+    free(offsets);
+    return pc;
+}
@@ -0,0 +1,394 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "jit.h"
+#include "stencils.h"
+#include "rvm.h"
+#include "interpreter/interpreter.h"
+#include "raiu/log.h"
+
+/*
+    Baseline copy-and-patch compiler, every register instruction is compiled by copying its stencil and patching the holes
+    with the operands, the pool constants and addresses are resolved at compile time from the module table of the function.
+    The compiled functions keep the frame layout of the interpreters: the frame pointer is in rbx, the arguments are
+    copied in the locals of the callee, the previous frame pointer and function header are saved in the frame, the
+    return address lives on the native stack. A tail call moves the arguments over the frame of the function and jumps
+    to the callee, which returns with the address of the caller. The native stack is mapped by ExecuteJit as deep as the
+    frame stack, its pointer at entry is in r13, the stack top in r14.
+    Calls to C (system calls and the stack overflow message) go through the trampolines below.
+*/
+
+typedef struct _JumpFix
+{
+    u32 Position; // position of the displacement in the code buffer
+    u32 Target;   // offset of the target in the register body
+} JumpFix;
+typedef struct _CallFix
+{
+    u32 Position;           // position of the displacement in the code buffer
+    const Function *Callee;
+} CallFix;
+
+#define LIST_T JumpFix
+#include "raiu/list.h"
+
+#define LIST_T CallFix
+#include "raiu/list.h"
+
+typedef struct _Compiler
+{
+    u8  *Code;
+    u32  Size;
+    u32  Capacity;
+    u32  Leave;         // position of the leave sequence
+    List_JumpFix Jumps; // jumps of the function being compiled
+    List_CallFix Calls; // calls of all functions, resolved once the code is mapped
+    const Byte  *Functions; // base of the caller headers in the frames
+} Compiler;
+
+// the stack of the host functions called by the compiled code, the system calls and the library calls
+#define JIT_HOST_STACK_SIZE (256 * 1024)
+
+typedef i32 (*JitEntry)(Word *fp, Word *stackTop, void *function, void *nativeStack);
+
+#pragma region Trampolines
+static void iSyscall(Word *sp, u8 syscall)
+{
+    switch (syscall)
+    {
+    case OP_SYS_PRINT:  SYSCALL_PRINT(sp);  break;
+    case OP_SYS_PRINTI: SYSCALL_PRINTI(sp); break;
+    case OP_SYS_PRINTF: SYSCALL_PRINTF(sp); break;
+    case OP_SYS_SCAN:   SYSCALL_SCAN(sp);   break;
+    case OP_SYS_SCANI:  SYSCALL_SCANI(sp);  break;
+    case OP_SYS_SCANF:  SYSCALL_SCANF(sp);  break;
+    case OP_SYS_MEMMOV: SYSCALL_MEMMOV(sp); break;
+    case OP_SYS_MEMCPY: SYSCALL_MEMCPY(sp); break;
+    case OP_SYS_CLOCK:  SYSCALL_CLOCK(sp);  break;
+    case OP_SYS_SQRT32: SYSCALL_MATH_WORD(sp, sqrtf); break;
+    case OP_SYS_SQRT64: SYSCALL_MATH_DWORD(sp, sqrt); break;
+    case OP_SYS_EXP32:  SYSCALL_MATH_WORD(sp, expf);  break;
+    case OP_SYS_EXP64:  SYSCALL_MATH_DWORD(sp, exp);  break;
+    case OP_SYS_LOG32:  SYSCALL_MATH_WORD(sp, logf);  break;
+    case OP_SYS_LOG64:  SYSCALL_MATH_DWORD(sp, log);  break;
+    default: break;
+    }
+}
+static i32 iStackOverflow(const ch8 *signature)
+{
+    printf("Stack overflow in function %s\n", signature);
+    return -1;
+}
+#pragma endregion
+
+static void iEmit(Compiler *c, u8 byte)
+{
+    if(c->Size == c->Capacity)
+    {
+        c->Capacity *= 2;
+        c->Code = realloc(c->Code, c->Capacity);
+    }
+    c->Code[c->Size++] = byte;
+}
+static void iEmit32(Compiler *c, u32 value)
+{
+    for (u32 i = 0; i < 4; i++)
+        iEmit(c, value >> (i * 8));
+}
+static void iEmit64(Compiler *c, u64 value)
+{
+    for (u32 i = 0; i < 8; i++)
+        iEmit(c, value >> (i * 8));
+}
+// copies the stencil and fills its holes with the operands
+static void iPatch(Compiler *c, const u16 *stencil, const i64 *operands)
+{
+    for (const u16 *p = stencil; *p != STENCIL_END; p++)
+    {
+        u8 n = *p & 0xff;
+        switch (*p & 0xff00)
+        {
+        case 0:
+            iEmit(c, *p);
+            break;
+        case HOLE32(0):
+            iEmit32(c, operands[n]);
+            break;
+        case HOLE64(0):
+            iEmit64(c, operands[n]);
+            break;
+        case JUMP32(0):
+            {
+                JumpFix fix = { c->Size, operands[n] };
+                List_JumpFix_PushBack(&c->Jumps, &fix);
+                iEmit32(c, 0);
+            }
+            break;
+        case CODE32(0):
+            iEmit32(c, operands[n] - (i64)(c->Size + 4));
+            break;
+        }
+    }
+}
+static inline u16 iRead16(const u8 *p) { return p[0] | (p[1] << 8); }
+
+// decodes the operands of the register instruction at the given position, returns the size of the instruction
+static u32 iDecode(const Stencil *stencil, const FunctionHeader *header, u32 position, i64 *operands)
+{
+    const ModuleTable *mt = header->MT;
+    const u8 *body = header->RegisterBody;
+    const u8 *p    = body + position + 1;
+    for (u32 i = 0; stencil->Operands[i]; i++)
+    {
+        switch (stencil->Operands[i])
+        {
+        case 's': operands[i] = *p * SIZEOF_WORD; p += 1; break;
+        case 'i': operands[i] = (i8)*p;           p += 1; break;
+        case 'u': operands[i] = *p;               p += 1; break;
+        case 'w': operands[i] = mt->WordPool[*p].UInt;         p += 1; break;
+        case 'W': operands[i] = mt->WordPool[iRead16(p)].UInt; p += 2; break;
+        case 'd': operands[i] = mt->DWordPool[*p].Int;         p += 1; break;
+        case 'D': operands[i] = mt->DWordPool[iRead16(p)].Int; p += 2; break;
+        case 'c': operands[i] = (i64)mt->StringPool[*p];         p += 1; break;
+        case 'C': operands[i] = (i64)mt->StringPool[iRead16(p)]; p += 2; break;
+        case 'g': operands[i] = (i64)mt->GlobalPool[*p];         p += 1; break;
+        case 'G': operands[i] = (i64)mt->GlobalPool[iRead16(p)]; p += 2; break;
+        case 'f': operands[i] = (i64)mt->FunctionPool[iRead16(p)]; p += 2; break;
+        case 'o':
+            {
+                i16 offset = iRead16(p);
+                p += 2;
+                operands[i] = (p - body) + offset;
+            }
+            break;
+        }
+    }
+    return p - (body + position);
+}
+
+static void iCompileCall(Compiler *c, const FunctionHeader *caller, const i64 *operands)
+{
+    const Function *callee = (const Function*)operands[1];
+    const FunctionHeader *header = &callee->Header;
+    // the arguments are the first locals of the callee frame
+    i64 frame       = operands[0];
+    i64 frameHeader = frame + header->LWC * SIZEOF_WORD;
+
+    i64 check[] = { frameHeader + (FRAME_HEADER_SIZE + header->SWC) * SIZEOF_WORD, (i64)header->Signature,
+                    (i64)iStackOverflow, c->Leave };
+    iPatch(c, StencilCheckStack, check);
+    i64 push[] = { frameHeader + FP_OFFSET * SIZEOF_WORD, frameHeader + FH_OFFSET * SIZEOF_WORD,
+                   ((const Byte*)caller - c->Functions) / SIZEOF_DWORD, frame, frame / SIZEOF_WORD };
+    iPatch(c, StencilPushFrame, push);
+
+    iEmit(c, 0xE8); // call callee
+    CallFix fix = { c->Size, callee };
+    List_CallFix_PushBack(&c->Calls, &fix);
+    iEmit32(c, 0);
+}
+// the callee reuses the frame of the function and returns to its caller, a tail recursion grows neither the frame
+// stack nor the native one
+static void iCompileTailCall(Compiler *c, const FunctionHeader *caller, const i64 *operands)
+{
+    const Function *callee = (const Function*)operands[1];
+    const FunctionHeader *header = &callee->Header;
+    i64 frameHeader = header->LWC * SIZEOF_WORD;
+
+    i64 check[] = { frameHeader + (FRAME_HEADER_SIZE + header->SWC) * SIZEOF_WORD, (i64)header->Signature,
+                    (i64)iStackOverflow, c->Leave };
+    iPatch(c, StencilCheckStack, check);
+    // the arguments are above the header of the function and move down, so they are copied in order
+    i64 link[] = { (caller->LWC + FP_OFFSET) * SIZEOF_WORD };
+    iPatch(c, StencilLoadLink, link);
+    for (u16 i = 0; i < header->AWC; i++)
+    {
+        i64 copy[] = { i * SIZEOF_WORD, operands[0] + i * SIZEOF_WORD };
+        iPatch(c, StencilCopyWord, copy);
+    }
+    i64 newLink[] = { frameHeader + FP_OFFSET * SIZEOF_WORD };
+    iPatch(c, StencilStoreLink, newLink);
+    iPatch(c, StencilTailJump, NULL);
+
+    iEmit(c, 0xE9); // jmp callee
+    CallFix fix = { c->Size, callee };
+    List_CallFix_PushBack(&c->Calls, &fix);
+    iEmit32(c, 0);
+}
+static void iCompileSyscall(Compiler *c, const i64 *operands)
+{
+    if(operands[1] == OP_SYS_EXIT)
+    {
+        i64 exit[] = { operands[0] - SIZEOF_WORD, c->Leave };
+        iPatch(c, StencilExit, exit);
+    }
+    else
+    {
+        i64 syscall[] = { operands[0], operands[1], (i64)iSyscall };
+        iPatch(c, StencilSyscall, syscall);
+    }
+}
+// the math and memory functions are called directly, the native stack is aligned by the prologue
+static void iCompileLibraryCall(Compiler *c, u8 opcode, const i64 *operands)
+{
+    switch (opcode)
+    {
+    case OP_EXP_F32: iPatch(c, StencilCallF32, (i64[]) { operands[0], operands[1], (i64)expf }); break;
+    case OP_EXP_F64: iPatch(c, StencilCallF64, (i64[]) { operands[0], operands[1], (i64)exp });  break;
+    case OP_LOG_F32: iPatch(c, StencilCallF32, (i64[]) { operands[0], operands[1], (i64)logf }); break;
+    case OP_LOG_F64: iPatch(c, StencilCallF64, (i64[]) { operands[0], operands[1], (i64)log });  break;
+    case OP_MEMMOV:  iPatch(c, StencilCallMemory, (i64[]) { operands[0], operands[1], operands[2], (i64)memmove }); break;
+    case OP_MEMCPY:  iPatch(c, StencilCallMemory, (i64[]) { operands[0], operands[1], operands[2], (i64)memcpy });  break;
+    }
+}
+static void iCompileReturn(Compiler *c, const FunctionHeader *header, const i64 *operands)
+{
+    // the results take the place of the arguments in the caller frame
+    for (u16 i = 0; i < header->RWC; i++)
+    {
+        i64 copy[] = { i * SIZEOF_WORD, operands[0] + i * SIZEOF_WORD };
+        iPatch(c, StencilCopyWord, copy);
+    }
+    i64 ret[] = { (header->LWC + FP_OFFSET) * SIZEOF_WORD };
+    iPatch(c, StencilReturn, ret);
+}
+
+static bool iCompileFunction(Compiler *c, const Function *function)
+{
+    const FunctionHeader *header = &function->Header;
+    const u8 *body = header->RegisterBody;
+    u32 size = header->RegisterSize;
+    u32 *nativeAt = malloc((size + 1) * sizeof(u32));
+    bool compiled = true;
+    c->Jumps.Count = 0;
+
+    iPatch(c, StencilPrologue, NULL);
+    for (u32 position = 0; position < size;)
+    {
+        u8 opcode = body[position];
+        const Stencil *stencil = &Stencils[opcode];
+        nativeAt[position] = c->Size;
+        if(stencil->Operands == NULL)
+        {
+            compiled = false;
+            break;
+        }
+
+        i64 operands[4];
+        position += iDecode(stencil, header, position, operands);
+        if(stencil->Code)
+            iPatch(c, stencil->Code, operands);
+        else if(opcode == OP_CALL)
+            iCompileCall(c, header, operands);
+        else if(opcode == OP_TAILCALL)
+            iCompileTailCall(c, header, operands);
+        else if(opcode == OP_SYSCALL)
+            iCompileSyscall(c, operands);
+        else if(opcode >= OP_EXP_F32 && opcode <= OP_MEMCPY)
+            iCompileLibraryCall(c, opcode, operands);
+        else
+            iCompileReturn(c, header, operands);
+    }
+
+    for (u32 i = 0; compiled && i < c->Jumps.Count; i++)
+    {
+        const JumpFix *fix = List_JumpFix_AtRO(&c->Jumps, i);
+        *(i32*)(c->Code + fix->Position) = nativeAt[fix->Target] - (fix->Position + 4);
+    }
+    free(nativeAt);
+    return compiled;
+}
+
+bool JitCompile(ProgramContext *context, Function **functions, u32 count)
+{
+#if defined(__x86_64__) && defined(__linux__)
+    Compiler c;
+    c.Capacity = 4096;
+    c.Size     = 0;
+    c.Code     = malloc(c.Capacity);
+    c.Functions = context->FunctionsBuffer;
+    List_JumpFix_Create(&c.Jumps);
+    List_CallFix_Create(&c.Calls);
+
+    iPatch(&c, StencilEnter, NULL);
+    c.Leave = c.Size;
+    iPatch(&c, StencilLeave, NULL);
+
+    u32 *offsets = malloc(count * sizeof(u32));
+    bool compiled = true;
+    for (u32 i = 0; i < count && compiled; i++)
+    {
+        offsets[i] = c.Size;
+        compiled = iCompileFunction(&c, functions[i]);
+        if(!compiled)
+            printf("Function %s cannot be compiled to machine code\n", functions[i]->Header.Signature);
+    }
+
+    if(compiled)
+    {
+        u8 *code = mmap(NULL, c.Size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if(code == MAP_FAILED)
+        {
+            printf("Cannot map %u bytes of machine code\n", c.Size);
+            compiled = false;
+        }
+        else
+        {
+            memcpy(code, c.Code, c.Size);
+            for (u32 i = 0; i < count; i++)
+                functions[i]->Header.NativeBody = code + offsets[i];
+            for (u32 i = 0; i < c.Calls.Count; i++)
+            {
+                const CallFix *fix = List_CallFix_AtRO(&c.Calls, i);
+                *(i32*)(code + fix->Position) = (u8*)fix->Callee->Header.NativeBody - (code + fix->Position + 4);
+            }
+            mprotect(code, c.Size, PROT_READ | PROT_EXEC);
+            context->JitCodeBuffer     = code;
+            context->JitCodeBufferSize = c.Size;
+            LOG_INFO("Jit : %u functions compiled into %u bytes of machine code", count, c.Size);
+        }
+    }
+
+    free(offsets);
+    free(c.Code);
+    List_JumpFix_Destroy(&c.Jumps);
+    List_CallFix_Destroy(&c.Calls);
+    return compiled;
+#else
+    (void)context; (void)functions; (void)count;
+    printf("The compiler to machine code supports only x86-64 Linux\n");
+    return false;
+#endif
+}
+
+void JitRelease(ProgramContext *context)
+{
+    if(context->JitCodeBuffer)
+        munmap(context->JitCodeBuffer, context->JitCodeBufferSize);
+}
+
+i32 ExecuteJit(ProgramContext *context)
+{
+    JitEntry enter = (JitEntry)(void*)context->JitCodeBuffer;
+    // a compiled call pushes 16 bytes on the native stack, the return address and the padding of the prologue, and its
+    // frame is at least as big as a frame header, so a native stack as big as the frame stack holds all the calls up to
+    // the limit of the options. The compiled code runs on a stack mapped here with that size and the room for the host
+    // functions it calls, after a guard page
+    sz page   = (sz)sysconf(_SC_PAGESIZE);
+    sz frames = (sz)((u8*)context->StackLimit - (u8*)context->StackBottom);
+    sz size   = (frames + JIT_HOST_STACK_SIZE + page - 1) / page * page + page;
+    u8 *native = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE | MAP_STACK, -1, 0);
+    if(native == MAP_FAILED || mprotect(native, page, PROT_NONE))
+    {
+        printf("Cannot map the native stack of the compiled code [size=%zu]\n", size);
+        if(native != MAP_FAILED)
+            munmap(native, size);
+        return -1;
+    }
+    i32 ret = enter(context->StackBottom, context->StackLimit, context->EntryPoint->Header.NativeBody, native + size);
+    munmap(native, size);
+    return ret;
+}
@@ -0,0 +1,20 @@
+#pragma once
+
+#include "raiu/raiu.h"
+#include "metadata.h"
+
+/**
+ * @brief Compiles the register form of the functions to x86-64 machine code in the jit code buffer of the context
+ * and sets the native body of every function.
+ *
+ * @param context The context of the program, the functions must have been translated to the register form
+ * @param functions The functions to compile
+ * @param count The amount of functions
+ * @return true if every function has been compiled, false if an instruction is not supported and nothing has been compiled
+ */
+bool JitCompile(ProgramContext *context, Function **functions, u32 count);
+
+/**
+ * @brief Releases the executable memory of the compiled code.
+ */
+void JitRelease(ProgramContext *context);
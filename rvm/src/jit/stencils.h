@@ -0,0 +1,376 @@
+#pragma once
+
+#include "raiu/raiu.h"
+
+/*
+    A stencil is the x86-64 machine code of one register instruction with holes in place of its operands, the compiler
+    copies the bytes and patches the holes with the decoded operands.
+    The code of a stencil is an array of u16, values below 256 are bytes of machine code, the others are holes:
+    HOLE32(n)     32 bit value of operand n (a slot becomes the byte displacement from the frame pointer)
+    HOLE64(n)     64 bit value of operand n
+    JUMP32(n)     32 bit displacement to the register instruction at the offset in operand n
+    CODE32(n)     32 bit displacement to the position in the code buffer in operand n
+
+    Every stencil works on the frame pointer in rbx, rax rcx rdx xmm0 and xmm1 are scratch registers.
+
+    The operands of a register instruction are described by a string with a character for each operand:
+    s   slot (u8), patched as byte displacement
+    i   immediate (i8)
+    u   immediate (u8)
+    w W word pool index (u8, u16), patched as the constant value
+    d D dword pool index (u8, u16), patched as the constant value
+    c C string pool index (u8, u16), patched as the string address
+    g G global pool index (u8, u16), patched as the global address
+    f   function pool index (u16), patched as the function address
+    o   jump offset (i16), patched as displacement
+*/
+
+#define HOLE32(n)   (0x100 | (n))
+#define HOLE64(n)   (0x200 | (n))
+#define JUMP32(n)   (0x300 | (n))
+#define CODE32(n)   (0x400 | (n))
+#define STENCIL_END 0xFFFF
+
+typedef struct _Stencil
+{
+    const ch8 *Operands;
+    const u16 *Code; // NULL if the compiler emits the instruction by itself
+} Stencil;
+
+#define STENCIL(operands, ...) { operands, (const u16[]) { __VA_ARGS__, STENCIL_END } }
+
+#pragma region Pieces
+#define MOV_EAX_SLOT(n)    0x8B, 0x83, HOLE32(n)              // mov eax, [rbx + n]
+#define MOV_RAX_SLOT(n)    0x48, 0x8B, 0x83, HOLE32(n)        // mov rax, [rbx + n]
+#define MOV_ECX_SLOT(n)    0x8B, 0x8B, HOLE32(n)              // mov ecx, [rbx + n]
+#define MOV_RCX_SLOT(n)    0x48, 0x8B, 0x8B, HOLE32(n)        // mov rcx, [rbx + n]
+#define MOV_SLOT_EAX(n)    0x89, 0x83, HOLE32(n)              // mov [rbx + n], eax
+#define MOV_SLOT_RAX(n)    0x48, 0x89, 0x83, HOLE32(n)        // mov [rbx + n], rax
+#define MOV_SLOT_ECX(n)    0x89, 0x8B, HOLE32(n)              // mov [rbx + n], ecx
+#define MOV_SLOT_RCX(n)    0x48, 0x89, 0x8B, HOLE32(n)        // mov [rbx + n], rcx
+#define MOV_SLOT_EDX(n)    0x89, 0x93, HOLE32(n)              // mov [rbx + n], edx
+#define MOV_SLOT_RDX(n)    0x48, 0x89, 0x93, HOLE32(n)        // mov [rbx + n], rdx
+#define MOVSS_XMM0_SLOT(n) 0xF3, 0x0F, 0x10, 0x83, HOLE32(n)  // movss xmm0, [rbx + n]
+#define MOVSD_XMM0_SLOT(n) 0xF2, 0x0F, 0x10, 0x83, HOLE32(n)  // movsd xmm0, [rbx + n]
+#define MOVSS_SLOT_XMM0(n) 0xF3, 0x0F, 0x11, 0x83, HOLE32(n)  // movss [rbx + n], xmm0
+#define MOVSD_SLOT_XMM0(n) 0xF2, 0x0F, 0x11, 0x83, HOLE32(n)  // movsd [rbx + n], xmm0
+#define XOR_ECX_ECX        0x31, 0xC9                         // xor ecx, ecx
+#define XOR_EDX_EDX        0x31, 0xD2                         // xor edx, edx
+#pragma endregion
+
+#pragma region Instructions
+// d = a op b, the op is an ALU instruction with a memory source operand
+#define ALU_WORD(op)  MOV_EAX_SLOT(1), op, 0x83, HOLE32(2), MOV_SLOT_EAX(0)
+#define ALU_DWORD(op) MOV_RAX_SLOT(1), 0x48, op, 0x83, HOLE32(2), MOV_SLOT_RAX(0)
+#define MUL_WORD      MOV_EAX_SLOT(1), 0x0F, 0xAF, 0x83, HOLE32(2), MOV_SLOT_EAX(0)
+#define MUL_DWORD     MOV_RAX_SLOT(1), 0x48, 0x0F, 0xAF, 0x83, HOLE32(2), MOV_SLOT_RAX(0)
+// signed division extends the sign in edx with cdq, unsigned clears edx, the quotient is in eax the remainder in edx
+#define IDIV_WORD(store)  MOV_EAX_SLOT(1), 0x99, 0xF7, 0xBB, HOLE32(2), store(0)
+#define IDIV_DWORD(store) MOV_RAX_SLOT(1), 0x48, 0x99, 0x48, 0xF7, 0xBB, HOLE32(2), store(0)
+#define DIV_WORD(store)   MOV_EAX_SLOT(1), XOR_EDX_EDX, 0xF7, 0xB3, HOLE32(2), store(0)
+#define DIV_DWORD(store)  MOV_RAX_SLOT(1), XOR_EDX_EDX, 0x48, 0xF7, 0xB3, HOLE32(2), store(0)
+#define SHIFT_WORD(ext)   MOV_EAX_SLOT(1), MOV_ECX_SLOT(2), 0xD3, ext, MOV_SLOT_EAX(0)
+#define SHIFT_DWORD(ext)  MOV_RAX_SLOT(1), MOV_RCX_SLOT(2), 0x48, 0xD3, ext, MOV_SLOT_RAX(0)
+#define UNARY_WORD(ext)   MOV_EAX_SLOT(1), 0xF7, ext, MOV_SLOT_EAX(0)
+#define UNARY_DWORD(ext)  MOV_RAX_SLOT(1), 0x48, 0xF7, ext, MOV_SLOT_RAX(0)
+#define SSE_F32(op)       MOVSS_XMM0_SLOT(1), 0xF3, 0x0F, op, 0x83, HOLE32(2), MOVSS_SLOT_XMM0(0)
+#define SSE_F64(op)       MOVSD_XMM0_SLOT(1), 0xF2, 0x0F, op, 0x83, HOLE32(2), MOVSD_SLOT_XMM0(0)
+// s = s op v, the floating point variants convert v to the type of the slot
+#define SLOT_WORD(ext)    0x81, ext, HOLE32(0), HOLE32(1)
+#define SLOT_DWORD(ext)   0x48, 0x81, ext, HOLE32(0), HOLE32(1)
+#define SLOT_F32(op)      0xB8, HOLE32(1), 0xF3, 0x0F, 0x2A, 0xC8, MOVSS_XMM0_SLOT(0), 0xF3, 0x0F, op, 0xC1, MOVSS_SLOT_XMM0(0)
+#define SLOT_F64(op)      0xB8, HOLE32(1), 0xF2, 0x0F, 0x2A, 0xC8, MOVSD_XMM0_SLOT(0), 0xF2, 0x0F, op, 0xC1, MOVSD_SLOT_XMM0(0)
+// the compares write 1 or 0 with the type of the operands like the interpreters do
+#define CMP_WORD(cc)      XOR_ECX_ECX, MOV_EAX_SLOT(1), 0x3B, 0x83, HOLE32(2), 0x0F, cc, 0xC1, MOV_SLOT_ECX(0)
+#define CMP_DWORD(cc)     XOR_ECX_ECX, MOV_RAX_SLOT(1), 0x48, 0x3B, 0x83, HOLE32(2), 0x0F, cc, 0xC1, MOV_SLOT_RCX(0)
+#define CMP_F32(cc, a, b) XOR_ECX_ECX, MOVSS_XMM0_SLOT(a), 0x0F, 0x2E, 0x83, HOLE32(b), 0x0F, cc, 0xC1, \
+                          0xF3, 0x0F, 0x2A, 0xC1, MOVSS_SLOT_XMM0(0)
+#define CMP_F64(cc, a, b) XOR_ECX_ECX, MOVSD_XMM0_SLOT(a), 0x66, 0x0F, 0x2E, 0x83, HOLE32(b), 0x0F, cc, 0xC1, \
+                          0xF2, 0x0F, 0x2A, 0xC1, MOVSD_SLOT_XMM0(0)
+#define CMP_JUMP(cc)      MOV_EAX_SLOT(0), 0x3B, 0x83, HOLE32(1), 0x0F, cc, JUMP32(2)
+// the load of a cast takes the source in eax, rax or xmm0
+#define CAST(store, ...) __VA_ARGS__, 0x83, HOLE32(1), store(0)
+#pragma endregion
+
+// setcc and jcc condition codes
+#define CC_E  0x4
+#define CC_NE 0x5
+#define CC_B  0x2
+#define CC_AE 0x3
+#define CC_BE 0x6
+#define CC_A  0x7
+#define CC_L  0xC
+#define CC_GE 0xD
+#define CC_LE 0xE
+#define CC_G  0xF
+#define SETCC(cc) (0x90 | (cc))
+#define JCC(cc)   (0x80 | (cc))
+
+static const Stencil Stencils[256] =
+{
+    [OP_PUSH_0_WORD]  = STENCIL("s", 0xC7, 0x83, HOLE32(0), 0x00, 0x00, 0x00, 0x00),
+    [OP_PUSH_I32_1]   = STENCIL("s", 0xC7, 0x83, HOLE32(0), 0x01, 0x00, 0x00, 0x00),
+    [OP_PUSH_I32_2]   = STENCIL("s", 0xC7, 0x83, HOLE32(0), 0x02, 0x00, 0x00, 0x00),
+    [OP_PUSH_F32_1]   = STENCIL("s", 0xC7, 0x83, HOLE32(0), 0x00, 0x00, 0x80, 0x3F),
+    [OP_PUSH_F32_2]   = STENCIL("s", 0xC7, 0x83, HOLE32(0), 0x00, 0x00, 0x00, 0x40),
+    [OP_PUSH_0_DWORD] = STENCIL("s", 0x48, 0xC7, 0x83, HOLE32(0), 0x00, 0x00, 0x00, 0x00),
+    [OP_PUSH_I64_1]   = STENCIL("s", 0x48, 0xC7, 0x83, HOLE32(0), 0x01, 0x00, 0x00, 0x00),
+    [OP_PUSH_I64_2]   = STENCIL("s", 0x48, 0xC7, 0x83, HOLE32(0), 0x02, 0x00, 0x00, 0x00),
+    [OP_PUSH_F64_1]   = STENCIL("s", 0x48, 0xB8, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xF0, 0x3F, MOV_SLOT_RAX(0)),
+    [OP_PUSH_F64_2]   = STENCIL("s", 0x48, 0xB8, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x40, MOV_SLOT_RAX(0)),
+    [OP_PUSH_I32]     = STENCIL("si", 0xC7, 0x83, HOLE32(0), HOLE32(1)),
+    [OP_PUSH_I64]     = STENCIL("si", 0x48, 0xC7, 0x83, HOLE32(0), HOLE32(1)),
+    [OP_PUSH_CONST_WORD]    = STENCIL("sw", 0xC7, 0x83, HOLE32(0), HOLE32(1)),
+    [OP_PUSH_CONST_WORD_W]  = STENCIL("sW", 0xC7, 0x83, HOLE32(0), HOLE32(1)),
+    [OP_PUSH_CONST_DWORD]   = STENCIL("sd", 0x48, 0xB8, HOLE64(1), MOV_SLOT_RAX(0)),
+    [OP_PUSH_CONST_DWORD_W] = STENCIL("sD", 0x48, 0xB8, HOLE64(1), MOV_SLOT_RAX(0)),
+    [OP_PUSH_CONST_STR]     = STENCIL("sc", 0x48, 0xB8, HOLE64(1), MOV_SLOT_RAX(0)),
+    [OP_PUSH_CONST_STR_W]   = STENCIL("sC", 0x48, 0xB8, HOLE64(1), MOV_SLOT_RAX(0)),
+    [OP_PUSH_GLOB_REF]      = STENCIL("sg", 0x48, 0xB8, HOLE64(1), MOV_SLOT_RAX(0)),
+    [OP_PUSH_GLOB_REF_W]    = STENCIL("sG", 0x48, 0xB8, HOLE64(1), MOV_SLOT_RAX(0)),
+    [OP_PUSH_FUNC]          = STENCIL("sf", 0x48, 0xB8, HOLE64(1), MOV_SLOT_RAX(0)),
+    [OP_LOAD_GLOB_WORD]     = STENCIL("sg", 0x48, 0xB8, HOLE64(1), 0x8B, 0x00, MOV_SLOT_EAX(0)),
+    [OP_LOAD_GLOB_DWORD]    = STENCIL("sg", 0x48, 0xB8, HOLE64(1), 0x48, 0x8B, 0x00, MOV_SLOT_RAX(0)),
+
+    [OP_POP_WORD]  = STENCIL("ss", MOV_EAX_SLOT(1), MOV_SLOT_EAX(0)),
+    [OP_POP_DWORD] = STENCIL("ss", MOV_RAX_SLOT(1), MOV_SLOT_RAX(0)),
+
+    [OP_ADD_I32] = STENCIL("sss", ALU_WORD(0x03)),
+    [OP_ADD_I64] = STENCIL("sss", ALU_DWORD(0x03)),
+    [OP_ADD_F32] = STENCIL("sss", SSE_F32(0x58)),
+    [OP_ADD_F64] = STENCIL("sss", SSE_F64(0x58)),
+    [OP_INC_I32] = STENCIL("su", SLOT_WORD(0x83)),
+    [OP_INC_I64] = STENCIL("su", SLOT_DWORD(0x83)),
+    [OP_INC_F32] = STENCIL("su", SLOT_F32(0x58)),
+    [OP_INC_F64] = STENCIL("su", SLOT_F64(0x58)),
+    [OP_SUB_I32] = STENCIL("sss", ALU_WORD(0x2B)),
+    [OP_SUB_I64] = STENCIL("sss", ALU_DWORD(0x2B)),
+    [OP_SUB_F32] = STENCIL("sss", SSE_F32(0x5C)),
+    [OP_SUB_F64] = STENCIL("sss", SSE_F64(0x5C)),
+    [OP_DEC_I32] = STENCIL("su", SLOT_WORD(0xAB)),
+    [OP_DEC_I64] = STENCIL("su", SLOT_DWORD(0xAB)),
+    [OP_DEC_F32] = STENCIL("su", SLOT_F32(0x5C)),
+    [OP_DEC_F64] = STENCIL("su", SLOT_F64(0x5C)),
+    [OP_MUL_I32] = STENCIL("sss", MUL_WORD),
+    [OP_MUL_I64] = STENCIL("sss", MUL_DWORD),
+    [OP_MUL_U32] = STENCIL("sss", MUL_WORD),
+    [OP_MUL_U64] = STENCIL("sss", MUL_DWORD),
+    [OP_MUL_F32] = STENCIL("sss", SSE_F32(0x59)),
+    [OP_MUL_F64] = STENCIL("sss", SSE_F64(0x59)),
+    [OP_DIV_I32] = STENCIL("sss", IDIV_WORD(MOV_SLOT_EAX)),
+    [OP_DIV_I64] = STENCIL("sss", IDIV_DWORD(MOV_SLOT_RAX)),
+    [OP_DIV_U32] = STENCIL("sss", DIV_WORD(MOV_SLOT_EAX)),
+    [OP_DIV_U64] = STENCIL("sss", DIV_DWORD(MOV_SLOT_RAX)),
+    [OP_DIV_F32] = STENCIL("sss", SSE_F32(0x5E)),
+    [OP_DIV_F64] = STENCIL("sss", SSE_F64(0x5E)),
+    [OP_REM_I32] = STENCIL("sss", IDIV_WORD(MOV_SLOT_EDX)),
+    [OP_REM_I64] = STENCIL("sss", IDIV_DWORD(MOV_SLOT_RDX)),
+    [OP_REM_U32] = STENCIL("sss", DIV_WORD(MOV_SLOT_EDX)),
+    [OP_REM_U64] = STENCIL("sss", DIV_DWORD(MOV_SLOT_RDX)),
+    [OP_NEG_I32] = STENCIL("ss", UNARY_WORD(0xD8)),
+    [OP_NEG_I64] = STENCIL("ss", UNARY_DWORD(0xD8)),
+    [OP_NEG_F32] = STENCIL("ss", MOV_EAX_SLOT(1), 0x35, 0x00, 0x00, 0x00, 0x80, MOV_SLOT_EAX(0)),
+    [OP_NEG_F64] = STENCIL("ss", MOV_RAX_SLOT(1), 0x48, 0x0F, 0xBA, 0xF8, 0x3F, MOV_SLOT_RAX(0)),
+    [OP_SQRT_F32] = STENCIL("ss", 0xF3, 0x0F, 0x51, 0x83, HOLE32(1), MOVSS_SLOT_XMM0(0)), // sqrtss xmm0, [rbx + a]
+    [OP_SQRT_F64] = STENCIL("ss", 0xF2, 0x0F, 0x51, 0x83, HOLE32(1), MOVSD_SLOT_XMM0(0)), // sqrtsd xmm0, [rbx + a]
+    [OP_EXP_F32 ... OP_LOG_F64] = { "ss", NULL },
+
+    [OP_NOT_WORD]  = STENCIL("ss", UNARY_WORD(0xD0)),
+    [OP_NOT_DWORD] = STENCIL("ss", UNARY_DWORD(0xD0)),
+    [OP_AND_WORD]  = STENCIL("sss", ALU_WORD(0x23)),
+    [OP_AND_DWORD] = STENCIL("sss", ALU_DWORD(0x23)),
+    [OP_OR_WORD]   = STENCIL("sss", ALU_WORD(0x0B)),
+    [OP_OR_DWORD]  = STENCIL("sss", ALU_DWORD(0x0B)),
+    [OP_XOR_WORD]  = STENCIL("sss", ALU_WORD(0x33)),
+    [OP_XOR_DWORD] = STENCIL("sss", ALU_DWORD(0x33)),
+    [OP_SHL_WORD]  = STENCIL("sss", SHIFT_WORD(0xE0)),
+    [OP_SHL_DWORD] = STENCIL("sss", SHIFT_DWORD(0xE0)),
+    [OP_SHR_I32]   = STENCIL("sss", SHIFT_WORD(0xF8)),
+    [OP_SHR_I64]   = STENCIL("sss", SHIFT_DWORD(0xF8)),
+    [OP_SHR_U32]   = STENCIL("sss", SHIFT_WORD(0xE8)),
+    [OP_SHR_U64]   = STENCIL("sss", SHIFT_DWORD(0xE8)),
+
+    [OP_I32_TO_I8]  = STENCIL("ss", CAST(MOV_SLOT_EAX, 0x0F, 0xBE)),
+    [OP_I32_TO_I16] = STENCIL("ss", CAST(MOV_SLOT_EAX, 0x0F, 0xBF)),
+    [OP_I32_TO_I64] = STENCIL("ss", CAST(MOV_SLOT_RAX, 0x48, 0x63)),
+    [OP_I32_TO_F32] = STENCIL("ss", CAST(MOVSS_SLOT_XMM0, 0xF3, 0x0F, 0x2A)),
+    [OP_I32_TO_F64] = STENCIL("ss", CAST(MOVSD_SLOT_XMM0, 0xF2, 0x0F, 0x2A)),
+    [OP_I64_TO_I32] = STENCIL("ss", MOV_EAX_SLOT(1), MOV_SLOT_EAX(0)),
+    [OP_I64_TO_F32] = STENCIL("ss", CAST(MOVSS_SLOT_XMM0, 0xF3, 0x48, 0x0F, 0x2A)),
+    [OP_I64_TO_F64] = STENCIL("ss", CAST(MOVSD_SLOT_XMM0, 0xF2, 0x48, 0x0F, 0x2A)),
+    [OP_F32_TO_I32] = STENCIL("ss", CAST(MOV_SLOT_EAX, 0xF3, 0x0F, 0x2C)),
+    [OP_F32_TO_I64] = STENCIL("ss", CAST(MOV_SLOT_RAX, 0xF3, 0x48, 0x0F, 0x2C)),
+    [OP_F32_TO_F64] = STENCIL("ss", CAST(MOVSD_SLOT_XMM0, 0xF3, 0x0F, 0x5A)),
+    [OP_F64_TO_I32] = STENCIL("ss", CAST(MOV_SLOT_EAX, 0xF2, 0x0F, 0x2C)),
+    [OP_F64_TO_I64] = STENCIL("ss", CAST(MOV_SLOT_RAX, 0xF2, 0x48, 0x0F, 0x2C)),
+    [OP_F64_TO_F32] = STENCIL("ss", CAST(MOVSS_SLOT_XMM0, 0xF2, 0x0F, 0x5A)),
+
+    [OP_CMP_WORD_EQ]  = STENCIL("sss", CMP_WORD(SETCC(CC_E))),
+    [OP_CMP_DWORD_EQ] = STENCIL("sss", CMP_DWORD(SETCC(CC_E))),
+    [OP_CMP_WORD_NE]  = STENCIL("sss", CMP_WORD(SETCC(CC_NE))),
+    [OP_CMP_DWORD_NE] = STENCIL("sss", CMP_DWORD(SETCC(CC_NE))),
+    [OP_CMP_I32_GT]   = STENCIL("sss", CMP_WORD(SETCC(CC_G))),
+    [OP_CMP_I64_GT]   = STENCIL("sss", CMP_DWORD(SETCC(CC_G))),
+    [OP_CMP_U32_GT]   = STENCIL("sss", CMP_WORD(SETCC(CC_A))),
+    [OP_CMP_U64_GT]   = STENCIL("sss", CMP_DWORD(SETCC(CC_A))),
+    [OP_CMP_F32_GT]   = STENCIL("sss", CMP_F32(SETCC(CC_A), 1, 2)),
+    [OP_CMP_F64_GT]   = STENCIL("sss", CMP_F64(SETCC(CC_A), 1, 2)),
+    [OP_CMP_I32_LT]   = STENCIL("sss", CMP_WORD(SETCC(CC_L))),
+    [OP_CMP_I64_LT]   = STENCIL("sss", CMP_DWORD(SETCC(CC_L))),
+    [OP_CMP_U32_LT]   = STENCIL("sss", CMP_WORD(SETCC(CC_B))),
+    [OP_CMP_U64_LT]   = STENCIL("sss", CMP_DWORD(SETCC(CC_B))),
+    [OP_CMP_F32_LT]   = STENCIL("sss", CMP_F32(SETCC(CC_A), 2, 1)),
+    [OP_CMP_F64_LT]   = STENCIL("sss", CMP_F64(SETCC(CC_A), 2, 1)),
+    [OP_CMP_I32_GE]   = STENCIL("sss", CMP_WORD(SETCC(CC_GE))),
+    [OP_CMP_I64_GE]   = STENCIL("sss", CMP_DWORD(SETCC(CC_GE))),
+    [OP_CMP_U32_GE]   = STENCIL("sss", CMP_WORD(SETCC(CC_AE))),
+    [OP_CMP_U64_GE]   = STENCIL("sss", CMP_DWORD(SETCC(CC_AE))),
+    [OP_CMP_F32_GE]   = STENCIL("sss", CMP_F32(SETCC(CC_AE), 1, 2)),
+    [OP_CMP_F64_GE]   = STENCIL("sss", CMP_F64(SETCC(CC_AE), 1, 2)),
+    [OP_CMP_I32_LE]   = STENCIL("sss", CMP_WORD(SETCC(CC_LE))),
+    [OP_CMP_I64_LE]   = STENCIL("sss", CMP_DWORD(SETCC(CC_LE))),
+    [OP_CMP_U32_LE]   = STENCIL("sss", CMP_WORD(SETCC(CC_BE))),
+    [OP_CMP_U64_LE]   = STENCIL("sss", CMP_DWORD(SETCC(CC_BE))),
+    [OP_CMP_F32_LE]   = STENCIL("sss", CMP_F32(SETCC(CC_AE), 2, 1)),
+    [OP_CMP_F64_LE]   = STENCIL("sss", CMP_F64(SETCC(CC_AE), 2, 1)),
+    [OP_CMP_NOT]      = STENCIL("ss", XOR_ECX_ECX, MOV_EAX_SLOT(1), 0x85, 0xC0, 0x0F, SETCC(CC_E), 0xC1, MOV_SLOT_ECX(0)),
+
+    [OP_LOAD_WORD]         = STENCIL("ss", MOV_RAX_SLOT(1), 0x8B, 0x00, MOV_SLOT_EAX(0)),
+    [OP_LOAD_DWORD]        = STENCIL("ss", MOV_RAX_SLOT(1), 0x48, 0x8B, 0x00, MOV_SLOT_RAX(0)),
+    [OP_STORE_WORD]        = STENCIL("ss", MOV_RAX_SLOT(0), MOV_ECX_SLOT(1), 0x89, 0x08),
+    [OP_STORE_DWORD]       = STENCIL("ss", MOV_RAX_SLOT(0), MOV_RCX_SLOT(1), 0x48, 0x89, 0x08),
+    [OP_LOAD_OFST_WORD]    = STENCIL("sss", MOV_RAX_SLOT(1), 0x8B, 0x80, HOLE32(2), MOV_SLOT_EAX(0)),
+    [OP_LOAD_OFST_DWORD]   = STENCIL("sss", MOV_RAX_SLOT(1), 0x48, 0x8B, 0x80, HOLE32(2), MOV_SLOT_RAX(0)),
+    [OP_STORE_OFST_WORD]   = STENCIL("sss", MOV_RAX_SLOT(0), MOV_ECX_SLOT(1), 0x89, 0x88, HOLE32(2)),
+    [OP_STORE_OFST_DWORD]  = STENCIL("sss", MOV_RAX_SLOT(0), MOV_RCX_SLOT(1), 0x48, 0x89, 0x88, HOLE32(2)),
+
+    [OP_JMP]     = STENCIL("o", 0xE9, JUMP32(0)),
+    [OP_JMP_IF]  = STENCIL("so", MOV_EAX_SLOT(0), 0x85, 0xC0, 0x0F, JCC(CC_NE), JUMP32(1)),
+    [OP_CALL]    = { "sf", NULL },
+    [OP_TAILCALL] = { "sf", NULL },
+    [OP_SYSCALL] = { "su", NULL },
+    [OP_RET]     = { "s", NULL },
+    [OP_MEMMOV]  = { "sss", NULL },
+    [OP_MEMCPY]  = { "sss", NULL },
+
+    [OP_ADD_I32_LOC_IMM] = STENCIL("sis", MOV_EAX_SLOT(0), 0x05, HOLE32(1), MOV_SLOT_EAX(2)),
+    [OP_ADD_I32_LOC_LOC] = STENCIL("sss", MOV_EAX_SLOT(0), 0x03, 0x83, HOLE32(1), MOV_SLOT_EAX(2)),
+    [OP_JMP_WORD_EQ]     = STENCIL("sso", CMP_JUMP(JCC(CC_E))),
+    [OP_JMP_WORD_NE]     = STENCIL("sso", CMP_JUMP(JCC(CC_NE))),
+    [OP_JMP_I32_GT]      = STENCIL("sso", CMP_JUMP(JCC(CC_G))),
+    [OP_JMP_I32_LT]      = STENCIL("sso", CMP_JUMP(JCC(CC_L))),
+    [OP_JMP_I32_GE]      = STENCIL("sso", CMP_JUMP(JCC(CC_GE))),
+    [OP_JMP_I32_LE]      = STENCIL("sso", CMP_JUMP(JCC(CC_LE))),
+};
+
+#pragma region Sequences
+// entry of the compiled code called from ExecuteJit(fp, stackTop, function, nativeStack), it keeps the stack pointer of
+// the host in r12 and runs the compiled code on the native stack, whose pointer at entry is saved in r13
+static const u16 StencilEnter[] =
+{
+    0x53,                   // push rbx
+    0x41, 0x54,             // push r12
+    0x41, 0x55,             // push r13
+    0x41, 0x56,             // push r14
+    0x48, 0x89, 0xFB,       // mov rbx, rdi
+    0x49, 0x89, 0xF6,       // mov r14, rsi
+    0x49, 0x89, 0xE4,       // mov r12, rsp
+    0x48, 0x89, 0xCC,       // mov rsp, rcx
+    0x49, 0x89, 0xE5,       // mov r13, rsp
+    0xFF, 0xD2,             // call rdx
+    0x31, 0xC0,             // xor eax, eax
+    STENCIL_END
+};
+// the exit system call and the stack overflow restore the native stack pointer and jump here with the exit code in eax,
+// the stack of the host comes back from r12
+static const u16 StencilLeave[] =
+{
+    0x4C, 0x89, 0xE4,       // mov rsp, r12
+    0x41, 0x5E,             // pop r14
+    0x41, 0x5D,             // pop r13
+    0x41, 0x5C,             // pop r12
+    0x5B,                   // pop rbx
+    0xC3,                   // ret
+    STENCIL_END
+};
+// keeps the native stack aligned to 16 bytes for the calls to C
+static const u16 StencilPrologue[] = { 0x48, 0x83, 0xEC, 0x08, STENCIL_END }; // sub rsp, 8
+static const u16 StencilCopyWord[] = { MOV_EAX_SLOT(1), MOV_SLOT_EAX(0), STENCIL_END };
+// 0: limit of the callee frame, 1: callee signature, 2: overflow handler, 3: leave
+static const u16 StencilCheckStack[] =
+{
+    0x48, 0x8D, 0x83, HOLE32(0), // lea rax, [rbx + limit]
+    0x4C, 0x39, 0xF0,            // cmp rax, r14
+    0x72, 0x1E,                  // jb continue
+    0x48, 0xBF, HOLE64(1),       // mov rdi, signature
+    0x48, 0xB8, HOLE64(2),       // mov rax, handler
+    0xFF, 0xD0,                  // call rax
+    0x4C, 0x89, 0xEC,            // mov rsp, r13
+    0xE9, CODE32(3),             // jmp leave
+    STENCIL_END
+};
+// 0: previous fp slot, 1: previous fh slot, 2: caller header offset, 3: callee frame, 4: callee frame in words
+// the header is compact like in the interpreters, fp is the distance from the caller frame
+static const u16 StencilPushFrame[] =
+{
+    0xC7, 0x83, HOLE32(0), HOLE32(4), // mov dword [rbx + fp slot], distance
+    0xC7, 0x83, HOLE32(1), HOLE32(2), // mov dword [rbx + fh slot], header
+    0x48, 0x8D, 0x9B, HOLE32(3),      // lea rbx, [rbx + frame]
+    STENCIL_END
+};
+// 0: link slot of the function, the link is the fp and fh words of the header, it is kept in rcx while the arguments of
+// a tail call are moved over the locals
+static const u16 StencilLoadLink[]  = { MOV_RCX_SLOT(0), STENCIL_END };
+// 0: link slot of the callee
+static const u16 StencilStoreLink[] = { MOV_SLOT_RCX(0), STENCIL_END };
+// drops the padding of the prologue, the callee of the jump that follows pushes it again under the same return address
+static const u16 StencilTailJump[]  = { 0x48, 0x83, 0xC4, 0x08, STENCIL_END }; // add rsp, 8
+// 0: stack pointer of the system call, 1: system call, 2: trampoline
+static const u16 StencilSyscall[] =
+{
+    0x48, 0x8D, 0xBB, HOLE32(0), // lea rdi, [rbx + sp]
+    0xBE, HOLE32(1),             // mov esi, syscall
+    0x48, 0xB8, HOLE64(2),       // mov rax, trampoline
+    0xFF, 0xD0,                  // call rax
+    STENCIL_END
+};
+// 0: destination slot, 1: argument slot, 2: function, the value is passed and returned in xmm0
+static const u16 StencilCallF32[] =
+{
+    MOVSS_XMM0_SLOT(1),
+    0x48, 0xB8, HOLE64(2),       // mov rax, function
+    0xFF, 0xD0,                  // call rax
+    MOVSS_SLOT_XMM0(0),
+    STENCIL_END
+};
+static const u16 StencilCallF64[] =
+{
+    MOVSD_XMM0_SLOT(1),
+    0x48, 0xB8, HOLE64(2),       // mov rax, function
+    0xFF, 0xD0,                  // call rax
+    MOVSD_SLOT_XMM0(0),
+    STENCIL_END
+};
+// 0: destination slot, 1: source slot, 2: size slot, 3: function
+static const u16 StencilCallMemory[] =
+{
+    0x48, 0x8B, 0xBB, HOLE32(0), // mov rdi, [rbx + destination]
+    0x48, 0x8B, 0xB3, HOLE32(1), // mov rsi, [rbx + source]
+    0x8B, 0x93, HOLE32(2),       // mov edx, [rbx + size]
+    0x48, 0xB8, HOLE64(3),       // mov rax, function
+    0xFF, 0xD0,                  // call rax
+    STENCIL_END
+};
+// 0: exit code slot, 1: leave
+static const u16 StencilExit[] = { MOV_EAX_SLOT(0), 0x4C, 0x89, 0xEC, 0xE9, CODE32(1), STENCIL_END };
+// 0: previous fp slot
+static const u16 StencilReturn[] =
+{
+    0x8B, 0x83, HOLE32(0),       // mov eax, [rbx + fp slot]
+    0x48, 0xC1, 0xE0, 0x02,      // shl rax, 2
+    0x48, 0x29, 0xC3,            // sub rbx, rax
+    0x48, 0x83, 0xC4, 0x08,      // add rsp, 8
+    0xC3,                        // ret
+    STENCIL_END
+};
+#pragma endregion
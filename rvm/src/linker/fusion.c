@@ -0,0 +1,285 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "linker.h"
+#include "raiu/assert.h"
+
+typedef struct _JumpFix
+{
+    u32 Position;  // position of the jump in the fused body
+    u32 OldTarget; // target of the jump in the original body
+} JumpFix;
+
+#define NO_JUMP UINT32_MAX
+/**
+ * Writes in out the rewrite of the instructions p, none of them but the first one is a branch target, and returns the
+ * number of instructions it replaces, 0 if it does not apply. If the rewrite is a jump, jump is set to the index of
+ * the instruction in p whose target it keeps.
+ */
+typedef u32 (*Rewrite)(const u8 *const *p, u32 available, u8 *out, u32 *jump);
+
+static inline bool iIsJump(u8 opcode)
+{
+    return opcode == OP_JMP || opcode == OP_JMP_IF || (opcode >= OP_JMP_WORD_EQ && opcode <= OP_JMP_I32_LE);
+}
+static inline bool iLocalWordPush(const u8 *instruction, u8 *l)
+{
+    u8 opcode = *instruction;
+    if(opcode == OP_PUSH_WORD)
+    {
+        *l = instruction[1];
+        return true;
+    }
+    if(opcode >= OP_PUSH_WORD_0 && opcode <= OP_PUSH_WORD_3)
+    {
+        *l = opcode - OP_PUSH_WORD_0;
+        return true;
+    }
+    return false;
+}
+static inline bool iLocalWordPop(const u8 *instruction, u8 *l)
+{
+    u8 opcode = *instruction;
+    if(opcode == OP_POP_WORD)
+    {
+        *l = instruction[1];
+        return true;
+    }
+    if(opcode >= OP_POP_WORD_0 && opcode <= OP_POP_WORD_3)
+    {
+        *l = opcode - OP_POP_WORD_0;
+        return true;
+    }
+    return false;
+}
+static inline bool iImmediateI32Push(const u8 *instruction, i32 *v)
+{
+    switch (*instruction)
+    {
+    case OP_PUSH_0_WORD: *v = 0; return true;
+    case OP_PUSH_I32_1:  *v = 1; return true;
+    case OP_PUSH_I32_2:  *v = 2; return true;
+    case OP_PUSH_I32:    *v = (i8)instruction[1]; return true;
+    default:             return false;
+    }
+}
+/**
+ * Maps a compare instruction to the conditional jump that fuses it with OP_JMP_IF,
+ * if negated the jump fuses the sequence compare, OP_CMP_NOT, OP_JMP_IF.
+ */
+static inline u8 iCompareJump(u8 opcode, bool negated)
+{
+    switch (opcode)
+    {
+    case OP_CMP_WORD_EQ: return negated ? OP_JMP_WORD_NE : OP_JMP_WORD_EQ;
+    case OP_CMP_WORD_NE: return negated ? OP_JMP_WORD_EQ : OP_JMP_WORD_NE;
+    case OP_CMP_I32_GT:  return negated ? OP_JMP_I32_LE  : OP_JMP_I32_GT;
+    case OP_CMP_I32_LT:  return negated ? OP_JMP_I32_GE  : OP_JMP_I32_LT;
+    case OP_CMP_I32_GE:  return negated ? OP_JMP_I32_LT  : OP_JMP_I32_GE;
+    case OP_CMP_I32_LE:  return negated ? OP_JMP_I32_GT  : OP_JMP_I32_LE;
+    default:             return 0;
+    }
+}
+// maps the system calls that only compute on the stack to their opcodes, 0 for the others
+static inline u8 iPromotedSyscall(u8 syscall)
+{
+    switch (syscall)
+    {
+    case OP_SYS_SQRT32: return OP_SQRT_F32;
+    case OP_SYS_SQRT64: return OP_SQRT_F64;
+    case OP_SYS_EXP32:  return OP_EXP_F32;
+    case OP_SYS_EXP64:  return OP_EXP_F64;
+    case OP_SYS_LOG32:  return OP_LOG_F32;
+    case OP_SYS_LOG64:  return OP_LOG_F64;
+    case OP_SYS_MEMMOV: return OP_MEMMOV;
+    case OP_SYS_MEMCPY: return OP_MEMCPY;
+    default:            return 0;
+    }
+}
+static inline u32 iJumpTarget(const u8 *body, u32 position)
+{
+    i16 offset = *(i16*)(body + position + 1);
+    return (u32)((i32)position + 3 + offset);
+}
+
+// the superinstructions of the fusion pass
+static u32 iFuseInstructions(const u8 *const *p, u32 available, u8 *out, u32 *jump)
+{
+    u8 a, b, d;
+    i32 v;
+    if(available >= 4 && iLocalWordPush(p[0], &a) && iLocalWordPush(p[1], &b) && *p[2] == OP_ADD_I32 && iLocalWordPop(p[3], &d))
+    {
+        out[0] = OP_ADD_I32_LOC_LOC;
+        out[1] = a;
+        out[2] = b;
+        out[3] = d;
+        return 4;
+    }
+    if(available >= 4 && iLocalWordPush(p[0], &a) && iImmediateI32Push(p[1], &v) && iLocalWordPop(p[3], &d) &&
+       (*p[2] == OP_ADD_I32 || (*p[2] == OP_SUB_I32 && v != INT8_MIN)))
+    {
+        out[0] = OP_ADD_I32_LOC_IMM;
+        out[1] = a;
+        out[2] = (u8)(i8)(*p[2] == OP_SUB_I32 ? -v : v);
+        out[3] = d;
+        return 4;
+    }
+    if(available >= 3 && iCompareJump(*p[0], true) && *p[1] == OP_CMP_NOT && *p[2] == OP_JMP_IF)
+    {
+        out[0] = iCompareJump(*p[0], true);
+        memcpy(out + 1, p[2] + 1, 2);
+        *jump = 2;
+        return 3;
+    }
+    if(available >= 2 && iCompareJump(*p[0], false) && *p[1] == OP_JMP_IF)
+    {
+        out[0] = iCompareJump(*p[0], false);
+        memcpy(out + 1, p[1] + 1, 2);
+        *jump = 1;
+        return 2;
+    }
+    if(available >= 2 && *p[0] == OP_PUSH_GLOB_REF && (*p[1] == OP_LOAD_WORD || *p[1] == OP_LOAD_DWORD))
+    {
+        out[0] = *p[1] == OP_LOAD_WORD ? OP_LOAD_GLOB_WORD : OP_LOAD_GLOB_DWORD;
+        out[1] = p[0][1];
+        return 2;
+    }
+    // the fused body must fit in the size of the original one, the 3 bytes of the fused push must not be longer than the two pushes
+    if(available >= 2 && iLocalWordPush(p[0], &a) && iLocalWordPush(p[1], &b) &&
+       InstructionSize(p[0]) + InstructionSize(p[1]) >= 3)
+    {
+        out[0] = OP_PUSH_WORD_WORD;
+        out[1] = a;
+        out[2] = b;
+        return 2;
+    }
+    return 0;
+}
+// the system calls of the promotion pass
+static u32 iPromoteSyscall(const u8 *const *p, u32 available, u8 *out, u32 *jump)
+{
+    (void)available; (void)jump;
+    if(*p[0] != OP_SYSCALL || !iPromotedSyscall(p[0][1]))
+        return 0;
+    out[0] = iPromotedSyscall(p[0][1]);
+    return 1;
+}
+
+static u32 iRewriteBody(const Function *function, u8 *code, u32 *fusedSize, u32 *offsets, Rewrite rewrite)
+{
+    const u8 *body = function->Body;
+    u32 size = function->Header.Size;
+
+    u32  *starts     = malloc((size + 1) * sizeof(u32));
+    u32  *newOffsets = offsets ? offsets : malloc((size + 1) * sizeof(u32));
+    bool *isTarget   = calloc(size + 1, sizeof(bool));
+    JumpFix *fixes   = malloc((size + 1) * sizeof(JumpFix));
+    u32 fused = 0;
+
+    // collect the instructions and the branch targets, a malformed body is left to the validator
+    u32 count = 0;
+    for (u32 position = 0; position < size; position += InstructionSize(body + position))
+    {
+        if(body[position] == 0 || (body[position] > OP_MAX_OPCODE && body[position] != OP_EXTENDED) || position + InstructionSize(body + position) > size)
+            goto RET;
+        if(iIsJump(body[position]))
+        {
+            u32 target = iJumpTarget(body, position);
+            if(target > size)
+                goto RET;
+            isTarget[target] = true;
+        }
+        starts[count++] = position;
+    }
+    starts[count] = size;
+    // a jump into an instruction has no position in the fused body, it is left to the validator too
+    for (u32 position = 0, i = 0; position <= size; position++)
+    {
+        if(position == starts[i])
+            i++;
+        else if(isTarget[position])
+            goto RET;
+    }
+
+    u32 fixCount = 0;
+    u32 newSize  = 0;
+    u32 k = 0;
+    while (k < count)
+    {
+        const u8 *p[4];
+        u32 available = 1;
+        p[0] = body + starts[k];
+        while (available < 4 && k + available < count && !isTarget[starts[k + available]])
+        {
+            p[available] = body + starts[k + available];
+            available++;
+        }
+
+        u8 *out = code + newSize;
+        u32 jump = NO_JUMP;
+        u32 consumed = rewrite(p, available, out, &jump);
+        if(consumed)
+        {
+            if(jump != NO_JUMP)
+                fixes[fixCount++] = (JumpFix) { newSize, iJumpTarget(body, starts[k + jump]) };
+            newOffsets[starts[k]] = newSize;
+            newSize += InstructionSize(out);
+            k += consumed;
+            fused++;
+            continue;
+        }
+
+        u32 instructionSize = InstructionSize(p[0]);
+        memcpy(out, p[0], instructionSize);
+        if(iIsJump(*p[0]))
+            fixes[fixCount++] = (JumpFix) { newSize, iJumpTarget(body, starts[k]) };
+        newOffsets[starts[k]] = newSize;
+        newSize += instructionSize;
+        k += 1;
+    }
+    newOffsets[size] = newSize;
+
+    for (u32 i = 0; i < fixCount; i++)
+    {
+        i32 offset = (i32)newOffsets[fixes[i].OldTarget] - (i32)(fixes[i].Position + 3);
+        DEVEL_ASSERT(offset >= INT16_MIN && offset <= INT16_MAX, "Fused jump offset out of range in function %s\n", function->Header.Signature);
+        *(i16*)(code + fixes[i].Position + 1) = (i16)offset;
+    }
+
+    *fusedSize = newSize;
+RET:
+    free(starts);
+    if(!offsets)
+        free(newOffsets);
+    free(isTarget);
+    free(fixes);
+    return fused;
+}
+static u32 iRewriteInPlace(Function *function, Rewrite rewrite)
+{
+    u32 size = function->Header.Size;
+    u8 *code = malloc(size + 1);
+
+    u32 newSize = size;
+    u32 fused   = iRewriteBody(function, code, &newSize, NULL, rewrite);
+    if(fused)
+    {
+        memcpy(function->Body, code, newSize);
+        memset(function->Body + newSize, 0, size - newSize);
+        function->Header.Size = newSize;
+    }
+    free(code);
+    return fused;
+}
+u32 FuseBody(const Function *function, u8 *code, u32 *size, u32 *offsets)
+{
+    return iRewriteBody(function, code, size, offsets, iFuseInstructions);
+}
+u32 FuseSuperinstructions(Function *function)
+{
+    return iRewriteInPlace(function, iFuseInstructions);
+}
+u32 PromoteSyscalls(Function *function)
+{
+    return iRewriteInPlace(function, iPromoteSyscall);
+}
\ No newline at end of file
@@ -7,6 +7,7 @@
 #include "rvm.h"
 #include "raiu/raiu.h"
 #include "metadata.h"
+#include "jit/jit.h"
 
 #define MAP_T void*
 #define MAP_K String
@@ -316,14 +317,26 @@ static sz iGetAlignement(sz size)
     else /* size==1 */ alignement = SIZEOF_BYTE;
     return alignement;
 }
+// the global pool of a module holds the internal globals followed by the external ones
+static const String *iGlobalSignature(const ModuleData *moduleData, u32 index)
+{
+    if(index < moduleData->InternalGlobals.Count)
+        return List_String_AtRO(&moduleData->InternalGlobals, index);
+    return List_String_AtRO(&moduleData->ExternalGlobals, index - moduleData->InternalGlobals.Count);
+}
+// the globals can all be thread-local or all shared, an empty map has no bucket to hash to
+static void *const *iFindGlobal(const Map_String_Ptr *globalMap, const String *signature)
+{
+    return globalMap->Count ? Map_String_Ptr_AtRO(globalMap, signature) : NULL;
+}
 static i32  iAllocateContextBuffers(ProgramContext *context, const LinkData *linkData)
 {
-    #define DEFAULT_STACK_SIZE (1 << 22)
     sz wordBufferSize     = 0;
     sz dwordBufferSize    = 0;
     sz stringBufferSize   = 0;
     sz functionBufferSize = 0;
     sz globalsBufferSize  = 0;
+    sz threadLocalsSize   = 0;
     sz debugStringBufferSize = 0;
     for (u32 i = 0; i < linkData->Count; i++)
     {
@@ -341,10 +354,12 @@ static i32  iAllocateContextBuffers(ProgramContext *context, const LinkData *lin
         for (u32 j = 0; j < moduleData->GlobalSizes.Count; j++)
         {
             sz globalSize = *List_sz_AtRO(&moduleData->GlobalSizes, j);
+            sz *bufferSize = globalSize & GLOBAL_THREAD_LOCAL ? &threadLocalsSize : &globalsBufferSize;
+            globalSize &= ~GLOBAL_THREAD_LOCAL;
             sz alignement = iGetAlignement(globalSize);
             
-            globalsBufferSize += globalsBufferSize % alignement ? alignement - (globalsBufferSize % alignement): 0; // align to alignement
-            globalsBufferSize += globalSize;
+            *bufferSize += *bufferSize % alignement ? alignement - (*bufferSize % alignement): 0; // align to alignement
+            *bufferSize += globalSize;
         }
         for(u32 j = 0; j < moduleData->InternalFunctions.Count; j++)
             debugStringBufferSize += List_String_AtRO(&moduleData->InternalFunctions, j)->Length + 1;   
@@ -352,13 +367,15 @@ static i32  iAllocateContextBuffers(ProgramContext *context, const LinkData *lin
     
     // TODO: allocate debug string buffer
     
-    context->StackBottom = calloc(DEFAULT_STACK_SIZE, sizeof(Word));
-    context->StackTop    = context->StackBottom + DEFAULT_STACK_SIZE / sizeof(Word);
+    // the stack grows on demand, see interpreter/stack.c
+    if(!MapStack(context, context->Options.StackSize, context->Options.StackMaxSize))
+        context->StackBottom = NULL;
     
     context->WordsBuffer        = wordBufferSize     ? (Word*)  calloc(wordBufferSize  , sizeof(Word))   : NULL;
     context->DWordsBuffer       = dwordBufferSize    ? (DWord*) calloc(dwordBufferSize , sizeof(DWord))  : NULL;
     context->StringsBuffer      = stringBufferSize   ? (Byte*)  calloc(stringBufferSize, sizeof(Byte))   : NULL;
     context->GlobalsBuffer      = globalsBufferSize  ? (Byte*)  calloc(globalsBufferSize, sizeof(Byte))  : NULL;
+    context->ThreadLocals       = threadLocalsSize   ? (Byte*)  calloc(threadLocalsSize, sizeof(Byte))   : NULL;
     context->FunctionsBuffer    = (Byte*)        calloc(functionBufferSize, sizeof(Byte));
     context->ModuleTablesBuffer = (ModuleTable*) calloc(linkData->Count   , sizeof(ModuleTable));
     context->DebugStringsBuffer  = (Byte*)        calloc(debugStringBufferSize, sizeof(Byte));
@@ -368,6 +385,7 @@ static i32  iAllocateContextBuffers(ProgramContext *context, const LinkData *lin
     context->StringsBufferSize      = stringBufferSize;
     context->FunctionsBufferSize    = functionBufferSize;
     context->GlobalsBufferSize      = globalsBufferSize;
+    context->ThreadLocalsSize       = threadLocalsSize;
     context->ModuleTablesBufferSize = linkData->Count; 
     context->DebugStringsBufferSize  = debugStringBufferSize;
 
@@ -379,7 +397,8 @@ static i32  iAllocateContextBuffers(ProgramContext *context, const LinkData *lin
         (context->WordsBufferSize     != 0 && context->WordsBuffer        == NULL) ||
         (context->DWordsBufferSize    != 0 && context->DWordsBuffer       == NULL) ||
         (context->StringsBufferSize   != 0 && context->StringsBuffer      == NULL) ||
-        (context->GlobalsBufferSize   != 0 && context->GlobalsBuffer      == NULL) 
+        (context->GlobalsBufferSize   != 0 && context->GlobalsBuffer      == NULL) ||
+        (context->ThreadLocalsSize    != 0 && context->ThreadLocals       == NULL) 
     )
     {
         DEVEL_ASSERT(false, "Linked : Failed to allocate application data!");
@@ -387,12 +406,26 @@ static i32  iAllocateContextBuffers(ProgramContext *context, const LinkData *lin
     }
     return 0;
 }
-static void iFillBuffers(ProgramContext *context, Map_String_Ptr *functionMap, Map_String_Ptr *globalMap, const LinkData *linkData)
+/*
+    With aligned frames the locals of every function take an even number of words, so the frame header and the base of 
+    the stack of a frame are 8 bytes aligned when its frame pointer is. The stack bottom is page aligned and a call 
+    made with only its arguments on the stack puts the callee frame pointer at the even stack base of the caller, so 
+    in the common case the dwords at even local indices and stack depths and the saved pc are naturally aligned.
+*/
+static u16 iFrameLWC(const ProgramContext *context, const FunctionData *functionData)
+{
+    if(context->Options.AlignedFrames && functionData->LWC % 2 != 0 && functionData->LWC < UINT16_MAX)
+        return functionData->LWC + 1;
+    return functionData->LWC;
+}
+
+static void iFillBuffers(ProgramContext *context, Map_String_Ptr *functionMap, Map_String_Ptr *globalMap, Map_String_Ptr *threadLocalMap, const LinkData *linkData)
 {
     Word  *wordPtr     = context->WordsBuffer;
     DWord *dwordPtr    = context->DWordsBuffer;
     Byte  *stringPtr   = context->StringsBuffer;
     Byte  *globalPtr   = context->GlobalsBuffer;
+    sz     threadLocalOffset = 0;
     Byte  *functionPtr = context->FunctionsBuffer;
     Byte  *debugStringPtr = context->DebugStringsBuffer;
 
@@ -419,6 +452,18 @@ static void iFillBuffers(ProgramContext *context, Map_String_Ptr *functionMap, M
         {
             const String *globalSignature =  List_String_AtRO(&moduleData->InternalGlobals, j);
             sz            globalSize      = *List_sz_AtRO(&moduleData->GlobalSizes, j);
+            if(globalSize & GLOBAL_THREAD_LOCAL)
+            {
+                // the thread-local globals are mapped to their offset in the copy of a thread, the copies are aligned 
+                // like the globals buffer
+                globalSize &= ~GLOBAL_THREAD_LOCAL;
+                sz alignement = iGetAlignement(globalSize);
+                threadLocalOffset += threadLocalOffset % alignement ? alignement - (threadLocalOffset % alignement) : 0;
+                void *offset = (void*)threadLocalOffset;
+                Map_String_Ptr_PutCopy(threadLocalMap, globalSignature, &offset);
+                threadLocalOffset += globalSize;
+                continue;
+            }
             sz alignement = iGetAlignement(globalSize);
             if((sz)globalPtr % alignement)
                 globalPtr += alignement - ((sz)globalPtr % alignement); // align
@@ -436,9 +481,20 @@ static void iFillBuffers(ProgramContext *context, Map_String_Ptr *functionMap, M
             function->Header.Signature = &debugStringPtr->Char;
             function->Header.MT = NULL;
             function->Header.AWC = functionData->AWC;
-            function->Header.LWC = functionData->LWC;
+            function->Header.LWC = iFrameLWC(context, functionData);
             function->Header.SWC = functionData->SWC;
             function->Header.RWC = functionData->RWC;
+            function->Header.Size = functionData->Size;
+            function->Header.RegisterBody = NULL;
+            function->Header.RegisterSize = 0;
+            function->Header.NativeBody   = NULL;
+            function->Header.ThreadedBody = NULL;
+            function->Header.Code         = function->Body;
+            function->Header.Calls        = 0;
+            function->Header.BackEdges    = 0;
+            function->Header.Tier         = 0;
+            function->Header.Leaf         = true;
+            function->Header.Generator    = false;
             memcpy(function->Body, functionData->Body, functionData->Size);
 
             // copy function signature
@@ -453,7 +509,365 @@ static void iFillBuffers(ProgramContext *context, Map_String_Ptr *functionMap, M
         }
     }
 }
-static i32  iSetPools(ProgramContext *context, const Map_String_Ptr *functionMap, const Map_String_Ptr *globalMap, const LinkData *linkData)
+static void iPromoteSyscalls(Map_String_Ptr *functionMap)
+{
+    u32 promoted = 0;
+    foreach(Map_String_Ptr, *functionMap)
+    {
+        const Map_String_Ptr_Pair *p = Map_String_Ptr_Iterator_AccessRO(&i);
+        promoted += PromoteSyscalls((Function*)p->Val);
+    }
+    LOG_INFO("Linker : %u system calls promoted", promoted);
+}
+static void iOptimizeFunctions(ProgramContext *context, Map_String_Ptr *functionMap)
+{
+    // with tiering the fusion runs on the functions that get hot
+    if(!context->Options.Fusion || context->Options.Tiering)
+        return;
+
+    u32 fused = 0;
+    foreach(Map_String_Ptr, *functionMap)
+    {
+        const Map_String_Ptr_Pair *p = Map_String_Ptr_Iterator_AccessRO(&i);
+        fused += FuseSuperinstructions((Function*)p->Val);
+    }
+    LOG_INFO("Linker : %u superinstructions fused", fused);
+}
+/**
+ * Rewrites the calls followed by a return into tail calls, the callee reuses the frame of the function and returns
+ * straight to its caller. The return is kept after the call, it is still the target of the jumps that reach it.
+ */
+static void iTailCalls(ProgramContext *context, Map_String_Ptr *functionMap)
+{
+    if(!context->Options.TailCalls)
+        return;
+
+    u32 calls = 0;
+    foreach(Map_String_Ptr, *functionMap)
+    {
+        const Map_String_Ptr_Pair *p = Map_String_Ptr_Iterator_AccessRO(&i);
+        Function *function = (Function*)p->Val;
+        u32 n;
+        for (u32 position = 0; (n = CheckedInstructionSize(function, position)) != 0; position += n)
+        {
+            u8 *instruction = function->Body + position;
+            u32 next = position + n;
+            if(next >= function->Header.Size || function->Body[next] != OP_RET)
+                continue;
+
+            if(*instruction == OP_INDCALL)
+            {
+                *instruction = OP_INDTAILCALL;
+                calls++;
+            }
+            else if(*instruction == OP_CALL)
+            {
+                // the results of the callee are the ones of the function only if it returns as many words
+                u16 f = *(u16*)(instruction + 1);
+                if(f >= function->Header.MT->FunctionPoolSize || function->Header.MT->FunctionPool[f]->Header.RWC != function->Header.RWC)
+                    continue;
+                *instruction = OP_TAILCALL;
+                calls++;
+            }
+        }
+    }
+    LOG_INFO("Linker : %u tail calls", calls);
+}
+/**
+ * Rewrites the global refs of the thread-local globals, their pool entries are offsets in the copy of the running thread.
+ * It runs before the fusion, so a thread-local global is never loaded by a superinstruction.
+ */
+static void iThreadLocalGlobals(const ProgramContext *context, Map_String_Ptr *functionMap, const Map_String_Ptr *threadLocalMap, const LinkData *linkData)
+{
+    if(context->ThreadLocalsSize == 0)
+        return;
+
+    u32 refs = 0;
+    for (u32 i = 0; i < linkData->Count; i++)
+    {
+        const ModuleData *moduleData = LinkData_AtRO(linkData, i);
+        u32 globals = moduleData->InternalGlobals.Count + moduleData->ExternalGlobals.Count;
+        for (u32 j = 0; j < moduleData->InternalFunctions.Count; j++)
+        {
+            Function *function = *(Function**) Map_String_Ptr_AtRO(functionMap, List_String_AtRO(&moduleData->InternalFunctions, j));
+            u32 n;
+            for (u32 position = 0; (n = CheckedInstructionSize(function, position)) != 0; position += n)
+            {
+                u8 *instruction = function->Body + position;
+                if(*instruction != OP_PUSH_GLOB_REF && *instruction != OP_PUSH_GLOB_REF_W)
+                    continue;
+                // a ref out of the pool is left to the validator
+                u32 c = *instruction == OP_PUSH_GLOB_REF ? instruction[1] : *(u16*)(instruction + 1);
+                if(c >= globals || iFindGlobal(threadLocalMap, iGlobalSignature(moduleData, c)) == NULL)
+                    continue;
+                *instruction = *instruction == OP_PUSH_GLOB_REF ? OP_PUSH_TLS_REF : OP_PUSH_TLS_REF_W;
+                refs++;
+            }
+        }
+    }
+    LOG_INFO("Linker : %zu bytes of thread-local globals, %u refs", context->ThreadLocalsSize, refs);
+}
+/**
+ * Marks the functions of the generators, the validator lets only them yield and rejects the calls to them, a yield 
+ * finds the generator under the frame that a resume has pushed.
+ */
+static void iFindGenerators(Map_String_Ptr *functionMap)
+{
+    foreach(Map_String_Ptr, *functionMap)
+    {
+        const Map_String_Ptr_Pair *p = Map_String_Ptr_Iterator_AccessRO(&i);
+        const Function *function = (const Function*)p->Val;
+        u32 n;
+        for (u32 position = 0; (n = CheckedInstructionSize(function, position)) != 0; position += n)
+        {
+            if(function->Body[position] != OP_GEN_NEW)
+                continue;
+            // a function out of the pool is left to the validator
+            u16 f = *(u16*)(function->Body + position + 1);
+            if(f < function->Header.MT->FunctionPoolSize)
+                function->Header.MT->FunctionPool[f]->Header.Generator = true;
+        }
+    }
+}
+static void iFindThreads(ProgramContext *context, Map_String_Ptr *functionMap)
+{
+    foreach(Map_String_Ptr, *functionMap)
+    {
+        const Map_String_Ptr_Pair *p = Map_String_Ptr_Iterator_AccessRO(&i);
+        const Function *function = (const Function*)p->Val;
+        u32 n;
+        for (u32 position = 0; (n = CheckedInstructionSize(function, position)) != 0; position += n)
+        {
+            const u8 *instruction = function->Body + position;
+            if(instruction[0] != OP_SYSCALL)
+                continue;
+            if(instruction[1] >= OP_SYS_SPAWN && instruction[1] <= OP_SYS_YIELD)
+                context->SpawnsThreads = true;
+            if(instruction[1] == OP_SYS_PARFOR)
+                context->ParallelFor = true;
+        }
+    }
+    if(!context->SpawnsThreads && !context->ParallelFor)
+        return;
+
+    // the scheduler suspends the threads with the fuel of the stack interpreter and the parallel loops run it again from
+    // their system call, the tiers would be promoted by all the workers at the same time
+    if(context->Options.Register || context->Options.Jit || context->Options.Threaded || context->Options.Tiering)
+    {
+        context->Options.Register = false;
+        context->Options.Jit      = false;
+        context->Options.Threaded = false;
+        context->Options.Tiering  = false;
+        LOG_WARN("Linker : The threads run only on the stack interpreter without tiering, falling back to it");
+    }
+}
+static void iAllocateInlineCaches(ProgramContext *context, Map_String_Ptr *functionMap)
+{
+    u32 sites = 0;
+    foreach(Map_String_Ptr, *functionMap)
+    {
+        const Map_String_Ptr_Pair *p = Map_String_Ptr_Iterator_AccessRO(&i);
+        const Function *function = (const Function*)p->Val;
+        for (u32 position = 0; position < function->Header.Size; position += InstructionSize(function->Body + position))
+            if(function->Body[position] == OP_INDCALL || function->Body[position] == OP_INDTAILCALL)
+                sites++;
+    }
+
+    // the promoted bodies can double the sites, the caches are probed linearly and must never fill up
+    u32 bits = 4;
+    while ((1U << bits) < 4 * sites)
+        bits++;
+    context->InlineCaches     = (InlineCache*) calloc(1U << bits, sizeof(InlineCache));
+    context->InlineCachesBits = bits;
+    LOG_INFO("Linker : %u indirect call sites, %u inline caches", sites, 1U << bits);
+}
+static void iQuickenCalls(ProgramContext *context, Map_String_Ptr *functionMap)
+{
+    if(!context->EntryPoint)
+        return;
+
+    // a leaf keeps the pools of its caller, it must not be reachable from other modules or through a function pointer
+    context->EntryPoint->Header.Leaf = false;
+    for (u32 m = 0; m < context->ModuleTablesBufferSize; m++)
+    {
+        const ModuleTable *moduleTable = context->ModuleTablesBuffer + m;
+        for (u32 f = 0; f < moduleTable->FunctionPoolSize; f++)
+            if(moduleTable->FunctionPool[f]->Header.MT != moduleTable)
+                moduleTable->FunctionPool[f]->Header.Leaf = false;
+    }
+    foreach(Map_String_Ptr, *functionMap)
+    {
+        const Map_String_Ptr_Pair *p = Map_String_Ptr_Iterator_AccessRO(&i);
+        const Function *function = (const Function*)p->Val;
+        for (u32 position = 0; position < function->Header.Size; position += InstructionSize(function->Body + position))
+            // the callee of a tail call returns to a caller that can be in another module, so does a generator
+            if(function->Body[position] == OP_PUSH_FUNC || function->Body[position] == OP_TAILCALL || 
+               function->Body[position] == OP_GEN_NEW || function->Body[position] == OP_RESUME)
+                function->Header.MT->FunctionPool[*(u16*)(function->Body + position + 1)]->Header.Leaf = false;
+    }
+
+    // the quickened calls name the callee by its offset in the functions buffer, in double words, a leaf keeps the link to
+    // its caller in the registers of the interpreter, so it must be entered only by quickened calls
+    foreach(Map_String_Ptr, *functionMap)
+    {
+        const Map_String_Ptr_Pair *p = Map_String_Ptr_Iterator_AccessRO(&i);
+        const Function *function = (const Function*)p->Val;
+        for (u32 position = 0; position < function->Header.Size; position += InstructionSize(function->Body + position))
+        {
+            if(function->Body[position] != OP_CALL)
+                continue;
+            Function *callee = function->Header.MT->FunctionPool[*(u16*)(function->Body + position + 1)];
+            if(((const Byte*)callee - context->FunctionsBuffer) / SIZEOF_DWORD > UINT16_MAX)
+                callee->Header.Leaf = false;
+        }
+    }
+    u32 calls  = 0;
+    u32 leaves = 0;
+    foreach(Map_String_Ptr, *functionMap)
+    {
+        const Map_String_Ptr_Pair *p = Map_String_Ptr_Iterator_AccessRO(&i);
+        Function *function = (Function*)p->Val;
+        for (u32 position = 0; position < function->Header.Size; position += InstructionSize(function->Body + position))
+        {
+            u8 *instruction = function->Body + position;
+            if(*instruction == OP_RET && function->Header.Leaf)
+                *instruction = OP_RET_LEAF;
+            if(*instruction != OP_CALL)
+                continue;
+
+            const Function *callee = function->Header.MT->FunctionPool[*(u16*)(instruction + 1)];
+            sz offset = ((const Byte*)callee - context->FunctionsBuffer) / SIZEOF_DWORD;
+            if(offset > UINT16_MAX)
+                continue;
+            instruction[0] = callee->Header.Leaf ? OP_CALL_LEAF : OP_CALL_FUNC;
+            *(u16*)(instruction + 1) = (u16)offset;
+            calls++;
+            leaves += callee->Header.Leaf;
+        }
+    }
+    LOG_INFO("Linker : %u calls quickened, %u of them to leaf functions", calls, leaves);
+}
+static void iTranslateFunctions(ProgramContext *context, Map_String_Ptr *functionMap)
+{
+    if(context->Options.Fuel && (context->Options.Register || context->Options.Jit || context->Options.Threaded))
+    {
+        context->Options.Register = false;
+        context->Options.Jit      = false;
+        context->Options.Threaded = false;
+        printf("Only the stack interpreter burns fuel, the program runs on it\n");
+    }
+    if(!context->Options.Register && !context->Options.Jit && !context->Options.Threaded)
+        return;
+
+    // every function is translated in a temporary body, the program runs in the register form only if all of them are
+    List_sz sizes;
+    List_sz_Create(&sizes);
+    u32  stackInstructions    = 0;
+    u32  registerInstructions = 0;
+    const Function *untranslated = NULL;
+    foreach(Map_String_Ptr, *functionMap)
+    {
+        const Map_String_Ptr_Pair *p = Map_String_Ptr_Iterator_AccessRO(&i);
+        Function *function = (Function*)p->Val;
+        for (u32 position = 0; position < function->Header.Size; position += InstructionSize(function->Body + position))
+            stackInstructions++;
+
+        u32 size = 0;
+        u32 instructions = untranslated ? 0 : TranslateToRegisters(function, &function->Header.RegisterBody, &size);
+        if(!instructions && !untranslated)
+            untranslated = function;
+        registerInstructions += instructions;
+        sz bodySize = size;
+        List_sz_PushBack(&sizes, &bodySize);
+        context->RegisterBodiesBufferSize += size;
+    }
+
+    bool translated = untranslated == NULL;
+    if(translated)
+    {
+        context->RegisterBodiesBuffer = malloc(context->RegisterBodiesBufferSize);
+        LOG_INFO("Linker : %u stack instructions translated into %u register instructions", stackInstructions, registerInstructions);
+    }
+    else
+    {
+        // the engine of the options is not the one that runs the program, it is told also in the release builds
+        printf("Function %s cannot be translated to the register form, the program runs on the stack interpreter\n", untranslated->Header.Signature);
+        context->RegisterBodiesBufferSize = 0;
+        context->Options.Register = false;
+        context->Options.Jit      = false;
+        context->Options.Threaded = false;
+    }
+
+    u8 *registerBody = context->RegisterBodiesBuffer;
+    u32 j = 0;
+    foreach(Map_String_Ptr, *functionMap)
+    {
+        const Map_String_Ptr_Pair *p = Map_String_Ptr_Iterator_AccessRO(&i);
+        Function *function = (Function*)p->Val;
+        sz size = *List_sz_AtRO(&sizes, j++);
+        if(translated)
+        {
+            memcpy(registerBody, function->Header.RegisterBody, size);
+            free(function->Header.RegisterBody);
+            function->Header.RegisterBody = registerBody;
+            function->Header.RegisterSize = size;
+            registerBody += size;
+        }
+        else
+        {
+            free(function->Header.RegisterBody);
+            function->Header.RegisterBody = NULL;
+        }
+    }
+    List_sz_Destroy(&sizes);
+}
+static void iCompileFunctions(ProgramContext *context, Map_String_Ptr *functionMap)
+{
+    if(!context->Options.Jit)
+        return;
+
+    Function **functions = malloc(functionMap->Count * sizeof(Function*));
+    u32 count = 0;
+    foreach(Map_String_Ptr, *functionMap)
+    {
+        const Map_String_Ptr_Pair *p = Map_String_Ptr_Iterator_AccessRO(&i);
+        functions[count++] = (Function*)p->Val;
+    }
+    if(!JitCompile(context, functions, count))
+    {
+        // the whole program falls back, the compiled functions cannot call the interpreted ones
+        context->Options.Jit = false;
+        printf("The program runs on the %s interpreter\n", context->Options.Threaded ? "threaded" : context->Options.Register ? "register" : "stack");
+    }
+    free(functions);
+}
+static void iThreadFunctions(ProgramContext *context, Map_String_Ptr *functionMap)
+{
+    if(!context->Options.Threaded)
+        return;
+
+    const void *const *handlers = ThreadedHandlers();
+    sz cells = 0;
+    foreach(Map_String_Ptr, *functionMap)
+    {
+        const Map_String_Ptr_Pair *p = Map_String_Ptr_Iterator_AccessRO(&i);
+        cells += ThreadFunction((Function*)p->Val, handlers, NULL);
+    }
+
+    // the cells of all functions are in one buffer like the register bodies
+    context->ThreadedCodeBufferSize = cells * sizeof(Cell);
+    context->ThreadedCodeBuffer     = malloc(context->ThreadedCodeBufferSize);
+    Cell *code = context->ThreadedCodeBuffer;
+    foreach(Map_String_Ptr, *functionMap)
+    {
+        const Map_String_Ptr_Pair *p = Map_String_Ptr_Iterator_AccessRO(&i);
+        Function *function = (Function*)p->Val;
+        function->Header.ThreadedBody = code;
+        code += ThreadFunction(function, handlers, code);
+    }
+    LOG_INFO("Linker : %lu cells of threaded code", cells);
+}
+static i32  iSetPools(ProgramContext *context, const Map_String_Ptr *functionMap, const Map_String_Ptr *globalMap, const Map_String_Ptr *threadLocalMap, const LinkData *linkData)
 {
     sz wordIterator  = 0;
     sz dwordIterator = 0;
@@ -485,8 +899,10 @@ static i32  iSetPools(ProgramContext *context, const Map_String_Ptr *functionMap
         moduleTable->GlobalPool = moduleTable->GlobalPoolSize ? calloc(moduleTable->GlobalPoolSize, sizeof(void*)) : NULL;
         for (u32 i = 0; i < moduleTable->GlobalPoolSize; i++)
         {
-            const String *globSignature = List_String_AtRO(i < moduleData->InternalGlobals.Count ? &moduleData->InternalGlobals : &moduleData->ExternalGlobals, i);
-            void *const *globalLoc = Map_String_Ptr_AtRO(globalMap, globSignature);
+            const String *globSignature = iGlobalSignature(moduleData, i);
+            void *const *globalLoc = iFindGlobal(globalMap, globSignature);
+            if(!globalLoc)
+                globalLoc = iFindGlobal(threadLocalMap, globSignature);
             if(!globalLoc)
             {
                 DEVEL_ASSERT(false, "Linker : Cannot find global %s", String_CStr(globSignature));
@@ -542,9 +958,11 @@ i32 Link(ProgramContext *context, const String *rootpath)
     LinkData linkData;
     Map_String_Ptr functionMap;
     Map_String_Ptr globalMap;
+    Map_String_Ptr threadLocalMap;
     LinkData_Create(&linkData);
     Map_String_Ptr_Create(&functionMap);
     Map_String_Ptr_Create(&globalMap);
+    Map_String_Ptr_Create(&threadLocalMap);
 
     i32 getError = iGetLinkData(&linkData, rootpath);
     if(getError)
@@ -561,9 +979,19 @@ i32 Link(ProgramContext *context, const String *rootpath)
         goto RET;
     }
 
-    iFillBuffers(context, &functionMap, &globalMap, &linkData);
+    iFillBuffers(context, &functionMap, &globalMap, &threadLocalMap, &linkData);
+    iThreadLocalGlobals(context, &functionMap, &threadLocalMap, &linkData);
+    iFindThreads(context, &functionMap);
+    if(context->Options.Tiering && (context->Options.Register || context->Options.Jit || context->Options.Threaded || !context->Options.Fusion || context->Options.Fuel))
+    {
+        // the tiers are fused bytecode bodies, only the tiered variant of the stack interpreter runs them
+        LOG_WARN("Linker : Tiering is supported only by the stack interpreter with the fusion enabled and no fuel");
+        context->Options.Tiering = false;
+    }
+    iPromoteSyscalls(&functionMap);
+    iOptimizeFunctions(context, &functionMap);
 
-    i32 functionNotFound = iSetPools(context, &functionMap, &globalMap, &linkData);
+    i32 functionNotFound = iSetPools(context, &functionMap, &globalMap, &threadLocalMap, &linkData);
     if(functionNotFound)
     {
         error = functionNotFound;
@@ -574,6 +1002,15 @@ i32 Link(ProgramContext *context, const String *rootpath)
     i32 mainFuncNotFound = iSetEntryPoint(context, &functionMap, rootpath);
     if(mainFuncNotFound)
         error = mainFuncNotFound;
+    iTailCalls(context, &functionMap);
+    iFindGenerators(&functionMap);
+    if(context->EntryPoint && context->EntryPoint->Header.Generator)
+    {
+        // the entry point has no resume under its frame
+        DEVEL_ASSERT(false, "The entry point %s is the function of a generator\n", context->EntryPoint->Header.Signature);
+        error = 1;
+        goto RET;
+    }
     
     
     bool valid = true;
@@ -593,10 +1030,16 @@ i32 Link(ProgramContext *context, const String *rootpath)
         error = 1;
         goto RET;
     }
+    iAllocateInlineCaches(context, &functionMap);
+    iTranslateFunctions(context, &functionMap);
+    iCompileFunctions(context, &functionMap);
+    iThreadFunctions(context, &functionMap);
+    iQuickenCalls(context, &functionMap);
     
 RET:
     Map_String_Ptr_Destroy(&functionMap);
     Map_String_Ptr_Destroy(&globalMap);
+    Map_String_Ptr_Destroy(&threadLocalMap);
     LinkData_Destroy(&linkData);
     return error;
 }
@@ -616,6 +1059,12 @@ void Unlink(ProgramContext *context)
     free(context->StringsBuffer);
     free(context->FunctionsBuffer);
     free(context->GlobalsBuffer);
-    free(context->StackBottom);
+    free(context->ThreadLocals);
+    UnmapStack(context);
     free(context->DebugStringsBuffer);
+    free(context->RegisterBodiesBuffer);
+    free(context->ThreadedCodeBuffer);
+    List_TierEvent_Destroy(&context->TierEvents);
+    free(context->InlineCaches);
+    JitRelease(context);
 }
\ No newline at end of file
@@ -4,6 +4,7 @@
 #include <stdbool.h>
 #include <string.h>
 #include "metadata.h"
+#include "interpreter/interpreter.h"
 
 #define LIST_T Word
 #include "raiu/list.h"
@@ -34,6 +35,9 @@ static inline void FunctionData_Destroy(FunctionData *data) { free(data->Body);
 #define LIST_T sz
 #include "raiu/list.h"
 
+// the highest bit of the size of a global in a module file marks it as thread-local, every thread has its own copy of it
+#define GLOBAL_THREAD_LOCAL ((sz)1 << 31)
+
 /**
  * A link time struct that holds the data of a module to link
  */
@@ -101,9 +105,99 @@ static inline void ModuleData_Destroy(ModuleData *data)
  * @attention The only case where the validity of a function is trusted 
  * is when the function uses the IND_CALL opcode (call through a function pointer)
  * 
+ * The Leaf flag of the header is cleared if a call or a system call is reached.
+ * 
  * @param header The function header 
  * @param instruction The instruction to start from, by default should be NULL
  * @param sp The current stack pointer, by default should be 0
  * @return 0 if the function is valid, 1 otherwise
  */
-i32 Validate(const Function *function, const u8 *instruction, i32 sp);
+i32 Validate(Function *function, const u8 *instruction, i32 sp);
+
+/**
+ * @brief Returns the size in bytes of an instruction, opcode and fixed parameters included, the prefix of an instruction 
+ * of the extended page is counted too.
+ * 
+ * @param instruction The instruction
+ * @return The size of the instruction
+ */
+u32 InstructionSize(const u8 *instruction);
+
+/**
+ * @brief Returns the size in bytes of the instruction at a position of a body that has not been validated yet, the 
+ * passes of the linker that run before the validator walk the bodies with it and leave a malformed one to the validator.
+ * 
+ * @param function The function
+ * @param position The position of the instruction in the body
+ * @return The size of the instruction, 0 at the end of the body, on an invalid opcode or if the instruction ends after
+ * the body
+ */
+u32 CheckedInstructionSize(const Function *function, u32 position);
+
+/**
+ * @brief Returns how many words a system call pushes on the stack, negative if it pops them.
+ * 
+ * @param syscall The system call
+ * @return The stack offset of the system call
+ */
+i32 SyscallStackOffset(u8 syscall);
+
+/**
+ * @brief Rewrites the recognized instruction sequences of a function body into superinstructions, the branch offsets 
+ * are relocated and the body size is updated, the body never grows.
+ * 
+ * A sequence is fused only if none of its instructions except the first one is a branch target.
+ * 
+ * @param function The function to optimize
+ * @return The number of superinstructions emitted
+ */
+u32 FuseSuperinstructions(Function *function);
+
+/**
+ * @brief Rewrites the system calls that only compute on the stack into their opcodes, the branch offsets are relocated
+ * and the body size is updated. Unlike the fusion it does not depend on the options, a function whose only calls are 
+ * promoted ones stays a leaf.
+ * 
+ * @param function The function to rewrite
+ * @return The number of system calls promoted
+ */
+u32 PromoteSyscalls(Function *function);
+
+/**
+ * @brief Writes the fused form of a function body in a separate buffer, the function is left untouched. 
+ * This is the pass FuseSuperinstructions applies in place, the tiering uses it to build the body of a hot function.
+ * 
+ * @param function The function to optimize
+ * @param code The buffer that receives the fused body, at least as big as the function body
+ * @param size Set to the size in bytes of the fused body
+ * @param offsets If not NULL, receives for every branch target of the original body its position in the fused body, 
+ * it must hold Header.Size + 1 entries
+ * @return The number of superinstructions emitted, 0 if nothing was fused
+ */
+u32 FuseBody(const Function *function, u8 *code, u32 *size, u32 *offsets);
+
+/**
+ * @brief Translates a validated function to the register form run by ExecuteRegister, the operands of the register 
+ * instructions name the slots of the frame that hold the values instead of passing them through the stack.
+ * 
+ * A function is not translated if it uses an instruction the register form does not support (references to locals, 
+ * indirect calls, the byte, hword and multiple words instructions, swaps), or if its frame does not fit in 256 slots.
+ * 
+ * @param function The function to translate
+ * @param body Set to the register body, allocated with malloc
+ * @param size Set to the size in bytes of the register body
+ * @return The number of register instructions emitted, 0 if the function cannot be translated
+ */
+u32 TranslateToRegisters(const Function *function, u8 **body, u32 *size);
+
+/**
+ * @brief Pre-decodes the register form of a function to the threaded code run by ExecuteThreaded, every instruction
+ * becomes the address of its handler followed by its operands widened to cells, so the dispatch is a single indirect 
+ * jump and the operands need no decoding. The jumps point to the cells of their targets.
+ * 
+ * @param function The function to thread, it must have been translated to the register form
+ * @param handlers The handlers of the threaded code indexed by the register opcodes, see ThreadedHandlers
+ * @param code The buffer that receives the threaded code, if NULL the cells are only counted
+ * @return The number of cells of the threaded code
+ */
+u32 ThreadFunction(const Function *function, const void *const *handlers, Cell *code);
\ No newline at end of file
@@ -0,0 +1,197 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "linker.h"
+#include "interpreter/interpreter.h"
+
+/*
+    The threaded code is the register form pre-decoded for ExecuteThreaded, every instruction becomes the address of its
+    handler followed by a cell for each operand of the register instruction:
+    s           a slot becomes its byte offset from the frame pointer
+    i u         the immediates are widened to 64 bits
+    w W d D     the pool indices become the constants
+    c C g G f   the pool indices become the addresses of the strings, globals and functions
+    o           the jump offset becomes the address of the cell of the target
+
+    The pushes of immediates, constants, strings, globals and functions are all run by the handlers of OP_PUSH_I32 d v
+    and OP_PUSH_I64 d v, the value is in the cell after the slot, the pushes without operands get it from the opcode.
+    The third operand of LOAD_OFST_X and STORE_OFST_X is a word offset and is widened like a slot.
+*/
+
+static const ch8 *const sOperands[256] =
+{
+    [OP_PUSH_0_WORD ... OP_PUSH_F64_2] = "s",
+    [OP_PUSH_I32]            = "si",
+    [OP_PUSH_I64]            = "si",
+    [OP_PUSH_CONST_WORD]     = "sw",
+    [OP_PUSH_CONST_WORD_W]   = "sW",
+    [OP_PUSH_CONST_DWORD]    = "sd",
+    [OP_PUSH_CONST_DWORD_W]  = "sD",
+    [OP_PUSH_CONST_STR]      = "sc",
+    [OP_PUSH_CONST_STR_W]    = "sC",
+    [OP_PUSH_GLOB_REF]       = "sg",
+    [OP_PUSH_GLOB_REF_W]     = "sG",
+    [OP_PUSH_FUNC]           = "sf",
+    [OP_LOAD_GLOB_WORD]      = "sg",
+    [OP_LOAD_GLOB_DWORD]     = "sg",
+    [OP_POP_WORD]            = "ss",
+    [OP_POP_DWORD]           = "ss",
+
+    [OP_ADD_I32 ... OP_ADD_F64] = "sss",
+    [OP_INC_I32 ... OP_INC_F64] = "su",
+    [OP_SUB_I32 ... OP_SUB_F64] = "sss",
+    [OP_DEC_I32 ... OP_DEC_F64] = "su",
+    [OP_MUL_I32 ... OP_REM_U64] = "sss",
+    [OP_NEG_I32 ... OP_NEG_F64] = "ss",
+    [OP_NOT_WORD]               = "ss",
+    [OP_NOT_DWORD]              = "ss",
+    [OP_AND_WORD ... OP_SHR_U64] = "sss",
+
+    [OP_I32_TO_I8 ... OP_F64_TO_F32] = "ss",
+    [OP_CMP_WORD_EQ ... OP_CMP_F64_LE] = "sss",
+    [OP_CMP_NOT] = "ss",
+
+    [OP_LOAD_WORD]        = "ss",
+    [OP_LOAD_DWORD]       = "ss",
+    [OP_STORE_WORD]       = "ss",
+    [OP_STORE_DWORD]      = "ss",
+    [OP_LOAD_OFST_WORD]   = "sss",
+    [OP_LOAD_OFST_DWORD]  = "sss",
+    [OP_STORE_OFST_WORD]  = "sss",
+    [OP_STORE_OFST_DWORD] = "sss",
+
+    [OP_JMP]     = "o",
+    [OP_JMP_IF]  = "so",
+    [OP_CALL]    = "sf",
+    [OP_TAILCALL] = "sf",
+    [OP_SYSCALL] = "su",
+    [OP_RET]     = "s",
+
+    [OP_SQRT_F32 ... OP_LOG_F64] = "ss",
+    [OP_MEMMOV]                  = "sss",
+    [OP_MEMCPY]                  = "sss",
+
+    [OP_ADD_I32_LOC_IMM] = "sis",
+    [OP_ADD_I32_LOC_LOC] = "sss",
+    [OP_JMP_WORD_EQ ... OP_JMP_I32_LE] = "sso",
+};
+
+static inline u32 iOperandSize(ch8 operand)
+{
+    return operand == 'W' || operand == 'D' || operand == 'C' || operand == 'G' || operand == 'f' || operand == 'o' ? 2 : 1;
+}
+static inline u16 iRead16(const u8 *p) { return (u16)(p[0] | (p[1] << 8)); }
+
+/**
+ * Returns the opcode of the handler that runs a register instruction.
+ */
+static u8 iHandler(u8 opcode)
+{
+    switch (opcode)
+    {
+    case OP_PUSH_0_WORD ... OP_PUSH_I32_2:
+    case OP_PUSH_F32_1:
+    case OP_PUSH_F32_2:
+    case OP_PUSH_I32:
+    case OP_PUSH_CONST_WORD:
+    case OP_PUSH_CONST_WORD_W:
+        return OP_PUSH_I32;
+    case OP_PUSH_0_DWORD ... OP_PUSH_I64_2:
+    case OP_PUSH_F64_1:
+    case OP_PUSH_F64_2:
+    case OP_PUSH_I64:
+    case OP_PUSH_CONST_DWORD:
+    case OP_PUSH_CONST_DWORD_W:
+    case OP_PUSH_CONST_STR:
+    case OP_PUSH_CONST_STR_W:
+    case OP_PUSH_GLOB_REF:
+    case OP_PUSH_GLOB_REF_W:
+    case OP_PUSH_FUNC:
+        return OP_PUSH_I64;
+    default:
+        return opcode;
+    }
+}
+/**
+ * Writes the value of a push without operands if value is not NULL, returns false if the instruction is not one.
+ */
+static bool iImplicitValue(u8 opcode, Cell *value)
+{
+    Cell v = { .UInt = 0 };
+    switch (opcode)
+    {
+    case OP_PUSH_0_WORD ... OP_PUSH_I32_2:  v.Word  = IntToWord(opcode - OP_PUSH_0_WORD);   break;
+    case OP_PUSH_0_DWORD ... OP_PUSH_I64_2: v.DWord = IntToDWord(opcode - OP_PUSH_0_DWORD); break;
+    case OP_PUSH_F32_1: v.Word  = FloatToWord(1.0f); break;
+    case OP_PUSH_F32_2: v.Word  = FloatToWord(2.0f); break;
+    case OP_PUSH_F64_1: v.DWord = FloatToDWord(1.0); break;
+    case OP_PUSH_F64_2: v.DWord = FloatToDWord(2.0); break;
+    default:            return false;
+    }
+    if(value)
+        *value = v;
+    return true;
+}
+
+u32 ThreadFunction(const Function *function, const void *const *handlers, Cell *code)
+{
+    const ModuleTable *mt = function->Header.MT;
+    const u8 *body = function->Header.RegisterBody;
+    u32 size = function->Header.RegisterSize;
+
+    // the jumps need the cells of the instructions that follow them
+    u32 *cellAt = malloc((size + 1) * sizeof(u32));
+    u32 cells = 0;
+    for (u32 position = 0; position < size;)
+    {
+        const ch8 *operands = sOperands[body[position]];
+        if(!operands)
+        {
+            DEVEL_ASSERT(false, "Instruction not supported by the threaded code in function %s [opcode=%u]\n", function->Header.Signature, body[position]);
+            free(cellAt);
+            return 0;
+        }
+
+        cellAt[position] = cells;
+        cells += 1 + strlen(operands) + iImplicitValue(body[position], NULL);
+        position += 1;
+        for (u32 i = 0; operands[i]; i++)
+            position += iOperandSize(operands[i]);
+    }
+    cellAt[size] = cells;
+
+    for (u32 position = 0; code && position < size;)
+    {
+        u8 opcode = body[position];
+        const ch8 *operands = sOperands[opcode];
+        const u8  *p    = body + position + 1;
+        Cell      *cell = code + cellAt[position];
+
+        (cell++)->Handler = handlers[iHandler(opcode)];
+        for (u32 i = 0; operands[i]; i++, cell++)
+        {
+            cell->UInt = 0;
+            switch (operands[i])
+            {
+            case 's': cell->Offset = *p * SIZEOF_WORD; break;
+            case 'i': cell->Int    = (i8)*p;           break;
+            case 'u': cell->UInt   = *p;               break;
+            case 'w': cell->Word   = mt->WordPool[*p];          break;
+            case 'W': cell->Word   = mt->WordPool[iRead16(p)];  break;
+            case 'd': cell->DWord  = mt->DWordPool[*p];         break;
+            case 'D': cell->DWord  = mt->DWordPool[iRead16(p)]; break;
+            case 'c': cell->Ptr    = mt->StringPool[*p];          break;
+            case 'C': cell->Ptr    = mt->StringPool[iRead16(p)];  break;
+            case 'g': cell->Ptr    = mt->GlobalPool[*p];          break;
+            case 'G': cell->Ptr    = mt->GlobalPool[iRead16(p)];  break;
+            case 'f': cell->Ptr    = mt->FunctionPool[iRead16(p)]; break;
+            case 'o': cell->Target = code + cellAt[(p + 2 - body) + (i16)iRead16(p)]; break;
+            }
+            p += iOperandSize(operands[i]);
+        }
+        iImplicitValue(opcode, cell);
+        position = p - body;
+    }
+    free(cellAt);
+    return cells;
+}
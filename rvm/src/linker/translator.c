@@ -0,0 +1,618 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "linker.h"
+#include "interpreter/interpreter.h"
+
+/*
+    The register form keeps the opcodes of the stack form, the operands name slots of the frame instead of stack positions.
+    A slot is a word offset from the frame pointer, the locals start at slot 6 and the stack words follow the locals,
+    so the register interpreter uses the same frame layout as the stack interpreter.
+
+    Every register instruction is encoded as [opcode] [destination] [sources...] [parameters of the stack instruction],
+    the exceptions are:
+    POP_WORD/POP_DWORD d s       moves between slots
+    INC_X/DEC_X s v              the local index becomes a slot
+    ADD_I32_LOC_IMM s v d        the local indices become slots
+    ADD_I32_LOC_LOC a b d        the local indices become slots
+    STORE_X r v (o)              store the value in v through the reference in r
+    JMP o, JMP_IF c o            the offset is relative to the end of the instruction
+    JMP_WORD_EQ... a b o         compare and jump
+    CALL b f                     the arguments start at slot b, the results are written starting from slot b
+    TAILCALL b f                 the arguments start at slot b, the RET after it is kept for the engines that call
+    SYSCALL b f                  slot b is the stack pointer the system call works with
+    MEMMOV/MEMCPY d s n          the destination and source references and the size
+    RET s                        the results are read starting from slot s
+
+    Pushing a local emits nothing, the stack word remembers the slot that holds its value and is written back to its
+    own slot (its home) only when needed, at branches, calls and before the local is overwritten.
+*/
+
+#define NO_PRODUCER   UINT32_MAX
+#define UNKNOWN_DEPTH UINT32_MAX
+
+typedef struct _JumpFix
+{
+    u32 Position;  // position of the jump offset in the register body
+    u32 OldTarget; // target of the jump in the stack body
+} JumpFix;
+
+typedef struct _Translator
+{
+    u8  *Code;
+    u32  Size;
+    u32  Capacity;
+    u32  Instructions;
+    u32  Base;      // slot of the first stack word
+    u32  Depth;     // stack depth in words
+    u16 *Location;  // slot that holds each stack word
+    u32  LastStart; // position of the last instruction if it produced the words at the top of the stack
+    u32  LastDepth; // depth of the first word produced by the last instruction
+    u32  LastWords; // words produced by the last instruction
+} Translator;
+
+static void iEmit(Translator *t, u8 byte)
+{
+    if(t->Size == t->Capacity)
+    {
+        t->Capacity *= 2;
+        t->Code = realloc(t->Code, t->Capacity);
+    }
+    t->Code[t->Size++] = byte;
+}
+static void iEmit16(Translator *t, u16 value)
+{
+    iEmit(t, value & 0xff);
+    iEmit(t, value >> 8);
+}
+static u32 iBegin(Translator *t, u8 opcode)
+{
+    u32 start = t->Size;
+    iEmit(t, opcode);
+    t->Instructions++;
+    t->LastStart = NO_PRODUCER;
+    return start;
+}
+static inline u16 iHome(const Translator *t, u32 depth) { return t->Base + depth; }
+static inline void iProduce(Translator *t, u32 start, u32 words)
+{
+    t->LastStart = start;
+    t->LastDepth = t->Depth - words;
+    t->LastWords = words;
+}
+
+static void iFlushWord(Translator *t, u32 depth)
+{
+    if(t->Location[depth] == iHome(t, depth))
+        return;
+    iBegin(t, OP_POP_WORD);
+    iEmit(t, iHome(t, depth));
+    iEmit(t, t->Location[depth]);
+    t->Location[depth] = iHome(t, depth);
+}
+// writes back to their home every stack word starting from the given depth
+static void iFlush(Translator *t, u32 from)
+{
+    for (u32 d = from; d < t->Depth; d++)
+    {
+        if(t->Location[d] == iHome(t, d))
+            continue;
+        if(d + 1 < t->Depth && t->Location[d + 1] == t->Location[d] + 1)
+        {
+            iBegin(t, OP_POP_DWORD);
+            iEmit(t, iHome(t, d));
+            iEmit(t, t->Location[d]);
+            t->Location[d]     = iHome(t, d);
+            t->Location[d + 1] = iHome(t, d + 1);
+            d++;
+        }
+        else
+            iFlushWord(t, d);
+    }
+}
+// writes back the stack words that alias the slots about to be overwritten
+static void iWriteSlots(Translator *t, u16 slot, u32 words)
+{
+    for (u32 d = 0; d < t->Depth; d++)
+        if(t->Location[d] >= slot && t->Location[d] < slot + words)
+            iFlushWord(t, d);
+}
+static bool iAliased(const Translator *t, u16 slot, u32 words)
+{
+    for (u32 d = 0; d < t->Depth; d++)
+        if(t->Location[d] >= slot && t->Location[d] < slot + words)
+            return true;
+    return false;
+}
+// returns the slot of a value on the stack, a dword whose halves live apart is written back to its home
+static u16 iOperand(Translator *t, u32 depth, u32 words)
+{
+    if(words == 2 && t->Location[depth + 1] != t->Location[depth] + 1)
+    {
+        iFlushWord(t, depth);
+        iFlushWord(t, depth + 1);
+    }
+    return t->Location[depth];
+}
+static u16 iPushHome(Translator *t, u32 words)
+{
+    u16 slot = iHome(t, t->Depth);
+    for (u32 i = 0; i < words; i++, t->Depth++)
+        t->Location[t->Depth] = iHome(t, t->Depth);
+    return slot;
+}
+static void iPushAlias(Translator *t, u16 slot, u32 words)
+{
+    for (u32 i = 0; i < words; i++)
+        t->Location[t->Depth++] = slot + i;
+}
+static void iParameters(Translator *t, const u8 *instruction)
+{
+    for (u32 i = 1; i < InstructionSize(instruction); i++)
+        iEmit(t, instruction[i]);
+}
+// emits an instruction that pushes a value that does not come from the stack
+static void iImmediate(Translator *t, const u8 *instruction, u32 words)
+{
+    u16 d = iPushHome(t, words);
+    u32 start = iBegin(t, *instruction);
+    iEmit(t, d);
+    iParameters(t, instruction);
+    iProduce(t, start, words);
+}
+// emits an operation that pops the operands a and b (b on top, inB can be 0) and pushes the result
+static void iOperation(Translator *t, const u8 *instruction, u32 inA, u32 inB, u32 out)
+{
+    u32 depth = t->Depth - inA - inB;
+    u16 a = iOperand(t, depth, inA);
+    u16 b = inB ? iOperand(t, depth + inA, inB) : 0;
+    t->Depth = depth;
+    u16 d = iPushHome(t, out);
+    u32 start = iBegin(t, *instruction);
+    iEmit(t, d);
+    iEmit(t, a);
+    if(inB)
+        iEmit(t, b);
+    iParameters(t, instruction);
+    iProduce(t, start, out);
+}
+static void iStore(Translator *t, const u8 *instruction, u32 words)
+{
+    u32 depth = t->Depth - 2 - words;
+    u16 r = iOperand(t, depth, 2);
+    u16 v = iOperand(t, depth + 2, words);
+    t->Depth = depth;
+    iBegin(t, *instruction);
+    iEmit(t, r);
+    iEmit(t, v);
+    iParameters(t, instruction);
+}
+static void iPopLocal(Translator *t, u16 slot, u32 words)
+{
+    u32 depth = t->Depth - words;
+    if(t->Location[depth] == slot && (words == 1 || t->Location[depth + 1] == slot + 1))
+    {
+        t->Depth = depth;
+        return;
+    }
+
+    // the instruction that produced the value writes it directly in the local
+    if(t->LastStart != NO_PRODUCER && t->LastDepth == depth && t->LastWords == words &&
+       t->Location[depth] == iHome(t, depth) && !iAliased(t, slot, words))
+    {
+        t->Code[t->LastStart + 1] = slot;
+        t->LastStart = NO_PRODUCER;
+        t->Depth = depth;
+        return;
+    }
+
+    u16 s = iOperand(t, depth, words);
+    t->Depth = depth;
+    iWriteSlots(t, slot, words);
+    iBegin(t, words == 1 ? OP_POP_WORD : OP_POP_DWORD);
+    iEmit(t, slot);
+    iEmit(t, s);
+}
+static bool iBranch(Translator *t, u32 *depthAt, u32 target)
+{
+    if(depthAt[target] == UNKNOWN_DEPTH)
+        depthAt[target] = t->Depth;
+    return depthAt[target] == t->Depth;
+}
+
+static inline bool iIsJump(u8 opcode)
+{
+    return opcode == OP_JMP || opcode == OP_JMP_IF || (opcode >= OP_JMP_WORD_EQ && opcode <= OP_JMP_I32_LE);
+}
+static inline u32 iJumpTarget(const u8 *body, u32 position)
+{
+    i16 offset = *(i16*)(body + position + 1);
+    return (u32)((i32)position + 3 + offset);
+}
+// maps a compare to the compare that gives the opposite result, 0 if there is none
+static inline u8 iNegatedCompare(u8 opcode)
+{
+    switch (opcode)
+    {
+    case OP_CMP_WORD_EQ: return OP_CMP_WORD_NE;
+    case OP_CMP_WORD_NE: return OP_CMP_WORD_EQ;
+    case OP_CMP_I32_GT:  return OP_CMP_I32_LE;
+    case OP_CMP_I32_LE:  return OP_CMP_I32_GT;
+    case OP_CMP_I32_LT:  return OP_CMP_I32_GE;
+    case OP_CMP_I32_GE:  return OP_CMP_I32_LT;
+    case OP_CMP_U32_GT:  return OP_CMP_U32_LE;
+    case OP_CMP_U32_LE:  return OP_CMP_U32_GT;
+    case OP_CMP_U32_LT:  return OP_CMP_U32_GE;
+    case OP_CMP_U32_GE:  return OP_CMP_U32_LT;
+    default:             return 0;
+    }
+}
+// maps a compare to the conditional jump that fuses it with OP_JMP_IF, 0 if there is none
+static inline u8 iCompareJump(u8 opcode)
+{
+    switch (opcode)
+    {
+    case OP_CMP_WORD_EQ: return OP_JMP_WORD_EQ;
+    case OP_CMP_WORD_NE: return OP_JMP_WORD_NE;
+    case OP_CMP_I32_GT:  return OP_JMP_I32_GT;
+    case OP_CMP_I32_LT:  return OP_JMP_I32_LT;
+    case OP_CMP_I32_GE:  return OP_JMP_I32_GE;
+    case OP_CMP_I32_LE:  return OP_JMP_I32_LE;
+    default:             return 0;
+    }
+}
+static inline bool iProducedTop(const Translator *t, u32 words)
+{
+    return t->LastStart != NO_PRODUCER && t->LastDepth == t->Depth - words && t->LastWords == words &&
+           t->Location[t->LastDepth] == iHome(t, t->LastDepth);
+}
+
+/**
+ * Translates the body once, the depth at the branch targets is collected while walking, if a target that was skipped as
+ * unreachable gets a depth from a later branch the walk must be repeated.
+ */
+static bool iTranslate(Translator *t, const Function *function, u32 *depthAt, const bool *isTarget, bool *skipped,
+                       u32 *newOffsets, JumpFix *fixes, u32 *fixCount, bool *repeat)
+{
+    const u8 *body = function->Body;
+    u32 size = function->Header.Size;
+    bool reachable = true;
+    *fixCount = 0;
+    *repeat   = false;
+
+    for (u32 position = 0; position < size; position += InstructionSize(body + position))
+    {
+        const u8 *instruction = body + position;
+        u8 opcode = *instruction;
+
+        if(isTarget[position])
+        {
+            if(reachable)
+            {
+                iFlush(t, 0);
+                if(!iBranch(t, depthAt, position))
+                    return false;
+            }
+            else if(depthAt[position] != UNKNOWN_DEPTH)
+            {
+                reachable = true;
+                t->Depth = depthAt[position];
+                for (u32 d = 0; d < t->Depth; d++)
+                    t->Location[d] = iHome(t, d);
+            }
+            else
+                skipped[position] = true;
+            t->LastStart = NO_PRODUCER;
+        }
+        newOffsets[position] = t->Size;
+        if(!reachable)
+            continue;
+
+        switch (opcode)
+        {
+        case OP_PUSH_WORD:
+            iPushAlias(t, LOCALS_OFFSET + instruction[1], 1);
+            break;
+        case OP_PUSH_WORD_0: case OP_PUSH_WORD_1: case OP_PUSH_WORD_2: case OP_PUSH_WORD_3:
+            iPushAlias(t, LOCALS_OFFSET + opcode - OP_PUSH_WORD_0, 1);
+            break;
+        case OP_PUSH_DWORD:
+            iPushAlias(t, LOCALS_OFFSET + instruction[1], 2);
+            break;
+        case OP_PUSH_DWORD_0: case OP_PUSH_DWORD_1: case OP_PUSH_DWORD_2: case OP_PUSH_DWORD_3:
+            iPushAlias(t, LOCALS_OFFSET + opcode - OP_PUSH_DWORD_0, 2);
+            break;
+        case OP_PUSH_WORD_WORD:
+            iPushAlias(t, LOCALS_OFFSET + instruction[1], 1);
+            iPushAlias(t, LOCALS_OFFSET + instruction[2], 1);
+            break;
+
+        case OP_PUSH_0_WORD: case OP_PUSH_I32_1: case OP_PUSH_I32_2: case OP_PUSH_F32_1: case OP_PUSH_F32_2:
+        case OP_PUSH_I32: case OP_PUSH_CONST_WORD: case OP_PUSH_CONST_WORD_W: case OP_LOAD_GLOB_WORD:
+            iImmediate(t, instruction, 1);
+            break;
+        case OP_PUSH_0_DWORD: case OP_PUSH_I64_1: case OP_PUSH_I64_2: case OP_PUSH_F64_1: case OP_PUSH_F64_2:
+        case OP_PUSH_I64: case OP_PUSH_CONST_DWORD: case OP_PUSH_CONST_DWORD_W: case OP_PUSH_CONST_STR:
+        case OP_PUSH_CONST_STR_W: case OP_PUSH_GLOB_REF: case OP_PUSH_GLOB_REF_W: case OP_PUSH_FUNC: case OP_LOAD_GLOB_DWORD:
+            iImmediate(t, instruction, 2);
+            break;
+
+        case OP_POP_WORD:
+            iPopLocal(t, LOCALS_OFFSET + instruction[1], 1);
+            break;
+        case OP_POP_WORD_0: case OP_POP_WORD_1: case OP_POP_WORD_2: case OP_POP_WORD_3:
+            iPopLocal(t, LOCALS_OFFSET + opcode - OP_POP_WORD_0, 1);
+            break;
+        case OP_POP_DWORD:
+            iPopLocal(t, LOCALS_OFFSET + instruction[1], 2);
+            break;
+        case OP_POP_DWORD_0: case OP_POP_DWORD_1: case OP_POP_DWORD_2: case OP_POP_DWORD_3:
+            iPopLocal(t, LOCALS_OFFSET + opcode - OP_POP_DWORD_0, 2);
+            break;
+
+        case OP_ADD_I32: case OP_ADD_F32: case OP_SUB_I32: case OP_SUB_F32:
+        case OP_MUL_I32: case OP_MUL_U32: case OP_MUL_F32: case OP_DIV_I32: case OP_DIV_U32: case OP_DIV_F32:
+        case OP_REM_I32: case OP_REM_U32: case OP_AND_WORD: case OP_OR_WORD: case OP_XOR_WORD:
+        case OP_SHL_WORD: case OP_SHR_I32: case OP_SHR_U32:
+        case OP_CMP_WORD_EQ: case OP_CMP_WORD_NE: case OP_CMP_I32_GT: case OP_CMP_U32_GT: case OP_CMP_F32_GT:
+        case OP_CMP_I32_LT: case OP_CMP_U32_LT: case OP_CMP_F32_LT: case OP_CMP_I32_GE: case OP_CMP_U32_GE:
+        case OP_CMP_F32_GE: case OP_CMP_I32_LE: case OP_CMP_U32_LE: case OP_CMP_F32_LE:
+            iOperation(t, instruction, 1, 1, 1);
+            break;
+        case OP_ADD_I64: case OP_ADD_F64: case OP_SUB_I64: case OP_SUB_F64:
+        case OP_MUL_I64: case OP_MUL_U64: case OP_MUL_F64: case OP_DIV_I64: case OP_DIV_U64: case OP_DIV_F64:
+        case OP_REM_I64: case OP_REM_U64: case OP_AND_DWORD: case OP_OR_DWORD: case OP_XOR_DWORD:
+        case OP_SHL_DWORD: case OP_SHR_I64: case OP_SHR_U64:
+        case OP_CMP_DWORD_EQ: case OP_CMP_DWORD_NE: case OP_CMP_I64_GT: case OP_CMP_U64_GT: case OP_CMP_F64_GT:
+        case OP_CMP_I64_LT: case OP_CMP_U64_LT: case OP_CMP_F64_LT: case OP_CMP_I64_GE: case OP_CMP_U64_GE:
+        case OP_CMP_F64_GE: case OP_CMP_I64_LE: case OP_CMP_U64_LE: case OP_CMP_F64_LE:
+            iOperation(t, instruction, 2, 2, 2);
+            break;
+        case OP_CMP_NOT:
+            if(iProducedTop(t, 1) && iNegatedCompare(t->Code[t->LastStart]))
+                t->Code[t->LastStart] = iNegatedCompare(t->Code[t->LastStart]);
+            else
+                iOperation(t, instruction, 1, 0, 1);
+            break;
+        case OP_NEG_I32: case OP_NEG_F32: case OP_NOT_WORD: case OP_SQRT_F32: case OP_EXP_F32: case OP_LOG_F32:
+        case OP_I32_TO_I8: case OP_I32_TO_I16: case OP_I32_TO_F32: case OP_F32_TO_I32:
+            iOperation(t, instruction, 1, 0, 1);
+            break;
+        case OP_NEG_I64: case OP_NEG_F64: case OP_NOT_DWORD: case OP_I64_TO_F64: case OP_F64_TO_I64:
+        case OP_SQRT_F64: case OP_EXP_F64: case OP_LOG_F64:
+        case OP_LOAD_DWORD: case OP_LOAD_OFST_DWORD:
+            iOperation(t, instruction, 2, 0, 2);
+            break;
+        case OP_I32_TO_I64: case OP_I32_TO_F64: case OP_F32_TO_I64: case OP_F32_TO_F64:
+            iOperation(t, instruction, 1, 0, 2);
+            break;
+        case OP_I64_TO_I32: case OP_I64_TO_F32: case OP_F64_TO_I32: case OP_F64_TO_F32:
+        case OP_LOAD_WORD: case OP_LOAD_OFST_WORD:
+            iOperation(t, instruction, 2, 0, 1);
+            break;
+        case OP_STORE_WORD: case OP_STORE_OFST_WORD:
+            iStore(t, instruction, 1);
+            break;
+        case OP_STORE_DWORD: case OP_STORE_OFST_DWORD:
+            iStore(t, instruction, 2);
+            break;
+
+        case OP_MEMMOV: case OP_MEMCPY:
+            {
+                u32 depth = t->Depth - 5;
+                u16 d = iOperand(t, depth, 2);
+                u16 s = iOperand(t, depth + 2, 2);
+                u16 n = iOperand(t, depth + 4, 1);
+                t->Depth = depth;
+                iBegin(t, opcode);
+                iEmit(t, d);
+                iEmit(t, s);
+                iEmit(t, n);
+            }
+            break;
+
+        case OP_INC_I32: case OP_INC_F32: case OP_DEC_I32: case OP_DEC_F32:
+        case OP_INC_I64: case OP_INC_F64: case OP_DEC_I64: case OP_DEC_F64:
+            {
+                u16 slot = LOCALS_OFFSET + instruction[1];
+                bool dword = opcode == OP_INC_I64 || opcode == OP_INC_F64 || opcode == OP_DEC_I64 || opcode == OP_DEC_F64;
+                iWriteSlots(t, slot, dword ? 2 : 1);
+                iBegin(t, opcode);
+                iEmit(t, slot);
+                iEmit(t, instruction[2]);
+            }
+            break;
+        case OP_ADD_I32_LOC_IMM: case OP_ADD_I32_LOC_LOC:
+            {
+                u16 slot = LOCALS_OFFSET + instruction[3];
+                iWriteSlots(t, slot, 1);
+                iBegin(t, opcode);
+                iEmit(t, LOCALS_OFFSET + instruction[1]);
+                iEmit(t, opcode == OP_ADD_I32_LOC_IMM ? instruction[2] : LOCALS_OFFSET + instruction[2]);
+                iEmit(t, slot);
+            }
+            break;
+
+        case OP_DUP_WORD:
+            iPushAlias(t, t->Location[t->Depth - 1], 1);
+            break;
+        case OP_DUP_DWORD:
+            iPushAlias(t, iOperand(t, t->Depth - 2, 2), 2);
+            break;
+
+        case OP_JMP:
+            iFlush(t, 0);
+            if(!iBranch(t, depthAt, iJumpTarget(body, position)))
+                return false;
+            iBegin(t, OP_JMP);
+            fixes[(*fixCount)++] = (JumpFix) { t->Size, iJumpTarget(body, position) };
+            iEmit16(t, 0);
+            reachable = false;
+            break;
+        case OP_JMP_IF:
+            {
+                u8 jump = iProducedTop(t, 1) ? iCompareJump(t->Code[t->LastStart]) : 0;
+                u16 a, b = 0;
+                if(jump)
+                {
+                    // the compare and the jump become a single instruction
+                    a = t->Code[t->LastStart + 2];
+                    b = t->Code[t->LastStart + 3];
+                    t->Size = t->LastStart;
+                    t->Instructions--;
+                }
+                else
+                    a = t->Location[t->Depth - 1];
+                t->Depth -= 1;
+                iFlush(t, 0);
+                if(!iBranch(t, depthAt, iJumpTarget(body, position)))
+                    return false;
+                iBegin(t, jump ? jump : OP_JMP_IF);
+                iEmit(t, a);
+                if(jump)
+                    iEmit(t, b);
+                fixes[(*fixCount)++] = (JumpFix) { t->Size, iJumpTarget(body, position) };
+                iEmit16(t, 0);
+            }
+            break;
+        case OP_JMP_WORD_EQ: case OP_JMP_WORD_NE: case OP_JMP_I32_GT: case OP_JMP_I32_LT: case OP_JMP_I32_GE: case OP_JMP_I32_LE:
+            {
+                u16 a = iOperand(t, t->Depth - 2, 1);
+                u16 b = iOperand(t, t->Depth - 1, 1);
+                t->Depth -= 2;
+                iFlush(t, 0);
+                if(!iBranch(t, depthAt, iJumpTarget(body, position)))
+                    return false;
+                iBegin(t, opcode);
+                iEmit(t, a);
+                iEmit(t, b);
+                fixes[(*fixCount)++] = (JumpFix) { t->Size, iJumpTarget(body, position) };
+                iEmit16(t, 0);
+            }
+            break;
+        case OP_CALL:
+        case OP_TAILCALL:
+            {
+                u16 f = *(u16*)(instruction + 1);
+                const FunctionHeader *callee = &function->Header.MT->FunctionPool[f]->Header;
+                iFlush(t, 0);
+                t->Depth -= callee->AWC;
+                iBegin(t, opcode);
+                iEmit(t, iHome(t, t->Depth));
+                iEmit16(t, f);
+                iPushHome(t, callee->RWC);
+            }
+            break;
+        case OP_SYSCALL:
+            {
+                u8 f = instruction[1];
+                i32 offset = SyscallStackOffset(f);
+                iFlush(t, 0);
+                iBegin(t, OP_SYSCALL);
+                iEmit(t, iHome(t, t->Depth));
+                iEmit(t, f);
+                if(offset < 0)
+                    t->Depth += offset;
+                else
+                    iPushHome(t, offset);
+                if(f == OP_SYS_EXIT)
+                    reachable = false;
+            }
+            break;
+        case OP_RET:
+            {
+                u16 rwc = function->Header.RWC;
+                u16 s = 0;
+                if(rwc == 1 || rwc == 2)
+                    s = iOperand(t, t->Depth - rwc, rwc);
+                else if(rwc > 2)
+                {
+                    iFlush(t, t->Depth - rwc);
+                    s = iHome(t, t->Depth - rwc);
+                }
+                iBegin(t, OP_RET);
+                iEmit(t, s);
+                reachable = false;
+            }
+            break;
+        default:
+            return false;
+        }
+    }
+
+    // a target skipped as unreachable has been reached later by a backward branch
+    for (u32 position = 0; position < size; position++)
+    {
+        if(skipped[position] && depthAt[position] != UNKNOWN_DEPTH)
+            *repeat = true;
+        skipped[position] = false;
+    }
+    return true;
+}
+
+u32 TranslateToRegisters(const Function *function, u8 **body, u32 *size)
+{
+    const u8 *code = function->Body;
+    u32 codeSize = function->Header.Size;
+    u32 base = FRAME_HEADER(LOCALS_OFFSET, function->Header.LWC) + FRAME_HEADER_SIZE;
+    *body = NULL;
+    *size = 0;
+    // the slots must fit in a byte
+    if(base + function->Header.SWC > UINT8_MAX)
+        return 0;
+
+    u32  *depthAt    = malloc((codeSize + 1) * sizeof(u32));
+    u32  *newOffsets = malloc((codeSize + 1) * sizeof(u32));
+    bool *isTarget   = calloc(codeSize + 1, sizeof(bool));
+    bool *skipped    = calloc(codeSize + 1, sizeof(bool));
+    JumpFix *fixes   = malloc((codeSize + 1) * sizeof(JumpFix));
+    Translator t;
+    t.Location = malloc((function->Header.SWC + 1) * sizeof(u16));
+    t.Capacity = codeSize + 16;
+    t.Code     = malloc(t.Capacity);
+    u32 translated = 0;
+
+    for (u32 position = 0; position <= codeSize; position++)
+        depthAt[position] = UNKNOWN_DEPTH;
+    for (u32 position = 0; position < codeSize; position += InstructionSize(code + position))
+        if(iIsJump(code[position]))
+            isTarget[iJumpTarget(code, position)] = true;
+
+    u32 fixCount = 0;
+    bool repeat  = true;
+    while (repeat)
+    {
+        t.Size = 0;
+        t.Instructions = 0;
+        t.Base  = base;
+        t.Depth = 0;
+        t.LastStart = NO_PRODUCER;
+        if(!iTranslate(&t, function, depthAt, isTarget, skipped, newOffsets, fixes, &fixCount, &repeat))
+            goto RET;
+    }
+    newOffsets[codeSize] = t.Size;
+
+    for (u32 i = 0; i < fixCount; i++)
+    {
+        if(depthAt[fixes[i].OldTarget] == UNKNOWN_DEPTH)
+            goto RET;
+        i32 offset = (i32)newOffsets[fixes[i].OldTarget] - (i32)(fixes[i].Position + 2);
+        if(offset < INT16_MIN || offset > INT16_MAX)
+            goto RET;
+        *(i16*)(t.Code + fixes[i].Position) = (i16)offset;
+    }
+
+    *body = t.Code;
+    *size = t.Size;
+    t.Code = NULL;
+    translated = t.Instructions;
+RET:
+    free(t.Code);
+    free(t.Location);
+    free(depthAt);
+    free(newOffsets);
+    free(isTarget);
+    free(skipped);
+    free(fixes);
+    return translated;
+}
@@ -1,9 +1,180 @@
+#include <stdlib.h>
+
 #include "linker.h"
 #include "raiu/assert.h"
 #include "raiu/log.h"
 
+static const i32 sInstructionsFixedParameterSizes[] = 
+{
+    0, // exit
+    // push loc
+    1, 1, 1, 1, // push byte
+    1, 1, // push hword
+    1, 0, 0, 0, 0, // push word
+    1, 0, 0, 0, 0, // push dword
+    2, // push words
+    1, // push ref
+    // push imm
+    0, 0, 0, // push i32
+    0, 0, 0, // pusg i64
+    0, 0, // push f32
+    0, 0, // push f64
+    1, 1, // push i8 as 
+    1, 2, // push const word
+    1, 2, // push const dword
+    1, 2, // push const string
+    1, 2, // push glob ref
+    2, // push func 
+    // pop locals
+    1, 1, 1, 1, // pop byte
+    1, 1, // pop hword
+    1, 0, 0, 0, 0, // pop word
+    1, 0, 0, 0, 0, // pop dword
+    2, // pop words
+    // arithmetic
+    0, 0, 0, 0, // add
+    2, 2, 2, 2, // inc
+    0, 0, 0, 0, // sub
+    2, 2, 2, 2, // dec
+    0, 0, 0, 0, 0, 0, // mul
+    0, 0, 0, 0, 0, 0, // div
+    0, 0, 0, 0, // rem
+    0, 0, 0, 0, // neg 
+    // bitwise
+    0, 0, // not
+    0, 0, // and
+    0, 0, // or
+    0, 0, // xor
+    0, 0, // shl
+    0, 0, 0, 0, // shr
+    // casts
+    0, 0, 0, 0, 0, // form i32
+    0, 0, 0, // from i64
+    0, 0, 0, // from i32
+    0, 0, 0, // from f64
+    // compare
+    0, 0, 0, 0, // eq ne
+    0, 0, 0, 0, 0, 0, // gt
+    0, 0, 0, 0, 0, 0, // lt
+    0, 0, 0, 0, 0, 0, // ge
+    0, 0, 0, 0, 0, 0, // le
+    0, // not
+    // stack manipulation
+    0, 0, 0, 0, 0, 0, //dup
+    0, 0, // swap
+    // load&store
+    0, 0, 0, 0, // load byte
+    0, 0, // load hword
+    0, // load word
+    0, // load dword
+    1, // load dwords
+    0, 0, 0, 0, // store byte
+    0, 0, // store hword
+    0, // store word
+    0, // store dword
+    1, // store words
+    
+    // load&store offset
+    1, 1, 1, 1, // load byte
+    1, 1, // load hword
+    1, // load word
+    1, // load dword
+    2, // load dwords
+    1, 1, 1, 1, // store byte
+    1, 1, // store hword
+    1, // store word
+    1, // store dword
+    2, // store words
+    // load&store buffer
+    0, 0, 0, 0, 1, // load val
+    0, 0, 0, 0, 1, // load ref
+    0, 0, 0, 0, 1, // store val
+    
+    // mem
+    0, 0,
+    // flow
+    2, 2, // jump
+    2, 0, 1, // call
+    0, // ret
+    // superinstructions
+    1, 1, // load glob
+    2, // push word word
+    3, 3, // add i32 loc
+    2, 2, 2, 2, 2, 2, // jump cmp
+    // quickened calls
+    2, 2, // call
+    0, // ret
+    // math
+    0, 0, 0, 0, 0, 0,
+    // mem
+    0, 0,
+    // tail calls
+    2, 0,
+    // generators
+    2, 2, 0, 0,
+    // thread-local globals
+    1, 2,
+};
+static_assert(sizeof(sInstructionsFixedParameterSizes) / sizeof(i32) == OP_MAX_OPCODE + 1, "Missing parameter sizes!");
 
-i32 Validate(const Function *function, const u8 *instruction, i32 sp)
+// the parameters of the extended page, they follow the opcode after the prefix
+static const i32 sExtendedFixedParameterSizes[] = 
+{
+    // bit counts
+    0, 0, // popcnt
+    0, 0, // clz
+    0, 0, // ctz
+    // atomics
+    0, 0, // load
+    0, 0, // store
+    0, 0, // cas
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, // fetch add, sub, and, or, xor
+    0, // fence
+};
+static_assert(sizeof(sExtendedFixedParameterSizes) / sizeof(i32) == OP_EXT_MAX_OPCODE + 1, "Missing extended parameter sizes!");
+
+static const i32 sSysfnStackOffsets[] = 
+{
+    -1,
+    -2, -2, -2,
+    -3, +2, +2,
+    -5, -5,
+    +2,
+    0, 0, 0, 0, 0, 0,
+    -2, -1, 0,
+    -4
+};
+static_assert(sizeof(sSysfnStackOffsets) / sizeof(i32) == OP_SYS_MAX_OPCODE + 1, "Missing system call stack offsets!");
+
+u32 InstructionSize(const u8 *instruction)
+{
+    // an invalid extended opcode is left to the validator
+    if(*instruction == OP_EXTENDED)
+        return (instruction[1] <= OP_EXT_MAX_OPCODE ? sExtendedFixedParameterSizes[instruction[1]] : 0) + 2;
+    return sInstructionsFixedParameterSizes[*instruction] + 1;
+}
+u32 CheckedInstructionSize(const Function *function, u32 position)
+{
+    const u8 *body = function->Body;
+    u32 size = function->Header.Size;
+    if(position >= size || body[position] == 0 || (body[position] > OP_MAX_OPCODE && body[position] != OP_EXTENDED))
+        return 0;
+    if(body[position] == OP_EXTENDED && (position + 1 >= size || body[position + 1] > OP_EXT_MAX_OPCODE))
+        return 0;
+    u32 n = InstructionSize(body + position);
+    return position + n <= size ? n : 0;
+}
+i32 SyscallStackOffset(u8 syscall)
+{
+    return sSysfnStackOffsets[syscall];
+}
+// a tail call keeps the return after it, the engines that do not reuse the frame run it
+static bool iFollowedByReturn(const Function *function, const u8 *next)
+{
+    return next < function->Body + function->Header.Size && *next == OP_RET;
+}
+
+i32 Validate(Function *function, const u8 *instruction, i32 sp)
 {
     static const i32 sInstructionsStackOffsets[] = 
     {
@@ -43,11 +214,11 @@ i32 Validate(const Function *function, const u8 *instruction, i32 sp)
         0, 0, 0, 0, // neg 
         // bitwise
         0, 0, // not
-        1, 2, // and
-        1, 2, // or
-        1, 2, // xor
-        1, 1, // shl
-        1, 1, 1, 1, // shr
+        -1, -2, // and
+        -1, -2, // or
+        -1, -2, // xor
+        -1, -2, // shl
+        -1, -2, -1, -2, // shr
         // casts
         0, 0, 1, 0, 1, // form i32
         -1, -1, 0, // from i64
@@ -96,109 +267,40 @@ i32 Validate(const Function *function, const u8 *instruction, i32 sp)
         0, -1, // jump
         INT32_MIN, INT32_MIN, INT32_MIN, // call
         INT32_MIN, // ret
-    };
-    static const i32 sInstructionsFixedParameterSizes[] = 
-    {
-        0, // exit
-        // push loc
-        1, 1, 1, 1, // push byte
-        1, 1, // push hword
-        1, 0, 0, 0, 0, // push word
-        1, 0, 0, 0, 0, // push dword
-        2, // push words
-        1, // push ref
-        // push imm
-        0, 0, 0, // push i32
-        0, 0, 0, // pusg i64
-        0, 0, // push f32
-        0, 0, // push f64
-        1, 1, // push i8 as 
-        1, 2, // push const word
-        1, 2, // push const dword
-        1, 2, // push const string
-        1, 2, // push glob ref
-        2, // push func 
-        // pop locals
-        1, 1, 1, 1, // pop byte
-        1, 1, // pop hword
-        1, 0, 0, 0, 0, // pop word
-        1, 0, 0, 0, 0, // pop dword
-        2, // pop words
-        // arithmetic
-        0, 0, 0, 0, // add
-        2, 2, 2, 2, // inc
-        0, 0, 0, 0, // sub
-        2, 2, 2, 2, // dec
-        0, 0, 0, 0, 0, 0, // mul
-        0, 0, 0, 0, 0, 0, // div
-        0, 0, 0, 0, // rem
-        0, 0, 0, 0, // neg 
-        // bitwise
-        0, 0, // not
-        0, 0, // and
-        0, 0, // or
-        0, 0, // xor
-        0, 0, // shl
-        0, 0, 0, 0, // shr
-        // casts
-        0, 0, 0, 0, 0, // form i32
-        0, 0, 0, // from i64
-        0, 0, 0, // from i32
-        0, 0, 0, // from f64
-        // compare
-        0, 0, 0, 0, // eq ne
-        0, 0, 0, 0, 0, 0, // gt
-        0, 0, 0, 0, 0, 0, // lt
-        0, 0, 0, 0, 0, 0, // ge
-        0, 0, 0, 0, 0, 0, // le
-        0, // not
-        // stack manipulation
-        0, 0, 0, 0, 0, 0, //dup
-        0, 0, // swap
-        // load&store
-        0, 0, 0, 0, // load byte
-        0, 0, // load hword
-        0, // load word
-        0, // load dword
-        1, // load dwords
-        0, 0, 0, 0, // store byte
-        0, 0, // store hword
-        0, // store word
-        0, // store dword
-        1, // store words
-        
-        // load&store offset
-        1, 1, 1, 1, // load byte
-        1, 1, // load hword
-        1, // load word
-        1, // load dword
-        2, // load dwords
-        1, 1, 1, 1, // store byte
-        1, 1, // store hword
-        1, // store word
-        1, // store dword
-        2, // store words
-        // load&store buffer
-        0, 0, 0, 0, 1, // load val
-        0, 0, 0, 0, 1, // load ref
-        0, 0, 0, 0, 1, // store val
-        
+        // superinstructions
+        1, 2, // load glob
+        2, // push word word
+        0, 0, // add i32 loc
+        -2, -2, -2, -2, -2, -2, // jump cmp
+        // quickened calls
+        INT32_MIN, INT32_MIN, // call
+        INT32_MIN, // ret
+        // math
+        0, 0, 0, 0, 0, 0,
         // mem
-        0, 0,
-        // flow
-        0, 0, // jump
-        2, 0, 1, // call
-        0, // ret
+        -5, -5,
+        // tail calls
+        INT32_MIN, INT32_MIN,
+        // generators
+        INT32_MIN, INT32_MIN, INT32_MIN, INT32_MIN,
+        // thread-local globals
+        2, 2,
     };
-    static const i32 sSysfnStackOffsets[] = 
+    static_assert(sizeof(sInstructionsStackOffsets) / sizeof(i32) == OP_MAX_OPCODE + 1, "Missing stack offsets!");
+    static const i32 sExtendedStackOffsets[] = 
     {
-        -1,
-        -2, -2, -2,
-        -3, +2, +2,
-        -5, -5,
-        +2,
-        0, 0, 0, 0, 0, 0 
+        // bit counts
+        0, -1, // popcnt
+        0, -1, // clz
+        0, -1, // ctz
+        // atomics
+        -1, 0, // load
+        -3, -4, // store
+        -3, -4, // cas
+        -2, -2, -2, -2, -2, -2, -2, -2, -2, -2, // fetch add, sub, and, or, xor
+        0, // fence
     };
+    static_assert(sizeof(sExtendedStackOffsets) / sizeof(i32) == OP_EXT_MAX_OPCODE + 1, "Missing extended stack offsets!");
     
     if(function->Header.AWC > function->Header.LWC)
     {
@@ -211,28 +313,88 @@ i32 Validate(const Function *function, const u8 *instruction, i32 sp)
     const i32 *instrParamOffsets = sInstructionsFixedParameterSizes;
     const i32 *sysfnStackOffsets = sSysfnStackOffsets;
     if(!instruction)
+    {
+        // the passes after the validation walk the whole body, the code that no path reaches included
+        u32 size = function->Header.Size;
+        bool *starts = calloc(size + 1, sizeof(bool));
+        u32 position = 0;
+        u32 n;
+        while ((n = CheckedInstructionSize(function, position)) != 0)
+        {
+            starts[position] = true;
+            position += n;
+        }
+        if(position != size)
+        {
+            free(starts);
+            DEVEL_ASSERT(false, "Malformed instruction in function %s [position=%u]\n", function->Header.Signature, position);
+            return 1;
+        }
+        // the paths do not follow the unconditional jumps, every jump must land on an instruction of this decode
+        for (position = 0; position < size; position += InstructionSize(function->Body + position))
+        {
+            u8 op = function->Body[position];
+            if(op != OP_JMP && op != OP_JMP_IF && (op < OP_JMP_WORD_EQ || op > OP_JMP_I32_LE))
+                continue;
+            i32 target = (i32)position + 3 + *(i16*)(function->Body + position + 1);
+            if(target < 0 || (u32)target >= size || !starts[target])
+            {
+                free(starts);
+                DEVEL_ASSERT(false, "Jump out of the instructions of function %s [position=%u]\n", function->Header.Signature, position);
+                return 1;
+            }
+        }
+        free(starts);
         instruction = function->Body;
+    }
 
+    const u8 *bodyLimit = function->Body + function->Header.Size;
     bool exited = false;
     while (!exited)
     {
+        if(instruction < function->Body || instruction >= bodyLimit)
+        {
+            DEVEL_ASSERT(false, "Instruction out of the body of function %s!\n", function->Header.Signature);
+            return 1;
+        }
+
         opcode = *instruction;
-        if(opcode == 0 || opcode > OP_MAX_OPCODE)
+        if(opcode == 0 || (opcode > OP_MAX_OPCODE && opcode != OP_EXTENDED))
         {
             DEVEL_ASSERT(false, "Invalid instruction in function %s! [opcode=%u]\n", function->Header.Signature, opcode);
             return 1;
         }
 
-        if(opcode == OP_JMP_IF)
+        if(opcode == OP_JMP_IF || (opcode >= OP_JMP_WORD_EQ && opcode <= OP_JMP_I32_LE))
         {
-            u8 offset = instruction[1];
-            i32 branchIfTrueError = Validate(function, instruction + offset + 1, sp - 1);
-            if(branchIfTrueError)
-                return 1;
+            // backward branches close a loop and have already been walked by the linear path
+            i16 offset = *(i16*)(instruction + 1);
+            if(offset > 0)
+            {
+                i32 branchIfTrueError = Validate(function, instruction + 3 + offset, sp + instrStackOffsets[opcode]);
+                if(branchIfTrueError)
+                    return 1;
+            }
         }
     
-        i32 stackOffset = instrStackOffsets[opcode];
-        i32 paramOffset = instrParamOffsets[opcode]; 
+        i32 stackOffset = 0;
+        i32 paramOffset = 0;
+        if(opcode == OP_EXTENDED)
+        {
+            // the prefix counts as a parameter, the instructions of the extended page have no special cases
+            if(instruction + 1 >= bodyLimit || instruction[1] > OP_EXT_MAX_OPCODE)
+            {
+                DEVEL_ASSERT(false, "Invalid extended instruction in function %s!\n", function->Header.Signature);
+                return 1;
+            }
+            stackOffset = sExtendedStackOffsets[instruction[1]];
+            paramOffset = sExtendedFixedParameterSizes[instruction[1]] + 1;
+        }
+        else
+        {
+            stackOffset = instrStackOffsets[opcode];
+            paramOffset = instrParamOffsets[opcode];
+        }
         
         switch (opcode)
         {
@@ -271,6 +433,30 @@ i32 Validate(const Function *function, const u8 *instruction, i32 sp)
             }
             break;
         
+        case OP_PUSH_WORD_WORD:
+        case OP_ADD_I32_LOC_LOC:
+            {
+                u8 a = instruction[1];
+                u8 b = instruction[2];
+                u8 d = opcode == OP_ADD_I32_LOC_LOC ? instruction[3] : 0;
+                if(a >= function->Header.LWC || b >= function->Header.LWC || d >= function->Header.LWC)
+                {
+                    DEVEL_ASSERT(false, "Invalid local scope access in function %s [LWC=%u,l=%u,%u,%u]\n", function->Header.Signature, function->Header.LWC, a, b, d);
+                    return 1;
+                }
+            }
+            break;
+        case OP_ADD_I32_LOC_IMM:
+            {
+                u8 s = instruction[1];
+                u8 d = instruction[3];
+                if(s >= function->Header.LWC || d >= function->Header.LWC)
+                {
+                    DEVEL_ASSERT(false, "Invalid local scope access in function %s [LWC=%u,l=%u,%u]\n", function->Header.Signature, function->Header.LWC, s, d);
+                    return 1;
+                }
+            }
+            break;
         case OP_PUSH_CONST_WORD:
             {
                 u8 c = instruction[1];
@@ -332,6 +518,9 @@ i32 Validate(const Function *function, const u8 *instruction, i32 sp)
             }
             break;
         case OP_PUSH_GLOB_REF:
+        case OP_PUSH_TLS_REF:
+        case OP_LOAD_GLOB_WORD:
+        case OP_LOAD_GLOB_DWORD:
             {
                 u8 c = instruction[1];
                 if(c >= function->Header.MT->GlobalPoolSize)
@@ -342,6 +531,7 @@ i32 Validate(const Function *function, const u8 *instruction, i32 sp)
             }
             break;
         case OP_PUSH_GLOB_REF_W:
+        case OP_PUSH_TLS_REF_W:
             {
                 u16 c = *(u16*)(instruction + 1);
                 if(c >= function->Header.MT->GlobalPoolSize)
@@ -359,6 +549,12 @@ i32 Validate(const Function *function, const u8 *instruction, i32 sp)
                     DEVEL_ASSERT(false, "Invalid function pointer access in function %s [MAX=%u,c=%u]\n", function->Header.Signature, function->Header.MT->StringPoolSize, c);
                     return 1;
                 }
+                // the reference could be called with an indirect call, a spawn or a parallel loop
+                if(function->Header.MT->FunctionPool[c]->Header.Generator)
+                {
+                    DEVEL_ASSERT(false, "Reference to the generator function %s in function %s\n", function->Header.MT->FunctionPool[c]->Header.Signature, function->Header.Signature);
+                    return 1;
+                }
             }
             break;
         case OP_POP_WORDS:
@@ -432,14 +628,111 @@ i32 Validate(const Function *function, const u8 *instruction, i32 sp)
                     return 1;
                 }
                 Function *functionCalled = function->Header.MT->FunctionPool[f];            
+                if(functionCalled->Header.Generator)
+                {
+                    DEVEL_ASSERT(false, "Call of the generator function %s in function %s\n", functionCalled->Header.Signature, function->Header.Signature);
+                    return 1;
+                }
                 stackOffset = functionCalled->Header.RWC - functionCalled->Header.AWC;
+                function->Header.Leaf = false;
             }
             break;
         case OP_INDCALL:
             // cannot verify validity, validity is trusted
             stackOffset = 0;
             exited = true;
+            function->Header.Leaf = false;
             break;
+        case OP_TAILCALL:
+            {
+                u16 f = *(u16*)(instruction + 1);
+                if(f >= function->Header.MT->FunctionPoolSize)
+                {
+                    DEVEL_ASSERT(false, "Invalid function call in function %s [MAX=%u,f=%u]\n", function->Header.Signature, function->Header.MT->FunctionPoolSize, f);
+                    return 1;
+                }
+                // the callee returns straight to the caller of the function, in place of its results
+                const Function *functionCalled = function->Header.MT->FunctionPool[f];
+                if(functionCalled->Header.Generator)
+                {
+                    DEVEL_ASSERT(false, "Call of the generator function %s in function %s\n", functionCalled->Header.Signature, function->Header.Signature);
+                    return 1;
+                }
+                if(functionCalled->Header.RWC != function->Header.RWC)
+                {
+                    DEVEL_ASSERT(false, "Tail call with a different RWC in function %s [RWC=%u,callee=%u]\n", function->Header.Signature, function->Header.RWC, functionCalled->Header.RWC);
+                    return 1;
+                }
+                if(sp < functionCalled->Header.AWC || !iFollowedByReturn(function, instruction + 3))
+                {
+                    DEVEL_ASSERT(false, "Invalid tail call in function %s [AWC=%u,sp=%d]\n", function->Header.Signature, functionCalled->Header.AWC, sp);
+                    return 1;
+                }
+                // the engines that keep the call run the return after it, so it is walked like the one of a call
+                stackOffset = functionCalled->Header.RWC - functionCalled->Header.AWC;
+                function->Header.Leaf = false;
+            }
+            break;
+        case OP_INDTAILCALL:
+            if(!iFollowedByReturn(function, instruction + 1))
+            {
+                DEVEL_ASSERT(false, "Invalid tail call in function %s\n", function->Header.Signature);
+                return 1;
+            }
+            // cannot verify validity, validity is trusted
+            stackOffset = 0;
+            exited = true;
+            function->Header.Leaf = false;
+            break;
+        case OP_CALL_FUNC:
+        case OP_CALL_LEAF:
+        case OP_RET_LEAF:
+            DEVEL_ASSERT(false, "Quickened call in function %s, the calls are quickened after the validation\n", function->Header.Signature);
+            return 1;
+        case OP_GEN_NEW:
+        case OP_RESUME:
+            {
+                u16 f = *(u16*)(instruction + 1);
+                if(f >= function->Header.MT->FunctionPoolSize)
+                {
+                    DEVEL_ASSERT(false, "Invalid generator function in function %s [MAX=%u,f=%u]\n", function->Header.Signature, function->Header.MT->FunctionPoolSize, f);
+                    return 1;
+                }
+                // a new generator takes the arguments of the function, a resume takes the reference of the generator
+                const Function *generator = function->Header.MT->FunctionPool[f];
+                if(!generator->Header.Generator)
+                {
+                    DEVEL_ASSERT(false, "Resume of the function %s in function %s, it has no generators\n", generator->Header.Signature, function->Header.Signature);
+                    return 1;
+                }
+                i32 popped = opcode == OP_GEN_NEW ? generator->Header.AWC : 2;
+                if(sp < popped)
+                {
+                    DEVEL_ASSERT(false, "Invalid generator instruction in function %s [popped=%d,sp=%d]\n", function->Header.Signature, popped, sp);
+                    return 1;
+                }
+                stackOffset = opcode == OP_GEN_NEW ? 2 - popped : generator->Header.RWC + 1 - popped;
+                function->Header.Leaf = false;
+            }
+            break;
+        case OP_YIELD:
+            // the generator of the frame is under it only if a resume has pushed it
+            if(!function->Header.Generator)
+            {
+                DEVEL_ASSERT(false, "Yield in function %s, it is not the function of a generator\n", function->Header.Signature);
+                return 1;
+            }
+            if(sp < function->Header.RWC)
+            {
+                DEVEL_ASSERT(false, "Yield with missing values in function %s [RWC=%u,sp=%d]\n", function->Header.Signature, function->Header.RWC, sp);
+                return 1;
+            }
+            stackOffset = -function->Header.RWC;
+            function->Header.Leaf = false;
+            break;
+        case OP_GEN_RETURN:
+            DEVEL_ASSERT(false, "Generator return in function %s, it is not an instruction of the bodies\n", function->Header.Signature);
+            return 1;
         case OP_SYSCALL:
             {
                 u8 f = instruction[1];
@@ -452,6 +745,7 @@ i32 Validate(const Function *function, const u8 *instruction, i32 sp)
                 if(f == OP_SYS_EXIT)
                     exited = true;
                 stackOffset = sysfnStackOffsets[f];
+                function->Header.Leaf = false;
             }
             break;
         case OP_RET:
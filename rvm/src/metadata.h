@@ -1,8 +1,14 @@
 #pragma once
 
+#include <stdbool.h>
+#include <stdlib.h>
 #include "raiu/types.h"
 
 struct _Function;
+struct _Scheduler;
+struct _GreenThread;
+struct _WorkerPool;
+struct _ParallelLoop;
 
 /**
  * @brief The metatable of a module, contains all the pools associated to a module.
@@ -44,6 +50,19 @@ typedef struct _ModuleTable
  * @param LWC The Local Word Count of the function
  * @param SWC The Stack Word Count of the function
  * @param RWC The Return Word Count of the function
+ * @param Size The size in bytes of the function body
+ * @param RegisterBody The register form of the body, NULL if the function has not been translated
+ * @param RegisterSize The size in bytes of the register form of the body
+ * @param NativeBody The machine code of the function, NULL if the function has not been compiled
+ * @param ThreadedBody The threaded code of the function, NULL if the function has not been threaded
+ * @param Code The bytecode the stack interpreter runs when the function is called, the body of the current tier
+ * @param Calls The number of times the function has been called by the stack interpreter
+ * @param BackEdges The number of backward branches the stack interpreter has taken in the function
+ * @param Tier The tier of the function, 0 for the linked body
+ * @param Leaf The function makes no calls and no system calls and is called directly only by its own module, so its 
+ * calls and returns keep the pools of the caller and the stack interpreter keeps the link to the caller in registers
+ * @param Generator The function is the body of the generators of a GEN_NEW, it runs only from a resume and it is the
+ * only kind of function that can yield
  */
 typedef struct _FunctionHeader
 {
@@ -54,6 +73,17 @@ typedef struct _FunctionHeader
     u16 LWC;
     u16 SWC;
     u16 RWC;
+    u32 Size;
+    u8 *RegisterBody;
+    u32 RegisterSize;
+    void *NativeBody;
+    void *ThreadedBody;
+    u8  *Code;
+    u32  Calls;
+    u32  BackEdges;
+    u8   Tier;
+    bool Leaf;
+    bool Generator;
 } FunctionHeader;
 
 /**
@@ -66,30 +96,204 @@ typedef struct _Function
     u8 Body[];
 } Function;
 
+/**
+ * @brief The options the program has been started with.
+ * 
+ * @param Fusion Enables the superinstruction fusion pass of the linker
+ * @param TailCalls Enables the rewriting of the calls followed by a return into tail calls
+ * @param Register Translates the functions to the register form and runs them with the register interpreter
+ * @param Jit Compiles the register form of the functions to machine code and runs it
+ * @param Threaded Pre-decodes the register form of the functions to threaded code and runs it
+ * @param Tiering Defers the fusion pass to run time, where it is applied only to the functions that get hot
+ * @param Stats Prints the execution statistics when the program ends
+ * @param AlignedFrames Pads the locals of the functions to an even number of words, see linker/linker.c
+ * @param TierCalls The number of calls that promotes a function to the next tier
+ * @param TierLoops The number of backward branches that promotes a function to the next tier
+ * @param StackSize The initial size in words of the stack
+ * @param StackMaxSize The size in words the stack can grow to
+ * @param Fuel The calls and backward branches the stack interpreter runs before it suspends the program, 0 never suspends
+ * @param Workers The number of OS threads that run the green threads and the parallel loops of the program, 0 starts one
+ *        for each core
+ */
+typedef struct _ProgramOptions
+{
+    bool Fusion;
+    bool TailCalls;
+    bool Register;
+    bool Jit;
+    bool Threaded;
+    bool Tiering;
+    bool Stats;
+    bool AlignedFrames;
+    u32  TierCalls;
+    u32  TierLoops;
+    sz   StackSize;
+    sz   StackMaxSize;
+    u32  Fuel;
+    u32  Workers;
+} ProgramOptions;
+
+static inline void ProgramOptions_Init(ProgramOptions *options)
+{
+    options->Fusion    = true;
+    options->TailCalls = true;
+    options->Register  = false;
+    options->Jit       = false;
+    options->Threaded  = false;
+    options->Tiering   = false;
+    options->Stats     = false;
+    options->AlignedFrames = false;
+    options->TierCalls = 1000;
+    options->TierLoops = 10000;
+    options->StackSize    = 1 << 14;
+    options->StackMaxSize = 1 << 24;
+    options->Fuel         = 0;
+    options->Workers      = 0;
+}
+
+/**
+ * @brief The reason a function has been promoted to the next tier.
+ */
+typedef enum _TierReason
+{
+    TIER_REASON_CALLS, // the call counter reached the threshold
+    TIER_REASON_LOOPS  // the back edge counter reached the threshold, the running activation moved to the new body
+} TierReason;
+
+/**
+ * @brief A promotion of a function to the next tier, owns the promoted body.
+ * 
+ * @param Header The header of the promoted function
+ * @param Code The body of the new tier
+ * @param Size The size in bytes of the body of the new tier
+ * @param Calls The call counter at the time of the promotion
+ * @param BackEdges The back edge counter at the time of the promotion
+ * @param Fused The number of superinstructions of the new body
+ * @param Reason The counter that triggered the promotion
+ */
+typedef struct _TierEvent
+{
+    FunctionHeader *Header;
+    u8  *Code;
+    u32  Size;
+    u32  Calls;
+    u32  BackEdges;
+    u32  Fused;
+    TierReason Reason;
+} TierEvent;
+static inline void TierEvent_Destroy(TierEvent *event) { free(event->Code); }
+
+#define LIST_T TierEvent
+#define LIST_T_DTOR TierEvent_Destroy
+#include "raiu/list.h"
+
+#define INLINE_CACHE_WAYS 4
+
+/**
+ * @brief The registers of a suspended program, the stack interpreter saves them when it runs out of fuel and resumes 
+ * from them the next time it is called. The suspension happens only between two instructions with no cached words,
+ * so the stack in memory is the whole state.
+ * 
+ * @param PC The next instruction, NULL if the program is not suspended
+ * @param SP The stack pointer
+ * @param FP The frame pointer
+ * @param FH The header of the running function
+ */
+typedef struct _ExecutionState
+{
+    Byte *PC;
+    Word *SP;
+    Word *FP;
+    FunctionHeader *FH;
+} ExecutionState;
+
+/**
+ * @brief A target remembered by an inline cache, with the frame sizes and the module the call needs.
+ */
+typedef struct _InlineCacheEntry
+{
+    FunctionHeader    *Target;
+    const ModuleTable *MT;
+    u16 AWC;
+    u16 LWC;
+    u16 SWC;
+} InlineCacheEntry;
+
+/**
+ * @brief The inline cache of an indirect call site, the first entry is the monomorphic one checked inline by the 
+ * interpreter, the others make the cache polymorphic and are replaced in round robin once all are taken.
+ * 
+ * @param Site The address of the call site, NULL if the cache has never been used
+ * @param Caller The header of the function that contains the call site
+ * @param Hits The number of calls that found their target in the cache
+ * @param Misses The number of calls that had to fill an entry
+ * @param Count The number of entries in use
+ * @param Next The entry replaced by the next miss once all the entries are in use
+ * @param Entries The cached targets
+ */
+typedef struct _InlineCache
+{
+    const u8 *Site;
+    FunctionHeader *Caller;
+    u32 Hits;
+    u32 Misses;
+    u8  Count;
+    u8  Next;
+    InlineCacheEntry Entries[INLINE_CACHE_WAYS];
+} InlineCache;
+
 /**
  * @brief The program context is the root that contains all the data buffers of the program, therefore is responsible for the 
  * creation and delition of them
  * 
  * @param EntryPoint A reference to the header of the main function, this is used only at startup
  * @param StackBottom The stack buffer
- * @param StackTop The upper limit of the stack
+ * @param StackTop The upper limit of the stack, it grows up to the stack limit
+ * @param StackLimit The size the stack can grow to
  * @param WordsBuffer The global word buffer
  * @param DWordsBuffer The global dword buffer
  * @param FunctionsBuffer The global functions buffer
  * @param StringsBuffer The global string buffer
  * @param GlobalsBuffer The global data buffer
  * @param ModuleTablesBuffer The buffer of all module metadata tables
+ * @param RegisterBodiesBuffer The buffer of the register form of all functions
+ * @param JitCodeBuffer The executable buffer of the machine code of all functions
+ * @param ThreadedCodeBuffer The buffer of the threaded code of all functions
  * @param WordsBufferSize The size in words of the word buffer
  * @param DWordsBufferSize The size in double words of the dword buffer
  * @param FunctionsBufferSize The size in bytes of the function buffer
  * @param GlobalsBufferSize The size in bytes ot the global buffer
  * @param MouduleTableSize The amount of modules that the program has loaded
+ * @param RegisterBodiesBufferSize The size in bytes of the register bodies buffer
+ * @param JitCodeBufferSize The size in bytes of the jit code buffer
+ * @param ThreadedCodeBufferSize The size in bytes of the threaded code buffer
+ * @param Options The options the program has been started with
+ * @param TierEvents The promotions of the functions to the next tier, in the order they happened
+ * @param InlineCaches The inline caches of the indirect call sites, a table addressed by the hash of the site address
+ * @param InlineCachesBits The base 2 logarithm of the number of inline caches
+ * @param Suspended The registers of the program if it ran out of fuel
+ * @param Slices The number of times the program has been resumed after running out of fuel
+ * @param SpawnsThreads The program uses the green thread system calls, only the scheduler can run it
+ * @param Scheduler The scheduler of the green threads, NULL if the program does not run under it
+ * @param Worker The index of the worker a context runs on, each worker has a copy of the context of the program
+ * @param Joining The thread the running one waits for, set by the stack interpreter when a join suspends it
+ * @param Spawned The number of green threads the program has spawned
+ * @param Steals The number of green threads a worker has taken from the deque of another one
+ * @param ThreadLocals The thread-local globals of the thread that runs the context, every thread has a copy of them 
+ *        laid out like the globals buffer. The module files give no initial values, so a copy starts zeroed
+ * @param ThreadLocalsSize The size in bytes of a copy of the thread-local globals
+ * @param ParallelFor The program uses the parallel loop system call, it starts a pool of workers before it runs
+ * @param Pool The workers that run the chunks of the parallel loops, shared by the copies of the context
+ * @param Loop The parallel loop a context runs the chunks of
+ * @param LoopStack The stack the chunks of the loop are called on, the one of a pool worker or the free words above the 
+ *        operand stack of the thread that runs the loop
  */
 typedef struct _ProgramContext
 {
     Function *EntryPoint;
     Word *StackBottom; // need to be freed
     Word *StackTop;
+    Word *StackLimit;
 
     // data buffers (need to be freed)
     Word  *WordsBuffer;
@@ -98,6 +302,9 @@ typedef struct _ProgramContext
     Byte  *StringsBuffer;
     Byte  *GlobalsBuffer;
     ModuleTable *ModuleTablesBuffer;
+    u8          *RegisterBodiesBuffer;
+    u8          *JitCodeBuffer;
+    void        *ThreadedCodeBuffer;
 
     sz WordsBufferSize;
     sz DWordsBufferSize;
@@ -105,15 +312,41 @@ typedef struct _ProgramContext
     sz FunctionsBufferSize;
     sz GlobalsBufferSize;
     sz ModuleTablesBufferSize;
+    sz RegisterBodiesBufferSize;
+    sz JitCodeBufferSize;
+    sz ThreadedCodeBufferSize;
 
     Byte *DebugStringsBuffer;
     sz    DebugStringsBufferSize;
+
+    ProgramOptions Options;
+    List_TierEvent TierEvents;
+    InlineCache   *InlineCaches; // need to be freed
+    u32            InlineCachesBits;
+    ExecutionState Suspended;
+    u32            Slices;
+
+    bool                 SpawnsThreads;
+    struct _Scheduler   *Scheduler;
+    u32                  Worker;
+    struct _GreenThread *Joining;
+    u32                  Spawned;
+    u32                  Steals;
+
+    Byte *ThreadLocals; // need to be freed
+    sz    ThreadLocalsSize;
+
+    bool                  ParallelFor;
+    struct _WorkerPool   *Pool;
+    struct _ParallelLoop *Loop;
+    Word                 *LoopStack;
 } ProgramContext;
 
 static inline void ProgramContext_Init(ProgramContext *context)
 {
     context->StackBottom = NULL;
     context->StackTop    = NULL;
+    context->StackLimit  = NULL;
     context->EntryPoint  = NULL;
     context->WordsBuffer        = NULL;
     context->DWordsBuffer       = NULL;
@@ -121,10 +354,42 @@ static inline void ProgramContext_Init(ProgramContext *context)
     context->FunctionsBuffer    = NULL;
     context->GlobalsBuffer      = NULL;
     context->ModuleTablesBuffer = NULL;
+    context->RegisterBodiesBuffer = NULL;
+    context->JitCodeBuffer        = NULL;
+    context->ThreadedCodeBuffer   = NULL;
     context->WordsBufferSize        = 0;
     context->DWordsBufferSize       = 0;
     context->StringsBufferSize      = 0;
     context->FunctionsBufferSize    = 0;
     context->GlobalsBufferSize      = 0;
     context->ModuleTablesBufferSize = 0;
+    context->RegisterBodiesBufferSize = 0;
+    context->JitCodeBufferSize        = 0;
+    context->ThreadedCodeBufferSize   = 0;
+    ProgramOptions_Init(&context->Options);
+    List_TierEvent_Create(&context->TierEvents);
+    context->InlineCaches     = NULL;
+    context->InlineCachesBits = 0;
+    context->Suspended = (ExecutionState){ NULL, NULL, NULL, NULL };
+    context->Slices    = 0;
+    context->SpawnsThreads = false;
+    context->Scheduler     = NULL;
+    context->Worker        = 0;
+    context->Joining       = NULL;
+    context->Spawned       = 0;
+    context->Steals        = 0;
+    context->ThreadLocals     = NULL;
+    context->ThreadLocalsSize = 0;
+    context->ParallelFor = false;
+    context->Pool        = NULL;
+    context->Loop        = NULL;
+    context->LoopStack   = NULL;
+}
+
+/**
+ * @brief Returns the inline cache an indirect call site hashes to, the cache of the site if no other site took it first.
+ */
+static inline InlineCache *InlineCacheOf(const ProgramContext *context, const void *site)
+{
+    return context->InlineCaches + (((u64)site * 0x9E3779B97F4A7C15ULL) >> (64 - context->InlineCachesBits));
 }
@@ -1,20 +1,127 @@
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 #include <time.h>
 #include "rvm.h"
 #include "raiu/log.h"
 
+static void iPrintUsage(const char *program)
+{
+    printf("Usage: .%s [options] <header>\n", program);
+    printf("Options:\n");
+    printf("  --no-fusion    Disables the superinstruction fusion pass\n");
+    printf("  --no-tailcalls Keeps the calls followed by a return as calls\n");
+    printf("  --register     Runs the register form of the functions\n");
+    printf("  --jit          Compiles the functions to machine code before running them, the whole program runs on an\n");
+    printf("                 interpreter if one of them cannot be translated to the register form or compiled\n");
+    printf("  --threaded     Runs the pre-decoded threaded code of the functions\n");
+    printf("  --tiering      Fuses the functions at run time when they get hot\n");
+    printf("  --tier-calls N Number of calls that promotes a function (default 1000)\n");
+    printf("  --tier-loops N Number of backward branches that promotes a function (default 10000)\n");
+    printf("  --stack-size N Initial size of the stack in KiB (default 64)\n");
+    printf("  --stack-max N  Size in KiB the stack can grow to (default 65536)\n");
+    printf("  --aligned      Pads the locals of every frame to an even number of words, it aligns the frame base and\n");
+    printf("                 the dwords at even local indices, not the ones at odd indices\n");
+    printf("  --fuel N       Suspends and resumes the program every N calls and backward branches\n");
+    printf("  --workers N    Number of OS threads that run the green threads and parallel loops (default one per core)\n");
+    printf("  --stats        Prints the execution statistics at exit\n");
+}
+
+static void iPrintStats(const ProgramContext *context)
+{
+    if(context->Options.Fuel || context->SpawnsThreads)
+        printf("Fuel suspensions : %u\n", context->Slices);
+    if(context->SpawnsThreads)
+        printf("Green threads : %u spawned, %u stolen\n", context->Spawned, context->Steals);
+    printf("Tier promotions : %u\n", context->TierEvents.Count);
+    for (u32 i = 0; i < context->TierEvents.Count; i++)
+    {
+        const TierEvent *event = List_TierEvent_AtRO(&context->TierEvents, i);
+        printf("  %s : tier %u on %s after %u calls and %u back edges, %u superinstructions, %u -> %u bytes\n",
+            event->Header->Signature, event->Header->Tier, event->Reason == TIER_REASON_CALLS ? "calls" : "loops",
+            event->Calls, event->BackEdges, event->Fused, event->Header->Size, event->Size);
+    }
+
+    u64 hits = 0, misses = 0;
+    for (u32 i = 0; i < (1U << context->InlineCachesBits); i++)
+    {
+        hits   += context->InlineCaches[i].Hits;
+        misses += context->InlineCaches[i].Misses;
+    }
+    printf("Inline caches : %lu hits, %lu misses\n", hits, misses);
+    for (u32 i = 0; i < (1U << context->InlineCachesBits); i++)
+    {
+        const InlineCache *cache = context->InlineCaches + i;
+        if(cache->Site)
+            printf("  %s : %u targets, %u hits, %u misses\n", cache->Caller->Signature, cache->Count, cache->Hits, cache->Misses);
+    }
+}
+
 int main(int argc, char **argv)
 {
-    if(argc > 2)
+    ProgramOptions options;
+    ProgramOptions_Init(&options);
+
+    const char *root = NULL;
+    for (int i = 1; i < argc; i++)
     {
-        printf("Usage: .%s <header>\n", argv[0]);
-        return -1;
+        if(strcmp(argv[i], "--no-fusion") == 0)
+            options.Fusion = false;
+        else if(strcmp(argv[i], "--no-tailcalls") == 0)
+            options.TailCalls = false;
+        else if(strcmp(argv[i], "--register") == 0)
+            options.Register = true;
+        else if(strcmp(argv[i], "--jit") == 0)
+            options.Jit = true;
+        else if(strcmp(argv[i], "--threaded") == 0)
+            options.Threaded = true;
+        else if(strcmp(argv[i], "--tiering") == 0)
+            options.Tiering = true;
+        else if(strcmp(argv[i], "--stats") == 0)
+            options.Stats = true;
+        else if(strcmp(argv[i], "--aligned") == 0)
+            options.AlignedFrames = true;
+        else if((strcmp(argv[i], "--tier-calls") == 0 || strcmp(argv[i], "--tier-loops") == 0) && i + 1 < argc && atoi(argv[i + 1]) > 0)
+        {
+            u32 threshold = (u32)atoi(argv[i + 1]);
+            if(argv[i][7] == 'c')
+                options.TierCalls = threshold;
+            else
+                options.TierLoops = threshold;
+            i++;
+        }
+        else if((strcmp(argv[i], "--stack-size") == 0 || strcmp(argv[i], "--stack-max") == 0) && i + 1 < argc && atoi(argv[i + 1]) > 0)
+        {
+            sz words = (sz)atoi(argv[i + 1]) * 1024 / SIZEOF_WORD;
+            if(argv[i][8] == 's')
+                options.StackSize = words;
+            else
+                options.StackMaxSize = words;
+            i++;
+        }
+        else if(strcmp(argv[i], "--fuel") == 0 && i + 1 < argc && atoi(argv[i + 1]) > 0)
+        {
+            options.Fuel = (u32)atoi(argv[i + 1]);
+            i++;
+        }
+        else if(strcmp(argv[i], "--workers") == 0 && i + 1 < argc && atoi(argv[i + 1]) > 0)
+        {
+            options.Workers = (u32)atoi(argv[i + 1]);
+            i++;
+        }
+        else if(argv[i][0] != '-' && root == NULL)
+            root = argv[i];
+        else
+        {
+            iPrintUsage(argv[0]);
+            return -1;
+        }
     }
 
     String rootpath;
-    String_Create(&rootpath, argc == 1 ? "DummyProject" : argv[1]);
+    String_Create(&rootpath, root == NULL ? "DummyProject" : root);
 
-    i32 returnValue = Run(&rootpath);
+    i32 returnValue = Run(&rootpath, &options);
     printf("Program exited with code %d\n", returnValue);
     
 
@@ -22,19 +129,44 @@ int main(int argc, char **argv)
     return returnValue;
 }
 
-i32 Run(const String *rootpath)
+i32 Run(const String *rootpath, const ProgramOptions *options)
 {
     i32 ret = 0;
     ProgramContext context;
     ProgramContext_Init(&context);
+    context.Options = *options;
     i32 linkError = Link(&context, rootpath);
     if(!linkError)
     {
         LOG_INFO("Linking successful!");
         clock_t t0 = clock();
-        ret = Execute(&context);
+        if(context.ParallelFor)
+            context.Pool = CreatePool(&context);
+        if(context.Options.Jit)
+            ret = ExecuteGuarded(&context, ExecuteJit);
+        else if(context.Options.Threaded)
+            ret = ExecuteGuarded(&context, ExecuteThreaded);
+        else if(context.Options.Register)
+            ret = ExecuteGuarded(&context, ExecuteRegister);
+        else if(context.SpawnsThreads)
+            ret = RunThreads(&context);
+        else if(context.Options.Fuel)
+        {
+            // a host would run other work between the slices
+            do
+                ret = ExecuteGuarded(&context, ExecuteFueled);
+            while (context.Suspended.PC);
+        }
+        else if(context.Options.Tiering)
+            ret = ExecuteGuarded(&context, ExecuteTiered);
+        else
+            ret = ExecuteGuarded(&context, Execute);
+        DestroyPool(context.Pool);
+        context.Pool = NULL;
         clock_t t1 = clock();
         printf("Time elapsed : %ld us\n", t1 - t0);
+        if(context.Options.Stats)
+            iPrintStats(&context);
     }
     else
         ret = linkError;
@@ -5,8 +5,50 @@
 #include "metadata.h"
 
 i32 Link(ProgramContext *context, const String *rootpath);
+// runs the stack interpreter from the entry point, or from the registers in context->Suspended if they are set. It keeps
+// its state in the context, so every thread can run it with a context of its own
 i32 Execute(ProgramContext *context);
+i32 ExecuteRegister(ProgramContext *context);
+i32 ExecuteJit(ProgramContext *context);
+i32 ExecuteThreaded(ProgramContext *context);
+// runs the stack interpreter until the program ends or burns the fuel of the options on calls and backward branches, then
+// it saves the registers in context->Suspended and returns EXECUTE_SUSPENDED, the next call resumes from them. A green
+// thread that yields or joins a running one is suspended the same way
+i32 ExecuteFueled(ProgramContext *context);
+#define EXECUTE_SUSPENDED INT32_MIN
+// runs the stack interpreter like Execute, it also counts the calls and the backward branches of the functions and
+// promotes the ones that get hot
+i32 ExecuteTiered(ProgramContext *context);
+// the handlers of the threaded code indexed by the opcodes of the register form
+const void *const *ThreadedHandlers(void);
+
+// promotes a function to the next tier, pc is moved to the new body if it points in the running one
+Byte *TierUp(ProgramContext *context, FunctionHeader *header, TierReason reason, Byte *pc);
 
 void Unlink(ProgramContext *context);
 
-i32 Run(const String *rootpath);
\ No newline at end of file
+// the stack is a reserved mapping that grows from words to maxWords, followed by a guard region that catches the overflows
+bool MapStack(ProgramContext *context, sz words, sz maxWords);
+void UnmapStack(ProgramContext *context);
+// grows the stack so that it holds the address, returns false if the address is not between the top and the limit
+bool GrowStack(ProgramContext *context, const void *address);
+// runs an engine, a stack overflow ends it with -1, an engine can run another one guarded on the same thread
+i32  ExecuteGuarded(ProgramContext *context, i32 (*execute)(ProgramContext *context));
+
+// runs a program that spawns green threads on the workers of the options, it ends when the main thread ends
+i32  RunThreads(ProgramContext *context);
+// queues a green thread that runs the function with the argument, NULL if the function does not take a dword and return
+// a word
+struct _GreenThread *SpawnThread(ProgramContext *context, FunctionHeader *header, DWord argument);
+// returns true and sets the result if the thread has ended, a NULL thread has ended with -1
+bool ThreadResult(struct _GreenThread *thread, i32 *result);
+
+// starts the OS threads that run the parallel loops of a program with a stack each, NULL if there are none to start
+struct _WorkerPool *CreatePool(ProgramContext *context);
+void DestroyPool(struct _WorkerPool *pool);
+// calls the function on every chunk of grain indices of [begin, end) and returns when all of them have ended, the thread
+// that runs the loop calls its chunks on the stack from sp. Returns -1 if the function does not take two words and return
+// nothing or a chunk has overflowed its stack, 0 otherwise
+i32  ParallelFor(ProgramContext *context, FunctionHeader *header, i32 begin, i32 end, i32 grain, Word *sp);
+
+i32 Run(const String *rootpath, const ProgramOptions *options);
\ No newline at end of file